@@ -52,7 +52,7 @@ append_rel() {
       while IFS= read -r abs; do
         [[ -z "$abs" ]] && continue
         case "$abs" in
-          *.h|*.hpp) ;;
+          *.h|*.hh|*.hpp|*.hxx|*.inl) ;;
           *) continue ;;
         esac
         # Convert absolute -> repo-relative
@@ -69,7 +69,7 @@ append_rel() {
       while IFS= read -r abs; do
         [[ -z "$abs" ]] && continue
         case "$abs" in
-          *.h|*.hpp) ;;
+          *.h|*.hh|*.hpp|*.hxx|*.inl) ;;
           *) continue ;;
         esac
         if [[ "$abs" == "$HEAD_PATH/"* ]]; then
@@ -83,7 +83,7 @@ append_rel() {
     # 3) Explicit file (relative to HEAD_PATH)
     if [[ -f "$HEAD_PATH/$patt" ]]; then
       case "$patt" in
-        *.h|*.hpp)
+        *.h|*.hh|*.hpp|*.hxx|*.inl)
           printf '%s\n' "$patt" >>"$out"
           [[ "$TRACE_PATTERNS" == "1" ]] && printf '  -> %s\n' "$patt" >&2
           ;;
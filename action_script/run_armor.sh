@@ -9,6 +9,10 @@ set -euo pipefail
 # Usage:
 #   run_armor.sh <BASE_PATH> <HEAD_PATH> <INTERSECTION_HEADERS_PATH> <ARMOR_BINS_PATH?>
 #
+# With BASE_SHA set, HEAD_PATH must be a clone holding both commits and BASE_PATH
+# may be empty: armor reads both revisions from its object store (--git-repo).
+# Otherwise BASE_PATH and HEAD_PATH are checkouts of the two versions.
+#
 # Environment (optional):
 #   PROJECT, BRANCH, GITHUB_EVENT, PR_NUMBER, HEADER_DIR, INCLUDE_PATHS, MACRO_FLAGS,
 #   REPORT_FORMAT=json, LOG_LEVEL, DUMP_AST_DIFF, ARMOR_CMD, HEAD_SHA, BASE_SHA
@@ -19,8 +23,8 @@ warn() { printf "\033[1;33m[WARN]\033[0m %s\n" "$*" >&2; }
 die()  { printf "\033[1;31m[ERR]\033[0m %s\n" "$*" >&2; exit 1; }
 
 BASE_PATH="${1:-}"; HEAD_PATH="${2:-}"; INTERSECTION_FILE="${3:-}"; ARMOR_BINS_PATH="${4:-}"
-[[ -d "$BASE_PATH" ]] || die "BASE_PATH not a directory"
 [[ -d "$HEAD_PATH" ]] || die "HEAD_PATH not a directory"
+[[ -n "${BASE_SHA:-}" || -d "$BASE_PATH" ]] || die "BASE_PATH not a directory and no BASE_SHA given"
 [[ -f "$INTERSECTION_FILE" ]] || die "Intersection file not found"
 
 PROJECT_URL="${PROJECT_URL:-unknown}"
@@ -56,18 +60,22 @@ mapfile -t HEADERS < <(grep -v '^[[:space:]]*$' "$INTERSECTION_FILE" || true)
 
 METADATA_NDJSON="${OUT_ROOT}/.headers.ndjson"; : > "$METADATA_NDJSON"
 
-for header in "${HEADERS[@]}"; do
-  hdr_arg="$header"; [[ -n "$HEADER_DIR" ]] && hdr_arg="$(basename "$header")"
-  safe="$(echo "$header" | sed 's/[^A-Za-z0-9_.-]/_/g')"
-  WORK_DIR="$(mktemp -d "${GITHUB_WORKSPACE}/.armor_${safe}.XXXXXX")"
-  pushd "$WORK_DIR" >/dev/null
-
-  args=(-r "$REPORT_FORMAT" --log-level "$LOG_LEVEL")
-  [[ "$DUMP_AST_DIFF" == "true" ]] && args+=(--dump-ast-diff)
-  [[ -n "$HEADER_DIR" ]] && args+=(--header-dir "$HEADER_DIR")
-  [[ -n "$INCLUDE_PATHS" ]] && args+=($INCLUDE_PATHS)
-  [[ -n "$MACRO_FLAGS" ]] && args+=(-m $MACRO_FLAGS)
-
+args=(-r "$REPORT_FORMAT" --log-level "$LOG_LEVEL")
+[[ "$DUMP_AST_DIFF" == "true" ]] && args+=(--dump-ast-diff)
+[[ -n "$HEADER_DIR" ]] && args+=(--header-dir "$HEADER_DIR")
+[[ -n "$INCLUDE_PATHS" ]] && args+=($INCLUDE_PATHS)
+[[ -n "$MACRO_FLAGS" ]] && args+=(-m $MACRO_FLAGS)
+
+if [[ -n "$BASE_SHA" ]]; then
+  # Headers missing from one revision are compared against an empty file by armor itself
+  log "Reading $BASE_SHA and $HEAD_SHA from $HEAD_PATH"
+  args+=(--git-repo "$HEAD_PATH" --old-rev "$BASE_SHA" --new-rev "$HEAD_SHA")
+  HEADERS_FOR_PLACEHOLDERS=()
+else
+  HEADERS_FOR_PLACEHOLDERS=("${HEADERS[@]}")
+fi
+
+for header in "${HEADERS_FOR_PLACEHOLDERS[@]}"; do
   base_header_path="$BASE_PATH/$header"
   if [[ ! -f "$base_header_path" ]]; then
     log "Base header missing; creating empty placeholder: $base_header_path"
@@ -81,12 +89,40 @@ for header in "${HEADERS[@]}"; do
     mkdir -p "$(dirname "$head_header_path")"
     : > "$head_header_path"
   fi
+done
+
+# Every header goes through a single armor run; report names are derived from
+# the header's path, so headers sharing a basename do not collide.
+RUN_DIR="${OUT_ROOT}/.armor_run"
+rm -rf "$RUN_DIR"; mkdir -p "$RUN_DIR"
+MANIFEST="$RUN_DIR/manifest.ndjson"; : > "$MANIFEST"
+for header in "${HEADERS[@]}"; do
+  hdr_arg="$header"; [[ -n "$HEADER_DIR" ]] && hdr_arg="$(basename "$header")"
+  jq -cn --arg header "$hdr_arg" '{header:$header}' >> "$MANIFEST"
+done
 
-  "$ARMOR_CMD" "${args[@]}" "$BASE_PATH" "$HEAD_PATH" "$hdr_arg" || warn "armor failed for $header"
+STATUS_FILE="$RUN_DIR/armor_reports/manifest_status.json"
+if [[ ${#HEADERS[@]} -gt 0 ]]; then
+  roots=("$BASE_PATH" "$HEAD_PATH"); [[ -n "$BASE_SHA" ]] && roots=()
+  "$ARMOR_CMD" "${args[@]}" --manifest "$MANIFEST" --output-dir "$RUN_DIR" "${roots[@]}" \
+    || log "armor compared no headers"
+  [[ -f "$STATUS_FILE" ]] || warn "armor failed"
+fi
+
+for header in "${HEADERS[@]}"; do
+  hdr_arg="$header"; [[ -n "$HEADER_DIR" ]] && hdr_arg="$(basename "$header")"
+  safe="$(echo "$header" | sed 's/[^A-Za-z0-9_.-]/_/g')"
+
+  json_report=""; html_report=""
+  if [[ -f "$STATUS_FILE" ]]; then
+    entry="$(jq -c --arg h "$hdr_arg" 'first(.headers[] | select(.header == $h)) // {}' "$STATUS_FILE")"
+    json_report="$(jq -r '.json_report // empty' <<<"$entry")"
+    html_report="$(jq -r '.html_report // empty' <<<"$entry")"
+    [[ "$(jq -r '.result // empty' <<<"$entry")" == "parse_errors" ]] && warn "armor reported parse errors for $header"
+  fi
 
-  json_report="$WORK_DIR/armor_reports/json_reports/api_diff_report_$(basename "$hdr_arg").json"
   api_names=(); compatibility="backward_compatible"
-  if [[ -f "$json_report" ]]; then
+  if [[ -n "$json_report" && -f "$json_report" ]]; then
     while IFS= read -r line; do
       comp="$(jq -r '.compatibility' <<<"$line")"
       name="$(jq -r '.name' <<<"$line")"
@@ -107,12 +143,20 @@ for header in "${HEADERS[@]}"; do
     [[ -f "$NONBLOCKING_FILE" && -s "$NONBLOCKING_FILE" ]] && grep -Fxq "$header" "$NONBLOCKING_FILE" && echo "$header" >> "$INCOMPATIBLE_NONBLOCKING"
   fi
 
+  # Per-header artifacts keep the layout of a standalone armor run
   dest="${OUT_ROOT}/${safe}"
-  mkdir -p "$dest"
-  tar -cf - . 2>/dev/null | tar -xf - -C "$dest" 2>/dev/null || true
-  popd >/dev/null; rm -rf "$WORK_DIR"
+  mkdir -p "$dest/armor_reports/html_reports" "$dest/armor_reports/json_reports"
+  [[ -n "$html_report" && -f "$html_report" ]] && cp "$html_report" "$dest/armor_reports/html_reports/"
+  [[ -n "$json_report" && -f "$json_report" ]] && cp "$json_report" "$dest/armor_reports/json_reports/"
 done
 
+if [[ -d "$RUN_DIR/debug_output" ]]; then
+  rm -rf "${OUT_ROOT}/debug_output"
+  mv "$RUN_DIR/debug_output" "${OUT_ROOT}/debug_output"
+fi
+[[ -f "$STATUS_FILE" ]] && cp "$STATUS_FILE" "${OUT_ROOT}/manifest_status.json"
+rm -rf "$RUN_DIR"
+
 sort -u -o "$INCOMPATIBLE_BLOCKING" "$INCOMPATIBLE_BLOCKING"
 sort -u -o "$INCOMPATIBLE_NONBLOCKING" "$INCOMPATIBLE_NONBLOCKING"
 
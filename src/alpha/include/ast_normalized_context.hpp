@@ -3,9 +3,14 @@
 #pragma once
 
 #include "node.hpp"
+#include "string_pool.hpp"
 #include "clang/AST/ASTContext.h"
+#include <memory>
 #include <llvm-14/llvm/ADT/StringRef.h>
+#include <llvm-14/llvm/ADT/SmallVector.h>
+#include <llvm-14/llvm/ADT/StringMap.h>
 #include <llvm-14/llvm/ADT/StringSet.h>
+#include <llvm-14/llvm/Support/Allocator.h>
 
 /**
  * @class ASTNormalizedContext
@@ -21,6 +26,11 @@
  * 2. A vector (`rootApiNodes`) of nodes that are considered top-level or
  *    "root" elements of the API (e.g., free functions, global variables, or
  *    classes in the global namespace).
+ *
+ * Every node is allocated from the context's arena by createNode and freed
+ * with it in one go; the maps only hold plain pointers into it. The strings
+ * of the nodes are interned in a StringPool the context shares with the
+ * contexts it is compared against.
  */
 namespace alpha{
 
@@ -30,7 +40,24 @@ public:
     /**
      * @brief Constructs an empty ASTNormalizedContext.
      */
-    ASTNormalizedContext();
+    explicit ASTNormalizedContext(std::shared_ptr<StringPool> strings);
+
+    // Nodes point into the arena, so a context is neither copied nor moved
+    ASTNormalizedContext(const ASTNormalizedContext&) = delete;
+    ASTNormalizedContext& operator=(const ASTNormalizedContext&) = delete;
+
+    /**
+     * @brief Allocates an empty node owned by this context.
+     */
+    APINode* createNode();
+
+    /**
+     * @brief Returns the pooled copy of str, to be stored in a node of this context.
+     */
+    llvm::StringRef intern(llvm::StringRef str) { return strings->intern(str); }
+
+    // The pool stays alive as long as any context using it
+    const std::shared_ptr<StringPool>& stringPool() const { return strings; }
 
     /**
      * @brief Adds a new node to the normalized tree.
@@ -39,26 +66,26 @@ public:
      * Use addOrUpdateNode if overwriting is desired.
      *
      * @param key The unique string identifier for the node (e.g., USR).
-     * @param node A shared pointer to the APINode.
+     * @param node A node created by this context.
      */
-    void addNode(llvm::StringRef key,const std::shared_ptr<const APINode> node);
+    void addNode(llvm::StringRef key, const APINode* node);
 
     /**
      * @brief Adds a node to the list of root API nodes.
      *
-     * @param rootNode A const shared pointer to the APINode.
+     * @param rootNode A node created by this context.
      */
-    void addRootNode(const std::shared_ptr<const APINode> rootNode);
+    void addRootNode(const APINode* rootNode);
 
     /**
      * @brief Returns a const reference to the entire normalized tree map.
      */
-    const llvm::StringMap<std::shared_ptr<const APINode>>& getTree() const;
+    const llvm::StringMap<const APINode*>& getTree() const;
 
     /**
      * @brief Returns a const reference to the list of root API nodes.
      */
-    const llvm::SmallVector<std::shared_ptr<const APINode>,64>& getRootNodes() const;
+    const llvm::SmallVector<const APINode*,64>& getRootNodes() const;
 
     /**
      * @brief Checks if the context contains any nodes.
@@ -79,8 +106,11 @@ public:
     llvm::StringSet<> hashSet;
 
 private:
-    llvm::StringMap<std::shared_ptr<const APINode>> apiNodesMap;
-    llvm::SmallVector<std::shared_ptr<const APINode>,64> apiNodes;
+    std::shared_ptr<StringPool> strings;
+    // Nodes hold no owning members, so the arena is freed without visiting them
+    llvm::BumpPtrAllocator nodeArena;
+    llvm::StringMap<const APINode*> apiNodesMap;
+    llvm::SmallVector<const APINode*,64> apiNodes;
 
     clang::ASTContext* clangContext;
 };
@@ -3,30 +3,69 @@
 
 #pragma once
 
-#include <llvm-14/llvm/ADT/SmallString.h>
-#include <llvm/ADT/SmallVector.h>
-#include <llvm/ADT/StringMap.h>
+#include <cassert>
+#include <cstddef>
+#include <iterator>
+#include <llvm/ADT/StringRef.h>
+#include <llvm/ADT/iterator_range.h>
 
 #include "comm_def.hpp"
 #include "nlohmann/json.hpp"
 #include "nlohmann/json_fwd.hpp"
+#include "string_pool.hpp"
 
 // Main Node structure
-// string can be optimized by string_view powered by stringRef
 
 namespace alpha{
 
+// Strings are interned in the StringPool of the node's ASTNormalizedContext;
+// compare them with sameInterned.
 struct APINode {
     NodeKind kind = NodeKind::Unknown;
-    std::string hash;
-    std::string qualifiedName;
-    std::string dataType;         // Underlying datatype of variables .... (int/float/...)
+    llvm::StringRef hash;
+    llvm::StringRef qualifiedName;
+    llvm::StringRef dataType;         // Underlying datatype of variables .... (int/float/...)
     APINodeStorageClass storage = APINodeStorageClass::None;
     ConstQualifier constQualifier = ConstQualifier::None;
 
-    std::unique_ptr<llvm::SmallVector<std::shared_ptr<const APINode>,16>> children;
+    // Children in declaration order, linked through nextSibling. Nodes are owned
+    // by the arena of their ASTNormalizedContext and live as long as it does.
+    APINode* firstChild = nullptr;
+    APINode* lastChild = nullptr;
+    APINode* nextSibling = nullptr;
 
-    nlohmann::json diff(const std::shared_ptr<const APINode>& other) const;
+    class ChildIterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = const APINode*;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const APINode* const*;
+        using reference = const APINode*;
+
+        explicit ChildIterator(const APINode* node = nullptr) : m_node(node) {}
+        const APINode* operator*() const { return m_node; }
+        ChildIterator& operator++() { m_node = m_node->nextSibling; return *this; }
+        bool operator==(const ChildIterator& other) const { return m_node == other.m_node; }
+        bool operator!=(const ChildIterator& other) const { return m_node != other.m_node; }
+
+    private:
+        const APINode* m_node;
+    };
+
+    bool hasChildren() const { return firstChild != nullptr; }
+
+    llvm::iterator_range<ChildIterator> children() const {
+        return {ChildIterator(firstChild), ChildIterator()};
+    }
+
+    // A node is the child of one parent only
+    void appendChild(APINode* child) {
+        assert(child->nextSibling == nullptr && child != lastChild);
+        (lastChild ? lastChild->nextSibling : firstChild) = child;
+        lastChild = child;
+    }
+
+    nlohmann::json diff(const APINode* other) const;
 };
 
 }
\ No newline at end of file
@@ -25,7 +25,7 @@ class TreeBuilder {
 private:
     alpha::ASTNormalizedContext* context;
     StringBuilder qualifiedNames;
-    std::vector<std::shared_ptr<alpha::APINode>> nodeStack;
+    std::vector<alpha::APINode*> nodeStack;
 public:
     /**
      * @brief Constructs a TreeBuilder with the given context.
@@ -35,8 +35,8 @@ public:
     explicit TreeBuilder(alpha::ASTNormalizedContext* context);
 
     // Node management
-    void AddNode(const std::shared_ptr<alpha::APINode>& node);
-    void PushNode(const std::shared_ptr<alpha::APINode>& node);
+    void AddNode(alpha::APINode* node);
+    void PushNode(alpha::APINode* node);
     void PopNode();
 
     // Name management
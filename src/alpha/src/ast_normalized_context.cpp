@@ -3,24 +3,33 @@
 
 #include "node.hpp"
 #include "ast_normalized_context.hpp"
+#include <new>
+#include <type_traits>
+#include <utility>
 
-alpha::ASTNormalizedContext::ASTNormalizedContext() = default;
+static_assert(std::is_trivially_destructible_v<alpha::APINode>, "nodes are freed without running destructors");
 
-void alpha::ASTNormalizedContext::addNode(llvm::StringRef key, std::shared_ptr<const alpha::APINode> node) {
-    apiNodesMap.try_emplace(key, std::move(node));
+alpha::ASTNormalizedContext::ASTNormalizedContext(std::shared_ptr<StringPool> strings) : strings(std::move(strings)) {}
+
+alpha::APINode* alpha::ASTNormalizedContext::createNode() {
+    return new (nodeArena.Allocate<alpha::APINode>()) alpha::APINode();
+}
+
+void alpha::ASTNormalizedContext::addNode(llvm::StringRef key, const alpha::APINode* node) {
+    apiNodesMap.try_emplace(key, node);
 }
 
-void alpha::ASTNormalizedContext::addRootNode(std::shared_ptr<const alpha::APINode> rootNode) {
+void alpha::ASTNormalizedContext::addRootNode(const alpha::APINode* rootNode) {
     if (rootNode) {
-        apiNodes.push_back(std::move(rootNode));
+        apiNodes.push_back(rootNode);
     }
 }
 
-const llvm::StringMap<std::shared_ptr<const alpha::APINode>>& alpha::ASTNormalizedContext::getTree() const {
+const llvm::StringMap<const alpha::APINode*>& alpha::ASTNormalizedContext::getTree() const {
     return apiNodesMap;
 }
 
-const llvm::SmallVector<std::shared_ptr<const alpha::APINode>,64>& alpha::ASTNormalizedContext::getRootNodes() const {
+const llvm::SmallVector<const alpha::APINode*,64>& alpha::ASTNormalizedContext::getRootNodes() const {
     return apiNodes;
 }
 
@@ -31,6 +40,7 @@ bool alpha::ASTNormalizedContext::empty() const {
 void alpha::ASTNormalizedContext::clear() {
     apiNodesMap.clear();
     apiNodes.clear();
+    nodeArena.Reset();
 }
 
 void alpha::ASTNormalizedContext::addClangASTContext(clang::ASTContext *ASTContext){
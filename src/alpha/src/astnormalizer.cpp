@@ -5,6 +5,7 @@
 #include "node.hpp"
 #include "session.hpp"
 #include "tree_builder.hpp"
+#include "tree_builder_utils.hpp"
 #include "debug_config.hpp"
 #include <llvm-14/llvm/Support/raw_ostream.h>
 
@@ -23,7 +24,11 @@ void alpha::ASTNormalizeConsumer::HandleTranslationUnit(clang::ASTContext &clang
     // Creates the visitor, passing along the pointers to the session and the pre-existing context.
     context->addClangASTContext(&clangContext);
     alpha::ASTNormalize visitor(session, context, &clangContext);
+    // Descend only into the header's own top-level declarations; everything the
+    // include closure declares would be rejected by the tree builder anyway.
+    clangContext.setTraversalScope(getMainFileTopLevelDecls(clangContext));
     visitor.TraverseDecl(clangContext.getTranslationUnitDecl());
+    clangContext.setTraversalScope({clangContext.getTranslationUnitDecl()});
 }
 
 
@@ -1,6 +1,7 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <cassert>
 #include <iostream>
 #include <llvm/ADT/SmallVector.h>
 
@@ -10,30 +11,32 @@
 
 using json = nlohmann::json;
 
-auto byHash = [](const std::shared_ptr<const alpha::APINode>& node) -> const std::string& {
-    return node->hash;
+// Hashes are interned in one pool for both trees, so their data pointers are keys
+auto byHash = [](const alpha::APINode* node) -> const char* {
+    return node->hash.data();
 };
 
+using ChildRange = llvm::iterator_range<alpha::APINode::ChildIterator>;
+
 template<typename KeyFunc>
-std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>> intersection(
-    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& a,
-    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& b,
+std::vector<std::pair<const alpha::APINode*, const alpha::APINode*>> intersection(
+    ChildRange a,
+    ChildRange b,
     KeyFunc&& keyFunc
 ) {
-    std::unordered_multimap<std::string, std::shared_ptr<const alpha::APINode>> map_b;
-    map_b.reserve(b.size());
-    for (const auto& node : b) {
+    std::unordered_multimap<const char*, const alpha::APINode*> map_b;
+    for (const alpha::APINode* node : b) {
         map_b.emplace(keyFunc(node), node);
     }
 
-    std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>> result;
-    result.reserve(std::min(a.size(), b.size()));
+    std::vector<std::pair<const alpha::APINode*, const alpha::APINode*>> result;
+    result.reserve(map_b.size());
 
-    for (const auto& node_a : a) {
+    for (const alpha::APINode* node_a : a) {
         const auto& key = keyFunc(node_a);
         auto it = map_b.find(key);
         if (it != map_b.end()) {
-            result.emplace_back(node_a, std::move(it->second));
+            result.emplace_back(node_a, it->second);
             map_b.erase(it);
         }
     }
@@ -43,21 +46,19 @@ std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<con
 }
 
 template<typename KeyFunc>
-std::vector<std::shared_ptr<const alpha::APINode>> difference(
-    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& a,
-    const llvm::SmallVector<std::shared_ptr<const alpha::APINode>, 16>& b,
+std::vector<const alpha::APINode*> difference(
+    ChildRange a,
+    ChildRange b,
     KeyFunc&& keyFunc
 ) {
-    std::unordered_multimap<std::string, std::shared_ptr<const alpha::APINode>> map_b;
-    map_b.reserve(b.size());
-    for (const auto& node : b) {
+    std::unordered_multimap<const char*, const alpha::APINode*> map_b;
+    for (const alpha::APINode* node : b) {
         map_b.emplace(keyFunc(node), node);
     }
 
-    std::vector<std::shared_ptr<const alpha::APINode>> result;
-    result.reserve(std::min(a.size(), b.size()));
+    std::vector<const alpha::APINode*> result;
 
-    for (const auto& node : a) {
+    for (const alpha::APINode* node : a) {
         const auto& key = keyFunc(node);
         auto it = map_b.find(key);
         if (it != map_b.end()) {
@@ -70,35 +71,31 @@ std::vector<std::shared_ptr<const alpha::APINode>> difference(
     return result;
 }
 
-const bool inline checkLayoutChange(const  std::shared_ptr<const alpha::APINode> node){
+const bool inline checkLayoutChange(const alpha::APINode* node){
     return node->kind != NodeKind::Enum;
 }
 
-const bool inline hasChildren(const std::shared_ptr<const alpha::APINode>& node) {
-    return node->children == nullptr ? false : !node->children->empty();
-}
-
 namespace{
-    const json toJson(const std::shared_ptr<const alpha::APINode>& node) {
+    const json toJson(const alpha::APINode* node) {
     
         json json_node;
 
-        if(!node->qualifiedName.empty()) json_node[QUALIFIED_NAME] = node->qualifiedName;
+        if(!node->qualifiedName.empty()) json_node[QUALIFIED_NAME] = node->qualifiedName.str();
         json_node[NODE_TYPE] = serialize(node->kind);
 
-        if(hasChildren(node)) {
+        if(node->hasChildren()) {
             json_node[CHILDREN] = json::array();
-            for (const auto& childNode : *node->children) {
+            for (const alpha::APINode* childNode : node->children()) {
                 json_node[CHILDREN].emplace_back(toJson(childNode));
             }
         }
 
-        if(!node->dataType.empty()) json_node[DATA_TYPE] = node->dataType;
+        if(!node->dataType.empty()) json_node[DATA_TYPE] = node->dataType.str();
 
         return json_node;
     }
 
-    const json get_json_from_node(const std::shared_ptr<const alpha::APINode> node, const std::string& tag) {
+    const json get_json_from_node(const alpha::APINode* node, const std::string& tag) {
         json json_node = toJson(node);
         json_node[TAG] = tag;
         return json_node;
@@ -107,30 +104,30 @@ namespace{
 
 
 json diffNodes(
-    const std::shared_ptr<const alpha::APINode>& a, 
-    const std::shared_ptr<const alpha::APINode>& b
+    const alpha::APINode* a, 
+    const alpha::APINode* b
 ){
     
     // Any node can have children.
 
-    if ( hasChildren(a) && hasChildren(b) ) {
+    if ( a->hasChildren() && b->hasChildren() ) {
         
         json childrenDiff = json::array();
 
-        const std::vector<std::shared_ptr<const alpha::APINode>> removed_nodes = difference(
-            *a->children, 
-            *b->children,
+        const std::vector<const alpha::APINode*> removed_nodes = difference(
+            a->children(), 
+            b->children(),
             byHash
         );
-        const std::vector<std::shared_ptr<const alpha::APINode>> added_nodes = difference(
-            *b->children, 
-            *a->children,
+        const std::vector<const alpha::APINode*> added_nodes = difference(
+            b->children(), 
+            a->children(),
             byHash
         );
 
-        const std::vector<std::pair<std::shared_ptr<const alpha::APINode>, std::shared_ptr<const alpha::APINode>>> common_nodes = intersection(
-            *a->children, 
-            *b->children, 
+        const std::vector<std::pair<const alpha::APINode*, const alpha::APINode*>> common_nodes = intersection(
+            a->children(), 
+            b->children(), 
             byHash
         );
 
@@ -169,7 +166,7 @@ json diffNodes(
 
         if(!childrenDiff.empty()){
             json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
+            diff[QUALIFIED_NAME] = a->qualifiedName.str();
             diff[NODE_TYPE] = serialize(a->kind);
             if(!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
             diff[TAG] = MODIFIED;
@@ -190,13 +187,15 @@ json diffTrees(
 ) {
 
     json diffs = json::array();
-    llvm::StringMap<std::shared_ptr<const alpha::APINode>> tree1 = context1->getTree();
-    llvm::StringMap<std::shared_ptr<const alpha::APINode>> tree2 = context2->getTree();
+    const llvm::StringMap<const alpha::APINode*>& tree1 = context1->getTree();
+    const llvm::StringMap<const alpha::APINode*>& tree2 = context2->getTree();
+    // Strings of the two trees are compared by pointer
+    assert(context1->stringPool()->sharesStringsWith(*context2->stringPool()));
 
-    for (auto const &rootNode1 : context1->getRootNodes()) {
+    for (const alpha::APINode* rootNode1 : context1->getRootNodes()) {
 
         if(context1->excludeNodes.count(rootNode1->hash) || context2->excludeNodes.count(rootNode1->hash)){
-            DebugConfig::instance().log("Excluding : " + rootNode1->hash, DebugConfig::Level::INFO);
+            DebugConfig::instance().log("Excluding : " + rootNode1->hash.str(), DebugConfig::Level::INFO);
             continue;
         }
 
@@ -204,7 +203,7 @@ json diffTrees(
             diffs.emplace_back(get_json_from_node(rootNode1, REMOVED));
         }
         else {
-            const std::shared_ptr<const alpha::APINode> rootNode2 = tree2.find(rootNode1->hash)->second;
+            const alpha::APINode* rootNode2 = tree2.find(rootNode1->hash)->second;
             json sameScopeDiff = diffNodes(rootNode1, rootNode2);
             /*
                 Comparing nodes of same scope. No name conflicts for alpha::APINodes in same scope.
@@ -220,10 +219,10 @@ json diffTrees(
 
     }
 
-    for (const auto & rootNode2 : context2->getRootNodes()) {
+    for (const alpha::APINode* rootNode2 : context2->getRootNodes()) {
 
         if(context1->excludeNodes.count(rootNode2->hash) || context2->excludeNodes.count(rootNode2->hash)){
-            DebugConfig::instance().log("Excluding : " + rootNode2->hash, DebugConfig::Level::INFO);
+            DebugConfig::instance().log("Excluding : " + rootNode2->hash.str(), DebugConfig::Level::INFO);
             continue;
         }
 
@@ -4,13 +4,13 @@
 #include "diff_utils.hpp"
 #include "node.hpp"
 
-nlohmann::json alpha::APINode::diff(const std::shared_ptr<const alpha::APINode>& other) const {
+nlohmann::json alpha::APINode::diff(const alpha::APINode* other) const {
     nlohmann::json result, removed, added;
 
     // Helper to add metadata to a diff JSON node
     auto appendNodeMetadata  = [&](nlohmann::json& node) {
         node[NODE_TYPE] = serialize(kind);
-        node[QUALIFIED_NAME] = qualifiedName;
+        node[QUALIFIED_NAME] = qualifiedName.str();
     };
 
     // Define a lambda function to compare fields
@@ -25,9 +25,21 @@ nlohmann::json alpha::APINode::diff(const std::shared_ptr<const alpha::APINode>&
         }
     };
 
+    // Strings are interned, so equal ones are the same pointer
+    auto compareStrings = [&](const std::string& field, llvm::StringRef lhs, llvm::StringRef rhs) {
+        if (!sameInterned(lhs, rhs)) {
+            if (!lhs.empty()) {
+                removed[field] = lhs.str();
+            }
+            if (!rhs.empty()) {
+                added[field] = rhs.str();
+            }
+        }
+    };
+
     // Compare fields
     if(dataType != DATA_TYPE_PLACE_HOLDER && other->dataType != DATA_TYPE_PLACE_HOLDER){
-        compare(DATA_TYPE, dataType, other->dataType, std::string{});
+        compareStrings(DATA_TYPE, dataType, other->dataType);
     }
     compare(
         STORAGE_QUALIFIER,
@@ -58,7 +70,7 @@ nlohmann::json alpha::APINode::diff(const std::shared_ptr<const alpha::APINode>&
             }
         };
 
-        if (this->children == nullptr) {
+        if (!hasChildren()) {
             nlohmann::json children = nlohmann::json::array();
             processChanges(children);
 
@@ -23,22 +23,19 @@ inline bool alpha::TreeBuilder::IsFromMainFileAndNotLocal(const clang::Decl* Dec
     return clangContext->getSourceManager().isInMainFile(Decl->getLocation()) && Decl->getParentFunctionOrMethod() == nullptr;
 }
 
-inline void alpha::TreeBuilder::AddNode(const std::shared_ptr<APINode>& node) {
+inline void alpha::TreeBuilder::AddNode(APINode* node) {
 
     assert(!node->hash.empty());
 
     if (!nodeStack.empty()) {
-        if (nodeStack.back()->children == nullptr) {
-            nodeStack.back()->children = std::make_unique<llvm::SmallVector<std::shared_ptr<const APINode>, 16>>();
-        }
-        nodeStack.back()->children->push_back(node);
+        nodeStack.back()->appendChild(node);
     }
     else context->addRootNode(node);
     
     if (nodeStack.empty()) context->addNode(node->hash, node);
 }
 
-inline void alpha::TreeBuilder::PushNode(const std::shared_ptr<APINode>& node) {
+inline void alpha::TreeBuilder::PushNode(APINode* node) {
     nodeStack.push_back(node);
 }
 
@@ -61,25 +58,25 @@ inline const std::string alpha::TreeBuilder::GetCurrentQualifiedName() {
 }
 
 void alpha::TreeBuilder::BuildReturnTypeNode(clang::QualType type) {
-    auto returnNode = std::make_shared<APINode>();
+    auto returnNode = context->createNode();
     returnNode->kind = NodeKind::ReturnType;   
     PushName("(ReturnType)");
-    returnNode->dataType = type.getAsString();
-    returnNode->qualifiedName = GetCurrentQualifiedName();
-    returnNode->hash = generateHash(returnNode->qualifiedName, NodeKind::ReturnType);
+    returnNode->dataType = context->intern(type.getAsString());
+    returnNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+    returnNode->hash = context->intern(generateHash(returnNode->qualifiedName, NodeKind::ReturnType));
     AddNode(returnNode);
     PopName();
 
-    DebugConfig::instance().log("BuildReturnType : " + returnNode->dataType, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("BuildReturnType : " + returnNode->dataType.str(), DebugConfig::Level::DEBUG);
 }
 
 void alpha::TreeBuilder::normalizeFunctionPointerType(const std::string& dataType, clang::FunctionProtoTypeLoc FTL) {
     
-    auto functionPointerNode = std::make_shared<APINode>();
+    auto functionPointerNode = context->createNode();
     functionPointerNode->kind = NodeKind::FunctionPointer;
-    functionPointerNode->qualifiedName = GetCurrentQualifiedName();
-    functionPointerNode->dataType = dataType;
-    functionPointerNode->hash = generateHash(functionPointerNode->qualifiedName, NodeKind::FunctionPointer);
+    functionPointerNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+    functionPointerNode->dataType = context->intern(dataType);
+    functionPointerNode->hash = context->intern(generateHash(functionPointerNode->qualifiedName, NodeKind::FunctionPointer));
     
     AddNode(functionPointerNode);
     PushNode(functionPointerNode);
@@ -95,7 +92,7 @@ void alpha::TreeBuilder::normalizeFunctionPointerType(const std::string& dataTyp
 
 void alpha::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, unsigned int pos) {
     
-    auto ValueNode = std::make_shared<APINode>();
+    auto ValueNode = context->createNode();
     clang::QualType unDecayedDeclType;
     clang::TypeSourceInfo *TSI = nullptr;
     llvm::SmallString<128> nameBuf;
@@ -127,17 +124,17 @@ void alpha::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, un
     else return;
 
     const std::string dataType = Decl->isInvalidDecl() ? DATA_TYPE_PLACE_HOLDER : unDecayedDeclType.getAsString();
-    ValueNode->qualifiedName = GetCurrentQualifiedName();
-    ValueNode->hash = generateHash(ValueNode->qualifiedName, ValueNode->kind);
+    ValueNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+    ValueNode->hash = context->intern(generateHash(ValueNode->qualifiedName, ValueNode->kind));
 
     if (llvm::isa<clang::ParmVarDecl>(Decl)) {
-        DebugConfig::instance().log("VisitParamDecl : " + ValueNode->qualifiedName, DebugConfig::Level::DEBUG);
+        DebugConfig::instance().log("VisitParamDecl : " + ValueNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     } 
     else if (llvm::isa<clang::FieldDecl>(Decl)) {
-        DebugConfig::instance().log("VisitFieldDecl : " + ValueNode->qualifiedName, DebugConfig::Level::DEBUG);
+        DebugConfig::instance().log("VisitFieldDecl : " + ValueNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     } 
     else if (llvm::isa<clang::VarDecl>(Decl)) {
-        DebugConfig::instance().log("VisitVarDecl : " + ValueNode->qualifiedName, DebugConfig::Level::DEBUG);
+        DebugConfig::instance().log("VisitVarDecl : " + ValueNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     } 
 
     AddNode(ValueNode);
@@ -149,7 +146,7 @@ void alpha::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, un
             normalizeFunctionPointerType(typeModifiers, FTL);
             PopNode();
         }
-        else ValueNode->dataType = dataType;
+        else ValueNode->dataType = context->intern(dataType);
     }
     
     PopName();
@@ -174,19 +171,19 @@ bool alpha::TreeBuilder::BuildCXXRecordNode(clang::CXXRecordDecl* Decl) {
     }
 
     const std::string qualifiedName = GetCurrentQualifiedName();
-    auto cxxRecordNode = std::make_shared<APINode>();
+    auto cxxRecordNode = context->createNode();
 
-    cxxRecordNode->qualifiedName = qualifiedName;
+    cxxRecordNode->qualifiedName = context->intern(qualifiedName);
 
     DebugConfig::instance().log("VisitCxxRecordDecl : " + qualifiedName, DebugConfig::Level::DEBUG);
 
     if( Decl->isStruct() ){
         cxxRecordNode->kind = NodeKind::Struct;
-        cxxRecordNode->hash = generateHash(qualifiedName, NodeKind::Struct);
+        cxxRecordNode->hash = context->intern(generateHash(qualifiedName, NodeKind::Struct));
     }
     else if (Decl->isUnion()) {
         cxxRecordNode->kind = NodeKind::Union;
-        cxxRecordNode->hash = generateHash(qualifiedName, NodeKind::Union);
+        cxxRecordNode->hash = context->intern(generateHash(qualifiedName, NodeKind::Union));
     }
 
     AddNode(cxxRecordNode);
@@ -227,19 +224,17 @@ bool alpha::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
 
     if(isAnonymousEnumFieldVar) return false;
 
-    auto enumNode = std::make_shared<APINode>();
-
     if (Decl->getTypedefNameForAnonDecl()) return false;
-    else{
-        if( nameBuf.empty() ) return false;
-        PushName(nameBuf);
-        enumNode->qualifiedName = GetCurrentQualifiedName();
-    }
+    if( nameBuf.empty() ) return false;
+
+    auto enumNode = context->createNode();
+    PushName(nameBuf);
+    enumNode->qualifiedName = context->intern(GetCurrentQualifiedName());
 
-    DebugConfig::instance().log("VisitEnumDecl: " + enumNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("VisitEnumDecl: " + enumNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
 
     enumNode->kind = NodeKind::Enum;
-    enumNode->hash = generateHash(enumNode->qualifiedName, NodeKind::Enum);
+    enumNode->hash = context->intern(generateHash(enumNode->qualifiedName, NodeKind::Enum));
     
     if(!Decl->enumerators().empty()) nodeStack.push_back(enumNode);
 
@@ -247,11 +242,11 @@ bool alpha::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
     std::string enumaratorDataType = Decl->isInvalidDecl() ? DATA_TYPE_PLACE_HOLDER : enumType.getAsString();
      
     for (const auto* EnumConstDecl : Decl->enumerators()) {
-        auto enumValNode = std::make_shared<APINode>();
+        auto enumValNode = context->createNode();
         PushName(EnumConstDecl->getName());
-        enumValNode->qualifiedName = GetCurrentQualifiedName();
-        enumValNode->hash = generateHash(enumValNode->qualifiedName, NodeKind::Enumerator);
-        enumValNode->dataType = enumaratorDataType;
+        enumValNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+        enumValNode->hash = context->intern(generateHash(enumValNode->qualifiedName, NodeKind::Enumerator));
+        enumValNode->dataType = context->intern(enumaratorDataType);
         PopName();
         enumValNode->kind = NodeKind::Enumerator;
         AddNode(enumValNode);
@@ -278,7 +273,6 @@ bool alpha::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
     llvm::SmallString<128> nameBuf;
     llvm::raw_svector_ostream OS(nameBuf);
 
-    auto functionNode = std::make_shared<APINode>();
     Decl->printName(OS);
     PushName(nameBuf);
     std::string qualifiedName = GetCurrentQualifiedName();
@@ -291,12 +285,13 @@ bool alpha::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
         return true;
     }
     
-    functionNode->qualifiedName = qualifiedName;
+    auto functionNode = context->createNode();
+    functionNode->qualifiedName = context->intern(qualifiedName);
     functionNode->kind = NodeKind::Function;
-    functionNode->hash = hash;
+    functionNode->hash = context->intern(hash);
     functionNode->storage = getStorageClass(Decl->getStorageClass());
 
-    DebugConfig::instance().log("VisitFunctionDecl : " + functionNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("VisitFunctionDecl : " + functionNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     context->hashSet.try_emplace(hash);
 
     AddNode(functionNode);
@@ -0,0 +1,43 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+
+#include "armor_context.hpp"
+#include "comparison.hpp"
+
+/**
+ * @brief Serves comparison requests on a Unix domain socket until asked to stop.
+ *
+ * Each connection carries one JSON request (a ComparisonRequest, or
+ * {"command": "shutdown"}) terminated by the client closing its write side, and
+ * gets one JSON response: whether anything was compared, the console output of
+ * the comparison and the base cache counters. Every request runs with its own
+ * ArmorContext, so its log and reports go under its own output directory. Up to
+ * `jobs` requests run at once; the trees of older headers are shared between
+ * them through a cache of `cacheEntries` headers.
+ *
+ * @param context The daemon's own context, for its log and console.
+ * @return false if the socket could not be set up.
+ */
+bool runArmorServer(ArmorContext& context, const std::string& socketPath, unsigned jobs,
+                    size_t cacheEntries);
+
+/**
+ * @brief Sends a request to an armor --serve daemon and prints its console output.
+ *
+ * Relative paths in the request are made absolute first, since the daemon
+ * has its own working directory.
+ *
+ * @return What runComparison returned in the daemon, or false if it could not be reached.
+ */
+bool runArmorClient(const std::string& socketPath, ComparisonRequest request);
+
+/**
+ * @brief Asks an armor --serve daemon to exit once its running requests finish.
+ * @return false if the daemon could not be reached.
+ */
+bool stopArmorServer(const std::string& socketPath);
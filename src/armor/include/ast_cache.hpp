@@ -0,0 +1,97 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "clang/Frontend/ASTUnit.h"
+
+#include "armor_context.hpp"
+#include "file_digest.hpp"
+
+/**
+ * @class AstFileCache
+ * @brief Keeps the serialized Clang AST of parsed headers on disk across runs.
+ *
+ * An AST is filed under a hash of the clang version, the header's path and
+ * command line, and the content of every file the parse read: the header
+ * itself and its whole include closure. The closure is the one recorded by the
+ * last parse with that header and command line; it is hashed again on lookup,
+ * so an edit to any of those files is a miss. Clang's own timestamp checks are
+ * turned off, since a fresh checkout touches every file.
+ *
+ * Only parses without errors are stored. Once the .ast files exceed the size
+ * cap, the least recently used are deleted. Several processes may share the
+ * directory. Thread-safe.
+ */
+class AstFileCache {
+public:
+    /**
+     * @param directory Where the ASTs are kept; created on first store.
+     * @param capacityBytes Total size of the .ast files kept after a store.
+     */
+    AstFileCache(std::string directory, uint64_t capacityBytes);
+
+    AstFileCache(const AstFileCache&) = delete;
+    AstFileCache& operator=(const AstFileCache&) = delete;
+
+    // $XDG_CACHE_HOME/armor/ast, or ~/.cache/armor/ast
+    static std::string defaultDirectory();
+
+    /**
+     * @brief Turns off Clang's timestamp checks of the inputs of loaded ASTs.
+     *
+     * ASTUnit::LoadFromASTFile only takes this through the environment, so
+     * main calls it before any thread starts, and only for runs given
+     * --ast-cache or --serve. The variable is read by LoadFromASTFile alone,
+     * which armor uses for this cache only; prelude PCHs and shared preambles
+     * are validated as usual.
+     */
+    static void disableInputValidation();
+
+    /**
+     * @brief Loads the stored AST of a header parsed with these flags.
+     * @param closure If given, receives the include closure of a loaded AST.
+     * @return nullptr if there is none for the current content of its include closure.
+     */
+    std::unique_ptr<clang::ASTUnit> load(ArmorContext& context, const std::string& file,
+                                         const std::vector<std::string>& flags, FileDigestCache& fileDigests,
+                                         std::vector<std::string>* closure = nullptr);
+
+    /**
+     * @brief Stores the AST of a header parsed with these flags, then trims the cache.
+     * @param closure If given, receives the include closure of the AST.
+     */
+    void store(ArmorContext& context, const std::string& file, const std::vector<std::string>& flags,
+               clang::ASTUnit& unit, FileDigestCache& fileDigests, std::vector<std::string>* closure = nullptr);
+
+    unsigned hits() const { return m_hits; }
+    unsigned misses() const { return m_misses; }
+    unsigned stored() const { return m_stored; }
+
+private:
+    // Names the include closure recorded for a header and command line
+    static std::string closureKey(const std::string& file, const std::vector<std::string>& flags);
+
+    // Names the AST of that closure's current content; nullopt if a file cannot be read
+    static std::optional<std::string> contentKey(const std::string& closureKey,
+                                                 const std::vector<std::string>& closure,
+                                                 FileDigestCache& fileDigests);
+
+    // Deletes the least recently used ASTs until the rest fit the cap
+    void evict(ArmorContext& context);
+
+    const std::string m_directory;
+    const uint64_t m_capacityBytes;
+    std::mutex m_evictMutex;
+    std::atomic<unsigned> m_hits{0};
+    std::atomic<unsigned> m_misses{0};
+    std::atomic<unsigned> m_stored{0};
+};
@@ -0,0 +1,90 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+
+#include "alpha/include/ast_normalized_context.hpp"
+#include "beta/include/ast_normalized_context.hpp"
+#include "comm_def.hpp"
+#include "file_digest.hpp"
+
+/**
+ * @class BaseContextCache
+ * @brief Keeps the normalized trees of older-side headers between comparisons.
+ *
+ * A long-running armor (see --serve) compares many newer headers against the
+ * same older tree. Entries are keyed like AstFileCache's: by the header's path
+ * and clang command line, and by the content of every file the last parse with
+ * them read (the header and its include closure). An edit to any of those files,
+ * e.g. after the base branch moved, is a miss. The least recently used entry is
+ * evicted once the cache is full. Thread-safe.
+ */
+class BaseContextCache {
+public:
+    // Both normalized trees of one parse; read-only once cached. They share a
+    // string pool, which comparisons reusing them layer their own pool over.
+    struct Entry {
+        std::shared_ptr<alpha::ASTNormalizedContext> alpha;
+        std::shared_ptr<beta::ASTNormalizedContext> beta;
+        PARSING_STATUS parsingStatus = NO_FATAL_ERRORS;
+    };
+
+    explicit BaseContextCache(size_t capacity);
+
+    // Names a header and its command line; lookups add the content of its include closure
+    static std::string makeKey(const std::string& fileName, const std::vector<std::string>& flags);
+
+    // The trees of key, if every file recorded for it still has the content they were parsed from
+    std::optional<Entry> lookup(const std::string& key, FileDigestCache& fileDigests);
+
+    // closure: every file the parse read, the header included
+    void insert(const std::string& key, std::vector<std::string> closure, Entry entry,
+                FileDigestCache& fileDigests);
+
+    uint64_t hits() const { return m_hits.load(); }
+    uint64_t misses() const { return m_misses.load(); }
+    size_t size() const;
+
+private:
+    // The include closure last recorded for a key, and the content key it was cached under
+    struct Closure {
+        std::vector<std::string> files;
+        std::string contentKey;
+    };
+
+    struct Slot {
+        std::string contentKey;
+        std::string key;
+        Entry entry;
+    };
+
+    using LruList = std::list<Slot>;
+
+    // Names the current content of a closure; nullopt if a file cannot be read
+    static std::optional<std::string> contentKey(const std::string& key, const std::vector<std::string>& closure,
+                                                 FileDigestCache& fileDigests);
+
+    size_t m_capacity;
+
+    mutable std::mutex m_mutex;
+    // Most recently used first, by content key
+    LruList m_lru;
+    llvm::StringMap<LruList::iterator> m_index;
+    llvm::StringMap<Closure> m_closures;
+
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+};
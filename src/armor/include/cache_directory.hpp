@@ -0,0 +1,15 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <string>
+
+/**
+ * @brief Returns the directory armor keeps one kind of cache in across runs.
+ *
+ * That is $XDG_CACHE_HOME/armor/<kind>, or ~/.cache/armor/<kind> without it,
+ * or a directory below the system temporary directory if there is no home.
+ * The directory is not created.
+ */
+std::string userCacheDirectory(const std::string& kind);
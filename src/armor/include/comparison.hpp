@@ -0,0 +1,80 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "armor_context.hpp"
+#include "base_context_cache.hpp"
+#include "debug_config.hpp"
+
+// Everything one armor invocation asks for, as given on the command line or
+// sent to an armor --serve daemon.
+struct ComparisonRequest {
+    std::string projectRoot1;
+    std::string projectRoot2;
+    std::vector<std::string> headers;
+    std::string headerSubDir;
+    // Narrow the headers found under headerSubDir (see HeaderFilter)
+    std::vector<std::string> headerGlobs;
+    std::vector<std::string> excludeGlobs;
+    std::string manifestPath;
+    // Empty means armor_reports/manifest_status.json under the output directory
+    std::string manifestStatusPath;
+    std::string outputDir;
+    std::string reportFormat = "html";
+    std::string logLevel;
+    bool dumpAstDiff = false;
+    std::vector<std::string> includePaths;
+    std::vector<std::string> macros;
+    // Directory holding the compile_commands.json of the newer project root; each
+    // header gets the flags of the translation unit matching it best (see CompileCommandsFlags)
+    std::string buildDir;
+    // Parse declarations only: bodies of functions that are not constexpr or
+    // auto-typed are skipped, which no report looks at
+    bool skipFunctionBodies = false;
+    unsigned jobs = 1;
+    // Compare in forked worker processes (jobs of them) so a crash loses one header only
+    bool isolate = false;
+    // Seconds a worker may spend on one pair before it is killed; 0 for no limit
+    unsigned isolateTimeoutSec = 600;
+    // With a repository, both project roots are read from these revisions of it
+    // (see GitSourceTrees) and projectRoot1/projectRoot2 are ignored
+    std::string gitRepo;
+    std::string oldRev;
+    std::string newRev;
+    // Include targets precompiled once per project root and flag set (see PreludePchCache);
+    // with preludeAuto, the system includes all compared headers share are added
+    std::vector<std::string> prelude;
+    bool preludeAuto = false;
+    // Keep the ASTs of older headers on disk across runs (see AstFileCache)
+    bool astCache = false;
+    unsigned astCacheSizeMb = 2048;
+    // Write the beta trees of the newer headers here as an API snapshot, which
+    // may later be given as projectRoot1 (see beta::ApiSnapshot)
+    std::string emitSnapshot;
+};
+
+/**
+ * @brief Sets the level named by --log-level ("ERROR", "LOG", "INFO" or "DEBUG")
+ *        and announces it in the log. An empty or unknown name leaves the level alone.
+ */
+void applyLogLevel(DebugConfig& debug, const std::string& logLevel);
+
+/**
+ * @brief Compares every header pair a request names and writes their reports.
+ *
+ * Pairs come from the positional headers, then from the manifest or, without
+ * either, from every header in --header-dir. Output goes to the context, which
+ * the caller has installed on its thread. With a base cache, older headers
+ * seen by an earlier request are not parsed again. With a git repository, a
+ * header that exists in only one of the two revisions is compared against an
+ * empty file. If projectRoot1 names an API snapshot, the newer headers are
+ * compared against the trees in it with the beta parser alone.
+ *
+ * @return true if at least one pair was compared.
+ */
+bool runComparison(const ComparisonRequest& request, ArmorContext& context,
+                   BaseContextCache* baseCache = nullptr);
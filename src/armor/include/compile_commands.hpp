@@ -0,0 +1,79 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+
+#include "armor_context.hpp"
+#include "manifest.hpp"
+
+// The part of a translation unit's command line that affects how a header parses.
+struct HeaderBuildFlags {
+    // -I directories inside the source root, relative to it, so that each
+    // project root resolves them under itself
+    std::vector<std::string> includePaths;
+    // Macros, language and target flags, forced includes and other search
+    // directories, in command line order; paths inside the source root start
+    // with kProjectRootVariable instead
+    std::vector<std::string> flags;
+
+    bool operator<(const HeaderBuildFlags& other) const {
+        return std::tie(includePaths, flags) < std::tie(other.includePaths, other.flags);
+    }
+};
+
+/**
+ * @class CompileCommandsFlags
+ * @brief Reconstructs per-header clang flags from a compile_commands.json.
+ *
+ * A header has no entry of its own, so it takes the command of the translation
+ * unit that matches it best: the one compiling the header itself if there is
+ * one, otherwise the closest by path and name (clang's interpolating
+ * compilation database). Only GCC-style flags are read.
+ */
+class CompileCommandsFlags {
+public:
+    /**
+     * @brief Reads buildDir/compile_commands.json.
+     * @param sourceRoot The tree the database was generated for; include
+     *        directories inside it are made relative to it.
+     * @return nullptr and an error message if the database cannot be read.
+     */
+    static std::unique_ptr<CompileCommandsFlags> load(const std::string& buildDir,
+                                                      const std::string& sourceRoot,
+                                                      std::string& error);
+
+    /**
+     * @param relativeHeader Path of the header relative to the source root.
+     * @return nullopt if no translation unit matches the header.
+     */
+    std::optional<HeaderBuildFlags> flagsFor(const std::string& relativeHeader) const;
+
+    /**
+     * @brief Adds the flags of every pair's header to its include paths and macros.
+     *
+     * Headers are looked up by the path of their newer file relative to
+     * projectRoot2. Pairs with identical flags share one set of them, and with
+     * it every cache keyed by flags (precompiled preludes, preambles).
+     *
+     * @return The number of distinct flag sets handed out.
+     */
+    size_t apply(ArmorContext& context, const std::string& projectRoot2, std::vector<HeaderPair>& pairs) const;
+
+private:
+    CompileCommandsFlags(std::unique_ptr<clang::tooling::CompilationDatabase> database,
+                         std::string sourceRoot, std::string buildDir)
+        : m_database(std::move(database)), m_sourceRoot(std::move(sourceRoot)), m_buildDir(std::move(buildDir)) {}
+
+    std::unique_ptr<clang::tooling::CompilationDatabase> m_database;
+    // Absolute and without symlinks, as the database spells its paths
+    std::string m_sourceRoot;
+    std::string m_buildDir;
+};
@@ -0,0 +1,61 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/GlobPattern.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "manifest.hpp"
+
+/**
+ * @class HeaderFilter
+ * @brief Decides which files under --header-dir are headers to compare.
+ *
+ * A file is taken if its extension is one of .h, .hh, .hpp, .hxx and .inl,
+ * its path relative to the header directory matches one of the include globs
+ * (when any are given) and none of the exclude globs. In a glob `*` also
+ * matches `/`, so one star covers every level below a directory.
+ */
+class HeaderFilter {
+public:
+    /**
+     * @brief Compiles the globs.
+     * @return nullptr and an error message if a glob is malformed.
+     */
+    static std::unique_ptr<HeaderFilter> create(const std::vector<std::string>& includeGlobs,
+                                                const std::vector<std::string>& excludeGlobs,
+                                                std::string& error);
+
+    bool matches(llvm::StringRef relativePath) const;
+
+private:
+    HeaderFilter() = default;
+
+    // GlobPattern refers into the pattern text, so the text is kept alongside
+    std::vector<std::unique_ptr<std::string>> m_patternText;
+    std::vector<llvm::GlobPattern> m_include;
+    std::vector<llvm::GlobPattern> m_exclude;
+};
+
+/**
+ * @brief Lists the header pairs below headerSubDir of both project roots.
+ *
+ * Both trees are walked recursively and concurrently through fileSystem
+ * (which must be thread-safe); every matching file is stat'ed once during the
+ * walk. Headers found under the older root are paired with
+ * the same relative path under the newer root, sorted by path. A pair whose
+ * newer header exists carries both sizes, so later steps need neither an
+ * existence check nor a stat. Headers only in the newer tree are logged.
+ */
+std::vector<HeaderPair> discoverHeaderPairs(const std::string& projectRoot1,
+                                            const std::string& projectRoot2,
+                                            const std::string& headerSubDir,
+                                            const HeaderFilter& filter,
+                                            llvm::vfs::FileSystem& fileSystem);
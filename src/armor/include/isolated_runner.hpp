@@ -0,0 +1,31 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "manifest.hpp"
+
+/**
+ * @brief Runs every pair through processPair in forked worker processes.
+ *
+ * A supervisor forks `workers` processes and hands them groups of pairs (see
+ * groupPairsByReport) from one queue. Each worker writes its reports as usual
+ * and sends back the outcome and console output of every pair. A worker that
+ * dies, e.g. on a Clang crash or a failed assertion, is replaced; the pair it
+ * was comparing is marked Crashed and the rest of its group is queued again.
+ * So is a worker still on one pair after pairTimeout (zero for no limit),
+ * which is killed first.
+ * Console output is replayed in input order, as processHeaderPairs does.
+ *
+ * Must be called while the process runs no other threads.
+ *
+ * @return The outcome of every pair, in input order.
+ */
+std::vector<PairOutcome> processHeaderPairsIsolated(const std::vector<HeaderPair>& pairs, unsigned workers,
+                                                    const std::string& projectRoot1, std::chrono::seconds pairTimeout,
+                                                    const std::function<PairOutcome(const HeaderPair&)>& processPair);
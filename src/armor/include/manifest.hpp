@@ -0,0 +1,81 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "output_layout.hpp"
+
+// One header to compare between the two project roots.
+struct HeaderPair {
+    // Name the header was requested under (command line or manifest entry)
+    std::string name;
+    std::string file1;
+    std::string file2;
+    // Extra include paths (relative to each project root) and macro flags for this pair only
+    std::vector<std::string> includePaths;
+    std::vector<std::string> macros;
+    // Sizes seen by --header-dir discovery; a file with a size is known to exist
+    std::optional<uint64_t> size1;
+    std::optional<uint64_t> size2;
+};
+
+// What happened to one header pair.
+enum class PairOutcome {
+    MissingOld,
+    MissingNew,
+    Unchanged,
+    Compared,
+    ComparedWithErrors,
+    // The process comparing it died (--isolate only)
+    Crashed
+};
+
+/**
+ * @brief Reads a manifest of header pairs.
+ *
+ * The manifest is either one JSON array or NDJSON (one entry per line). An
+ * entry is a header path string, or an object with
+ *   - "header": path interpreted like a positional header argument, or
+ *   - "old" / "new": paths relative to projectRoot1 / projectRoot2,
+ * and optionally "include_paths" (array) and "macro_flags" (string or array).
+ *
+ * @return false if the manifest cannot be read or an entry is malformed.
+ */
+bool loadManifest(const std::string& manifestPath,
+                  const std::string& projectRoot1,
+                  const std::string& projectRoot2,
+                  const std::string& headerSubDir,
+                  std::vector<HeaderPair>& pairs);
+
+/**
+ * @brief Groups pairs that write the same reports, in input order.
+ *
+ * A header listed more than once writes the same reports, so parallel runners
+ * keep each group on one worker in input order and the last pair wins as it
+ * would serially.
+ *
+ * @return Indices into pairs, one vector per group, groups in order of first appearance.
+ */
+std::vector<std::vector<size_t>> groupPairsByReport(const std::vector<HeaderPair>& pairs,
+                                                    const std::string& projectRoot1);
+
+/**
+ * @brief Writes the combined status of a manifest run as JSON.
+ *
+ * Lists every pair with its outcome and the reports written for it. The
+ * top-level "status" is "success" unless a header was missing, failed to parse
+ * or crashed its worker.
+ * @return false if the status file cannot be written.
+ */
+bool writeManifestStatus(const std::string& statusPath,
+                         const std::vector<HeaderPair>& pairs,
+                         const std::vector<PairOutcome>& outcomes,
+                         const std::string& reportFormat,
+                         const std::string& projectRoot1,
+                         const OutputLayout& output);
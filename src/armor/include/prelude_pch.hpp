@@ -0,0 +1,91 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <atomic>
+#include <future>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "armor_context.hpp"
+
+/**
+ * @class PreludePchCache
+ * @brief Precompiles the headers every compared header starts with, once per flag set.
+ *
+ * The prelude is a list of include targets (e.g. "<cstdint>" or "sdk/types.h").
+ * For each project root and command line a synthetic header including them is
+ * compiled into a PCH, which every parse with that command line then loads
+ * with -include-pch instead of preprocessing the prelude again.
+ *
+ * PCHs are kept under the cache directory across runs. An entry is named by a
+ * hash of the clang version, the command line and the prelude, and is reused
+ * only while every file it was built from still has the size and content hash
+ * recorded next to it; otherwise it is rebuilt. Clang's own timestamp checks
+ * are turned off, since a fresh checkout touches every file. Thread-safe.
+ *
+ * Several processes may share the directory. A PCH file is also named by the
+ * hash of its input listing and published by rename, so one being loaded is
+ * never rewritten or deleted; superseded PCHs stay until the directory is cleared.
+ */
+class PreludePchCache {
+public:
+    PreludePchCache(std::string directory, std::vector<std::string> prelude);
+
+    PreludePchCache(const PreludePchCache&) = delete;
+    PreludePchCache& operator=(const PreludePchCache&) = delete;
+
+    // $XDG_CACHE_HOME/armor/pch, or ~/.cache/armor/pch
+    static std::string defaultDirectory();
+
+    /**
+     * @brief Lists the angle-bracket includes that every one of the headers has.
+     *
+     * Only includes outside conditional blocks count; an #ifndef X / #define X
+     * include guard opening the file is not one.
+     * The result keeps the order of the first header; unreadable headers are skipped.
+     */
+    static std::vector<std::string> detectPrelude(llvm::vfs::FileSystem& fileSystem,
+                                                  const std::vector<std::string>& headers);
+
+    const std::vector<std::string>& prelude() const { return m_prelude; }
+
+    /**
+     * @brief Returns the flags that load the prelude PCH for one parse of headerPath.
+     *
+     * The PCH for projectRoot, includePaths and macroFlags is built on first
+     * use. Nothing is returned, and the header is parsed as before, if the
+     * prelude does not compile or headerPath is itself part of it.
+     */
+    std::vector<std::string> flagsFor(ArmorContext& context,
+                                      const std::string& projectRoot,
+                                      const std::string& headerPath,
+                                      const std::vector<std::string>& includePaths,
+                                      const std::vector<std::string>& macroFlags);
+
+    unsigned built() const { return m_built; }
+    unsigned reused() const { return m_reused; }
+
+private:
+    // A PCH ready for use and every file it was built from
+    struct Pch {
+        std::string path;
+        llvm::StringSet<> inputs;
+    };
+
+    Pch prepare(ArmorContext& context, const std::string& projectRoot, const std::string& key,
+                const std::vector<std::string>& flags);
+
+    const std::string m_directory;
+    const std::vector<std::string> m_prelude;
+    std::mutex m_mutex;
+    llvm::StringMap<std::shared_future<Pch>> m_pchs;
+    std::atomic<unsigned> m_built{0};
+    std::atomic<unsigned> m_reused{0};
+};
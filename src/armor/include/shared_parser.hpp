@@ -0,0 +1,82 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "beta/include/api_snapshot.hpp"
+#include "armor_context.hpp"
+#include "ast_cache.hpp"
+#include "base_context_cache.hpp"
+#include "comm_def.hpp"
+#include "file_digest.hpp"
+#include "prelude_pch.hpp"
+
+/**
+ * @brief Compares one header pair with both parsers from a single Clang parse per side.
+ *
+ * Each header is parsed once and the resulting AST is handed to the alpha and
+ * the beta normalizer together. The alpha report is written first; the beta
+ * report follows only if both headers parsed without fatal errors, as when the
+ * two parsers ran one after the other. Logging and reports go to the given
+ * context, which may be shared by concurrent calls.
+ *
+ * With a base cache the older header's trees are taken from it when its
+ * content and flags match an earlier parse, and only the newer header is
+ * parsed; otherwise the trees of the older header are added to it.
+ *
+ * With a prelude cache each side loads the PCH of its project root's prelude.
+ * Otherwise, when both headers start with the same include block, the older
+ * side precompiles it and the newer side loads it too (see SharedPreamble).
+ *
+ * With an AST cache the older header's AST is loaded from it when neither the
+ * header, its include closure nor its flags changed since it was stored, and
+ * stored there after a parse otherwise. It is not used with a prelude PCH or
+ * with sources read from git, and takes the place of the shared preamble.
+ *
+ * With a snapshot writer the beta tree of the newer header is added to it,
+ * filed under the header's path relative to projectRoot2, if it parsed
+ * without fatal errors.
+ *
+ * @return The combined parsing status of the two headers.
+ */
+PARSING_STATUS processHeaderPairShared(ArmorContext& context,
+                                       const std::string& projectRoot1,
+                                       const std::string& file1,
+                                       const std::string& projectRoot2,
+                                       const std::string& file2,
+                                       const std::string& reportFormat,
+                                       const std::vector<std::string>& IncludePaths,
+                                       const std::vector<std::string>& macroFlags,
+                                       FileDigestCache& fileDigests,
+                                       BaseContextCache* baseCache = nullptr,
+                                       PreludePchCache* prelude = nullptr,
+                                       AstFileCache* astCache = nullptr,
+                                       beta::ApiSnapshotWriter* snapshot = nullptr);
+
+/**
+ * @brief Compares a header against its tree in an API snapshot.
+ *
+ * Only the newer header is parsed, by the beta parser alone; the older tree
+ * is taken from the snapshot, where it is filed under `header`. Reports are
+ * named as if the snapshot path were the older project root, so file1 is
+ * snapshotPath + "/" + header. No report is written if the newer header has
+ * fatal errors. With a prelude cache the newer side loads its PCH, and with a
+ * snapshot writer its tree is added to it as in processHeaderPairShared.
+ *
+ * @return The parsing status of the newer header.
+ */
+PARSING_STATUS processHeaderAgainstSnapshot(ArmorContext& context,
+                                            const beta::ApiSnapshot& baseline,
+                                            const std::string& snapshotPath,
+                                            const std::string& header,
+                                            const std::string& projectRoot2,
+                                            const std::string& file2,
+                                            const std::string& reportFormat,
+                                            const std::vector<std::string>& IncludePaths,
+                                            const std::vector<std::string>& macroFlags,
+                                            FileDigestCache& fileDigests,
+                                            PreludePchCache* prelude = nullptr,
+                                            beta::ApiSnapshotWriter* snapshot = nullptr);
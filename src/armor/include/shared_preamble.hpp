@@ -0,0 +1,118 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <future>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "clang/Frontend/PrecompiledPreamble.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "armor_context.hpp"
+#include "file_digest.hpp"
+
+/**
+ * @class SharedPreamble
+ * @brief Parses the include block that both versions of a header share only once.
+ *
+ * Most changes to a header leave its preamble (the comments and #include
+ * lines before the first declaration) alone, and the files it includes are
+ * the same in both project roots. The parse of the older header then builds
+ * a clang::PrecompiledPreamble and both parses load it, so each only parses
+ * its own body.
+ *
+ * The newer header uses the preamble only if its own preamble text matches,
+ * every file the preamble read from below the older project root has a
+ * byte-identical counterpart below the newer one, and no file the newer root
+ * adds to an earlier include directory would be found instead; otherwise it
+ * is parsed on its own. A preamble that does not compile without errors is not used at all,
+ * so diagnostics and parsing status stay those of a full parse. Warnings in
+ * the included files are not logged while a preamble is shared.
+ */
+class SharedPreamble {
+public:
+    /**
+     * @brief Returns a shared preamble for a header pair, or nullptr where none fits.
+     *
+     * The two command lines must be the same up to the project root, and both
+     * headers must start with the same non-empty preamble.
+     */
+    static std::unique_ptr<SharedPreamble> create(ArmorContext& context,
+                                                  const std::string& projectRoot1, const std::string& file1,
+                                                  const std::vector<std::string>& flags1,
+                                                  const std::string& projectRoot2, const std::string& file2,
+                                                  const std::vector<std::string>& flags2,
+                                                  FileDigestCache& fileDigests);
+
+    ~SharedPreamble();
+
+    SharedPreamble(const SharedPreamble&) = delete;
+    SharedPreamble& operator=(const SharedPreamble&) = delete;
+
+    /**
+     * @brief Wraps the factory of one side's parse.
+     *
+     * The older header's parse builds the preamble and the newer header's
+     * parse waits for it, so both must run, and may run concurrently.
+     */
+    std::unique_ptr<clang::tooling::FrontendActionFactory> wrap(const std::string& fileName,
+                                                               clang::tooling::FrontendActionFactory& factory);
+
+private:
+    class BuildingFactory;
+    class ReusingFactory;
+    class InputCollector;
+
+    // An include directive of the preamble and the file the older parse found for it
+    struct Inclusion {
+        std::string includerDir;
+        std::string name;
+        bool angled = false;
+        std::string found;
+    };
+
+    struct SearchDir {
+        std::string path;
+        bool quotedOnly = false;
+    };
+
+    // What the preamble was built from, set before it is published
+    struct Inputs {
+        std::vector<std::string> files;
+        std::vector<Inclusion> inclusions;
+        std::vector<SearchDir> searchDirs;
+    };
+
+    SharedPreamble(ArmorContext& context, std::string projectRoot1, std::string file1,
+                   std::string projectRoot2, std::string file2, FileDigestCache& fileDigests);
+
+    // Hands the preamble (or nullptr) to the newer side; later calls do nothing
+    void publish(std::shared_ptr<clang::PrecompiledPreamble> preamble, Inputs inputs);
+
+    // True if every input below the older root is the same below the newer one
+    bool inputsMatch() const;
+
+    // True if every include of the preamble finds the counterpart of the older file below the newer root
+    bool includesResolveAlike(llvm::vfs::FileSystem& fileSystem) const;
+
+    // The newer root's counterpart of a path below the older one
+    std::string rebased(const std::string& path) const;
+
+    ArmorContext& m_context;
+    const std::string m_projectRoot1;
+    const std::string m_file1;
+    const std::string m_projectRoot2;
+    const std::string m_file2;
+    FileDigestCache& m_fileDigests;
+
+    std::mutex m_mutex;
+    bool m_published = false;
+    std::promise<std::shared_ptr<clang::PrecompiledPreamble>> m_promise;
+    std::shared_future<std::shared_ptr<clang::PrecompiledPreamble>> m_preamble;
+    Inputs m_inputs;
+};
@@ -0,0 +1,392 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <exception>
+#include <limits>
+#include <filesystem>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <nlohmann/json.hpp>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+
+#include "armor_server.hpp"
+#include "base_context_cache.hpp"
+#include "comparison.hpp"
+#include "output_layout.hpp"
+#include "user_print.hpp"
+
+namespace {
+
+// A request is a few paths and flags; anything near this is not one
+constexpr size_t kMaxRequestBytes = 16 * 1024 * 1024;
+
+// A client that has not sent its whole request this long after its pool
+// thread took it loses that thread, however slowly it trickles the bytes in
+constexpr std::chrono::seconds kReceiveTimeout{30};
+
+std::string errnoMessage() {
+    return std::error_code(errno, std::generic_category()).message();
+}
+
+bool makeAddress(const std::string &socketPath, sockaddr_un &addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (socketPath.empty() || socketPath.size() >= sizeof(addr.sun_path)) {
+        USER_ERROR(std::string("Invalid socket path (at most ") + std::to_string(sizeof(addr.sun_path) - 1) +
+                   " characters): " + socketPath);
+        return false;
+    }
+    std::memcpy(addr.sun_path, socketPath.c_str(), socketPath.size());
+    return true;
+}
+
+// Returns a connected socket, or -1 with errno set.
+int connectTo(const sockaddr_un &addr) {
+    int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        return -1;
+    }
+    if (::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0) {
+        int savedErrno = errno;
+        ::close(fd);
+        errno = savedErrno;
+        return -1;
+    }
+    return fd;
+}
+
+bool sendAll(int fd, llvm::StringRef data) {
+    while (!data.empty()) {
+        // MSG_NOSIGNAL: a peer that went away is an error here, not a SIGPIPE
+        ssize_t sent = ::send(fd, data.data(), data.size(), MSG_NOSIGNAL);
+        if (sent < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        data = data.drop_front(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+// Reads until the peer closes its write side. Fails with EMSGSIZE once more
+// than maxBytes arrive, and with ETIMEDOUT if the deadline passes first.
+bool receiveAll(int fd, std::string &data, size_t maxBytes = std::numeric_limits<size_t>::max(),
+                std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max()) {
+    char buffer[64 * 1024];
+    while (true) {
+        if (deadline != std::chrono::steady_clock::time_point::max()) {
+            auto left = std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+            pollfd readable{fd, POLLIN, 0};
+            int ready = left.count() > 0 ? ::poll(&readable, 1, static_cast<int>(left.count())) : 0;
+            if (ready < 0) {
+                if (errno == EINTR) {
+                    continue;
+                }
+                return false;
+            }
+            if (ready == 0) {
+                errno = ETIMEDOUT;
+                return false;
+            }
+        }
+        ssize_t received = ::read(fd, buffer, sizeof(buffer));
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (received == 0) {
+            return true;
+        }
+        if (static_cast<size_t>(received) > maxBytes - data.size()) {
+            errno = EMSGSIZE;
+            return false;
+        }
+        data.append(buffer, static_cast<size_t>(received));
+    }
+}
+
+// Sends one message and waits for the reply.
+bool exchange(const std::string &socketPath, const nlohmann::json &message, nlohmann::json &reply) {
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr)) {
+        return false;
+    }
+    int fd = connectTo(addr);
+    if (fd < 0) {
+        USER_ERROR(std::string("Cannot reach armor server at ") + socketPath + ": " + errnoMessage());
+        return false;
+    }
+    std::string payload;
+    bool ok = sendAll(fd, message.dump()) && ::shutdown(fd, SHUT_WR) == 0 && receiveAll(fd, payload);
+    std::string error = ok ? std::string() : errnoMessage();
+    ::close(fd);
+    if (!ok) {
+        USER_ERROR(std::string("Lost connection to armor server at ") + socketPath + ": " + error);
+        return false;
+    }
+    reply = nlohmann::json::parse(payload, nullptr, false);
+    if (reply.is_discarded() || !reply.is_object()) {
+        USER_ERROR(std::string("Malformed reply from armor server at ") + socketPath);
+        return false;
+    }
+    return true;
+}
+
+// A socket file left behind by a daemon that did not exit cleanly is removed;
+// one a daemon still listens on is not.
+bool removeStaleSocket(const std::string &socketPath, const sockaddr_un &addr) {
+    struct stat st;
+    if (::lstat(socketPath.c_str(), &st) != 0) {
+        return true;
+    }
+    if (!S_ISSOCK(st.st_mode)) {
+        USER_ERROR(socketPath + " exists and is not a socket");
+        return false;
+    }
+    int fd = connectTo(addr);
+    if (fd >= 0) {
+        ::close(fd);
+        USER_ERROR(std::string("An armor server is already listening on ") + socketPath);
+        return false;
+    }
+    ::unlink(socketPath.c_str());
+    return true;
+}
+
+std::string absolutePath(const std::string &path) {
+    if (path.empty()) {
+        return path;
+    }
+    std::error_code ec;
+    std::filesystem::path absolute = std::filesystem::absolute(path, ec);
+    return ec ? path : absolute.string();
+}
+
+nlohmann::json requestToJson(const ComparisonRequest &request) {
+    return {
+        {"project_root1", request.projectRoot1},
+        {"project_root2", request.projectRoot2},
+        {"headers", request.headers},
+        {"header_dir", request.headerSubDir},
+        {"header_globs", request.headerGlobs},
+        {"exclude_globs", request.excludeGlobs},
+        {"manifest", request.manifestPath},
+        {"manifest_status", request.manifestStatusPath},
+        {"output_dir", request.outputDir},
+        {"report_format", request.reportFormat},
+        {"log_level", request.logLevel},
+        {"dump_ast_diff", request.dumpAstDiff},
+        {"include_paths", request.includePaths},
+        {"macro_flags", request.macros},
+        {"skip_function_bodies", request.skipFunctionBodies},
+        {"jobs", request.jobs},
+        {"isolate", request.isolate},
+        {"git_repo", request.gitRepo},
+        {"old_rev", request.oldRev},
+        {"new_rev", request.newRev},
+        {"prelude", request.prelude},
+        {"prelude_auto", request.preludeAuto},
+        {"ast_cache", request.astCache},
+        {"ast_cache_size_mb", request.astCacheSizeMb},
+        {"emit_snapshot", request.emitSnapshot},
+        {"build_dir", request.buildDir},
+    };
+}
+
+ComparisonRequest requestFromJson(const nlohmann::json &message) {
+    ComparisonRequest request;
+    request.projectRoot1 = message.value("project_root1", std::string());
+    request.projectRoot2 = message.value("project_root2", std::string());
+    request.headers = message.value("headers", std::vector<std::string>());
+    request.headerSubDir = message.value("header_dir", std::string());
+    request.headerGlobs = message.value("header_globs", std::vector<std::string>());
+    request.excludeGlobs = message.value("exclude_globs", std::vector<std::string>());
+    request.manifestPath = message.value("manifest", std::string());
+    request.manifestStatusPath = message.value("manifest_status", std::string());
+    request.outputDir = message.value("output_dir", std::string());
+    request.reportFormat = message.value("report_format", request.reportFormat);
+    request.logLevel = message.value("log_level", std::string());
+    request.dumpAstDiff = message.value("dump_ast_diff", false);
+    request.includePaths = message.value("include_paths", std::vector<std::string>());
+    request.macros = message.value("macro_flags", std::vector<std::string>());
+    request.skipFunctionBodies = message.value("skip_function_bodies", false);
+    request.jobs = message.value("jobs", 1u);
+    request.isolate = message.value("isolate", false);
+    request.gitRepo = message.value("git_repo", std::string());
+    request.oldRev = message.value("old_rev", std::string());
+    request.newRev = message.value("new_rev", std::string());
+    request.prelude = message.value("prelude", std::vector<std::string>());
+    request.preludeAuto = message.value("prelude_auto", false);
+    request.astCache = message.value("ast_cache", false);
+    request.astCacheSizeMb = message.value("ast_cache_size_mb", request.astCacheSizeMb);
+    request.emitSnapshot = message.value("emit_snapshot", std::string());
+    request.buildDir = message.value("build_dir", std::string());
+    return request;
+}
+
+// Answers one connection. Returns true if the client asked the daemon to stop.
+bool serveConnection(int fd, BaseContextCache &cache) {
+    std::string payload;
+    if (!receiveAll(fd, payload, kMaxRequestBytes, std::chrono::steady_clock::now() + kReceiveTimeout)) {
+        // A timed out or vanished client gets no answer; an oversized request
+        // is refused without reading the rest of it
+        if (errno == EMSGSIZE) {
+            sendAll(fd, nlohmann::json{{"error", "request too large"}}.dump());
+        }
+        return false;
+    }
+
+    bool stop = false;
+    nlohmann::json reply;
+    nlohmann::json message = nlohmann::json::parse(payload, nullptr, false);
+    if (message.is_discarded() || !message.is_object()) {
+        reply = {{"error", "malformed request"}};
+    } else if (message.value("command", std::string("compare")) == "shutdown") {
+        reply = {{"status", "stopping"}};
+        stop = true;
+    } else {
+        ConsoleCapture capture;
+        bool processed = false;
+        try {
+            ComparisonRequest request = requestFromJson(message);
+            ScopedConsoleCapture captureScope(capture);
+            ArmorContext requestContext{OutputLayout(request.outputDir)};
+            ScopedDebugConfig debugScope(requestContext.debug());
+            requestContext.openDiagnosticsLog();
+            applyLogLevel(requestContext.debug(), request.logLevel);
+            if (request.isolate) {
+                // Forking while other requests run threads is not safe
+                requestContext.debug().log("--isolate is ignored by armor --serve", DebugConfig::Level::LOG);
+                request.isolate = false;
+            }
+            try {
+                processed = runComparison(request, requestContext, &cache);
+            } catch (const std::exception &e) {
+                USER_ERROR(std::string("Comparison failed: ") + e.what());
+            }
+            reply = {
+                {"processed", processed},
+                {"stdout", capture.out.str()},
+                {"stderr", capture.errStream.str()},
+            };
+        } catch (const std::exception &e) {
+            reply = {{"error", std::string("malformed request: ") + e.what()}};
+        }
+        reply["cache"] = {
+            {"hits", cache.hits()},
+            {"misses", cache.misses()},
+            {"entries", cache.size()},
+        };
+    }
+
+    sendAll(fd, reply.dump());
+    return stop;
+}
+
+}
+
+bool runArmorServer(ArmorContext &context, const std::string &socketPath, unsigned jobs,
+                    size_t cacheEntries) {
+    sockaddr_un addr;
+    if (!makeAddress(socketPath, addr) || !removeStaleSocket(socketPath, addr)) {
+        return false;
+    }
+
+    int listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listenFd < 0 ||
+        ::bind(listenFd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) != 0 ||
+        ::listen(listenFd, SOMAXCONN) != 0) {
+        USER_ERROR(std::string("Cannot listen on ") + socketPath + ": " + errnoMessage());
+        if (listenFd >= 0) {
+            ::close(listenFd);
+        }
+        return false;
+    }
+    USER_PRINT(std::string("Serving armor requests on ") + socketPath);
+
+    BaseContextCache cache(cacheEntries);
+    std::atomic<bool> stopping{false};
+    {
+        llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+        while (!stopping) {
+            int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno == EINTR || errno == ECONNABORTED) {
+                    continue;
+                }
+                if (!stopping) {
+                    USER_ERROR(std::string("Stopped accepting connections: ") + errnoMessage());
+                }
+                break;
+            }
+            pool.async([&, fd]() {
+                ScopedDebugConfig debugScope(context.debug());
+                if (serveConnection(fd, cache)) {
+                    stopping = true;
+                    // Wakes the accept() above
+                    ::shutdown(listenFd, SHUT_RDWR);
+                }
+                ::close(fd);
+            });
+        }
+        // Requests already accepted still get their answer
+        pool.wait();
+    }
+
+    ::close(listenFd);
+    ::unlink(socketPath.c_str());
+    context.debug().log("Base cache: " + std::to_string(cache.hits()) + " hits, " +
+                        std::to_string(cache.misses()) + " misses", DebugConfig::Level::INFO);
+    USER_PRINT(std::string("Stopped serving on ") + socketPath);
+    return true;
+}
+
+bool runArmorClient(const std::string &socketPath, ComparisonRequest request) {
+    request.projectRoot1 = absolutePath(request.projectRoot1);
+    request.projectRoot2 = absolutePath(request.projectRoot2);
+    request.gitRepo = absolutePath(request.gitRepo);
+    request.manifestPath = absolutePath(request.manifestPath);
+    request.manifestStatusPath = absolutePath(request.manifestStatusPath);
+    request.emitSnapshot = absolutePath(request.emitSnapshot);
+    request.buildDir = absolutePath(request.buildDir);
+    request.outputDir = request.outputDir.empty() ? std::filesystem::current_path().string()
+                                                  : absolutePath(request.outputDir);
+
+    nlohmann::json reply;
+    if (!exchange(socketPath, requestToJson(request), reply)) {
+        return false;
+    }
+    if (reply.contains("error")) {
+        USER_ERROR(std::string("armor server: ") + reply["error"].get<std::string>());
+        return false;
+    }
+    userOut() << reply.value("stdout", std::string()) << std::flush;
+    userErr() << reply.value("stderr", std::string());
+    userErr().flush();
+    if (reply.contains("cache")) {
+        DebugConfig::instance().log("Base cache: " + reply["cache"].dump(), DebugConfig::Level::INFO);
+    }
+    return reply.value("processed", false);
+}
+
+bool stopArmorServer(const std::string &socketPath) {
+    nlohmann::json reply;
+    return exchange(socketPath, {{"command", "shutdown"}}, reply) && !reply.contains("error");
+}
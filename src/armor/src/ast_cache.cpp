@@ -0,0 +1,219 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Basic/FileSystemOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Serialization/PCHContainerOperations.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/xxhash.h"
+
+#include "ast_cache.hpp"
+#include "cache_directory.hpp"
+#include "debug_config.hpp"
+
+namespace {
+
+// The include closure of a header, one path per line
+std::vector<std::string> readClosure(const std::string& closurePath) {
+    std::vector<std::string> closure;
+    auto listing = llvm::MemoryBuffer::getFile(closurePath);
+    if (!listing) {
+        return closure;
+    }
+    llvm::SmallVector<llvm::StringRef, 64> lines;
+    (*listing)->getBuffer().split(lines, '\n', -1, /*KeepEmpty=*/false);
+    for (llvm::StringRef line : lines) {
+        closure.push_back(line.str());
+    }
+    return closure;
+}
+
+// Every file the parse read, as an absolute path, in a stable order
+std::vector<std::string> closureOf(clang::ASTUnit& unit) {
+    std::vector<std::string> closure;
+    clang::SourceManager& sourceManager = unit.getSourceManager();
+    for (auto it = sourceManager.fileinfo_begin(); it != sourceManager.fileinfo_end(); ++it) {
+        llvm::StringRef realPath = it->first->tryGetRealPathName();
+        closure.push_back((realPath.empty() ? it->first->getName() : realPath).str());
+    }
+    std::sort(closure.begin(), closure.end());
+    closure.erase(std::unique(closure.begin(), closure.end()), closure.end());
+    return closure;
+}
+
+}
+
+AstFileCache::AstFileCache(std::string directory, uint64_t capacityBytes)
+    : m_directory(std::move(directory)), m_capacityBytes(capacityBytes) {}
+
+void AstFileCache::disableInputValidation() {
+    // The content keys stand in for the timestamp checks
+    setenv("LIBCLANG_DISABLE_PCH_VALIDATION", "1", /*overwrite=*/0);
+}
+
+std::string AstFileCache::defaultDirectory() {
+    return userCacheDirectory("ast");
+}
+
+std::string AstFileCache::closureKey(const std::string& file, const std::vector<std::string>& flags) {
+    std::string keyText = clang::getClangFullVersion() + '\n' + file + '\n';
+    for (const auto& flag : flags) {
+        keyText += flag + '\n';
+    }
+    return llvm::utohexstr(llvm::xxHash64(keyText), /*LowerCase=*/true);
+}
+
+std::optional<std::string> AstFileCache::contentKey(const std::string& closureKey,
+                                                    const std::vector<std::string>& closure,
+                                                    FileDigestCache& fileDigests) {
+    std::string keyText = closureKey + '\n';
+    for (const auto& path : closure) {
+        std::optional<FileDigest> digest = fileDigests.digest(path);
+        if (!digest) {
+            return std::nullopt;
+        }
+        keyText += path + ' ' + std::to_string(digest->size) + ' ' + llvm::utohexstr(digest->hash) + '\n';
+    }
+    return llvm::utohexstr(llvm::xxHash64(keyText), /*LowerCase=*/true);
+}
+
+std::unique_ptr<clang::ASTUnit> AstFileCache::load(ArmorContext& context, const std::string& file,
+                                                   const std::vector<std::string>& flags,
+                                                   FileDigestCache& fileDigests,
+                                                   std::vector<std::string>* loadedClosure) {
+    const std::string key = closureKey(file, flags);
+    std::vector<std::string> closure = readClosure(m_directory + "/" + key + ".closure");
+    std::optional<std::string> content = closure.empty() ? std::nullopt : contentKey(key, closure, fileDigests);
+    const std::string astPath = content ? m_directory + "/" + *content + ".ast" : std::string();
+    if (astPath.empty() || !llvm::sys::fs::exists(astPath)) {
+        ++m_misses;
+        return nullptr;
+    }
+
+    // The normalizers report problems of their own; the AST's are those of a clean parse
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diagnostics = clang::CompilerInstance::createDiagnostics(
+        new clang::DiagnosticOptions(), new clang::IgnoringDiagConsumer(), /*ShouldOwnClient=*/true);
+    auto pchContainerOps = std::make_shared<clang::PCHContainerOperations>();
+    std::unique_ptr<clang::ASTUnit> unit = clang::ASTUnit::LoadFromASTFile(
+        astPath, pchContainerOps->getRawReader(), clang::ASTUnit::LoadEverything, diagnostics,
+        clang::FileSystemOptions());
+    if (!unit) {
+        context.debug().log("Cannot load cached AST " + astPath + "; parsing " + file + " instead",
+                            DebugConfig::Level::ERROR);
+        llvm::sys::fs::remove(astPath);
+        ++m_misses;
+        return nullptr;
+    }
+
+    // Marks the entry as recently used
+    std::error_code ec;
+    std::filesystem::last_write_time(astPath, std::filesystem::file_time_type::clock::now(), ec);
+    context.debug().log("Loaded AST of " + file + " from " + astPath, DebugConfig::Level::INFO);
+    ++m_hits;
+    if (loadedClosure) {
+        *loadedClosure = std::move(closure);
+    }
+    return unit;
+}
+
+void AstFileCache::store(ArmorContext& context, const std::string& file, const std::vector<std::string>& flags,
+                         clang::ASTUnit& unit, FileDigestCache& fileDigests,
+                         std::vector<std::string>* storedClosure) {
+    const std::string key = closureKey(file, flags);
+    std::vector<std::string> closure = closureOf(unit);
+    if (storedClosure) {
+        *storedClosure = closure;
+    }
+    std::optional<std::string> content = contentKey(key, closure, fileDigests);
+    if (!content) {
+        return;
+    }
+    if (std::error_code ec = llvm::sys::fs::create_directories(m_directory)) {
+        context.debug().log("Cannot create AST cache directory " + m_directory + ": " + ec.message(),
+                            DebugConfig::Level::ERROR);
+        return;
+    }
+
+    const std::string closurePath = m_directory + "/" + key + ".closure";
+    std::string closureText;
+    for (const auto& path : closure) {
+        closureText += path + '\n';
+    }
+    if (llvm::Error error = llvm::writeFileAtomically(closurePath + ".tmp%%%%%%", closurePath, closureText)) {
+        context.debug().log("Cannot write " + closurePath + ": " + llvm::toString(std::move(error)),
+                            DebugConfig::Level::ERROR);
+        return;
+    }
+    // Saved under a temporary name and renamed, so a concurrent load never sees half a file
+    const std::string astPath = m_directory + "/" + *content + ".ast";
+    if (unit.Save(astPath)) {
+        context.debug().log("Cannot write " + astPath, DebugConfig::Level::ERROR);
+        return;
+    }
+    context.debug().log("Stored AST of " + file + " in " + astPath + " (" + std::to_string(closure.size()) +
+                        " files in its include closure)", DebugConfig::Level::INFO);
+    ++m_stored;
+    evict(context);
+}
+
+void AstFileCache::evict(ArmorContext& context) {
+    std::scoped_lock<std::mutex> lock(m_evictMutex);
+    struct Entry {
+        std::filesystem::path path;
+        std::filesystem::file_time_type lastUsed;
+        uint64_t size;
+    };
+    std::vector<Entry> entries;
+    uint64_t total = 0;
+    std::error_code ec;
+    for (std::filesystem::directory_iterator it(m_directory, ec), end; !ec && it != end; it.increment(ec)) {
+        if (it->path().extension() != ".ast") {
+            continue;
+        }
+        std::error_code entryError;
+        uint64_t size = it->file_size(entryError);
+        std::filesystem::file_time_type lastUsed = it->last_write_time(entryError);
+        // Another run may have evicted it meanwhile
+        if (entryError) {
+            continue;
+        }
+        entries.push_back({it->path(), lastUsed, size});
+        total += size;
+    }
+    if (total <= m_capacityBytes) {
+        return;
+    }
+
+    std::sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) {
+        return a.lastUsed < b.lastUsed;
+    });
+    unsigned evicted = 0;
+    for (const auto& entry : entries) {
+        if (total <= m_capacityBytes) {
+            break;
+        }
+        std::error_code removeError;
+        std::filesystem::remove(entry.path, removeError);
+        total -= entry.size;
+        ++evicted;
+    }
+    context.debug().log("Evicted " + std::to_string(evicted) + " least recently used ASTs from " + m_directory,
+                        DebugConfig::Level::INFO);
+}
@@ -0,0 +1,100 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/xxhash.h"
+
+#include "base_context_cache.hpp"
+
+BaseContextCache::BaseContextCache(size_t capacity) : m_capacity(capacity) {}
+
+std::string BaseContextCache::makeKey(const std::string& fileName, const std::vector<std::string>& flags) {
+    std::string key = fileName;
+    for (const auto& flag : flags) {
+        key += '\n' + flag;
+    }
+    return key;
+}
+
+std::optional<std::string> BaseContextCache::contentKey(const std::string& key,
+                                                        const std::vector<std::string>& closure,
+                                                        FileDigestCache& fileDigests) {
+    std::string keyText = key + '\n';
+    for (const auto& path : closure) {
+        std::optional<FileDigest> digest = fileDigests.digest(path);
+        if (!digest) {
+            return std::nullopt;
+        }
+        keyText += path + ' ' + std::to_string(digest->size) + ' ' + llvm::utohexstr(digest->hash) + '\n';
+    }
+    return llvm::utohexstr(llvm::xxHash64(keyText), /*LowerCase=*/true);
+}
+
+std::optional<BaseContextCache::Entry> BaseContextCache::lookup(const std::string& key,
+                                                                FileDigestCache& fileDigests) {
+    std::vector<std::string> closure;
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        auto it = m_closures.find(key);
+        if (it != m_closures.end()) {
+            closure = it->second.files;
+        }
+    }
+    // Files are hashed outside the lock; the digest cache is the request's own
+    std::optional<std::string> content = closure.empty() ? std::nullopt : contentKey(key, closure, fileDigests);
+
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    auto it = content ? m_index.find(*content) : m_index.end();
+    if (it == m_index.end()) {
+        ++m_misses;
+        return std::nullopt;
+    }
+    ++m_hits;
+    m_lru.splice(m_lru.begin(), m_lru, it->second);
+    return it->second->entry;
+}
+
+void BaseContextCache::insert(const std::string& key, std::vector<std::string> closure, Entry entry,
+                              FileDigestCache& fileDigests) {
+    if (m_capacity == 0) {
+        return;
+    }
+    std::sort(closure.begin(), closure.end());
+    closure.erase(std::unique(closure.begin(), closure.end()), closure.end());
+    std::optional<std::string> content = contentKey(key, closure, fileDigests);
+    if (!content) {
+        return;
+    }
+
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_closures[key] = Closure{std::move(closure), *content};
+    auto it = m_index.find(*content);
+    if (it != m_index.end()) {
+        // Another request parsed the same header meanwhile; keep the newer trees
+        it->second->entry = std::move(entry);
+        m_lru.splice(m_lru.begin(), m_lru, it->second);
+        return;
+    }
+    m_lru.push_front(Slot{*content, key, std::move(entry)});
+    m_index[*content] = m_lru.begin();
+    if (m_lru.size() > m_capacity) {
+        const Slot& evicted = m_lru.back();
+        // A closure goes with the entry it leads to, so neither outgrows the capacity
+        auto closure = m_closures.find(evicted.key);
+        if (closure != m_closures.end() && closure->second.contentKey == evicted.contentKey) {
+            m_closures.erase(closure);
+        }
+        m_index.erase(evicted.contentKey);
+        m_lru.pop_back();
+    }
+}
+
+size_t BaseContextCache::size() const {
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    return m_lru.size();
+}
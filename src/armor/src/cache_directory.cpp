@@ -0,0 +1,23 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cstdlib>
+#include <string>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/Path.h"
+
+#include "cache_directory.hpp"
+
+std::string userCacheDirectory(const std::string& kind) {
+    llvm::SmallString<256> directory;
+    if (const char* cacheHome = std::getenv("XDG_CACHE_HOME"); cacheHome && *cacheHome) {
+        directory = cacheHome;
+    } else if (llvm::sys::path::home_directory(directory)) {
+        llvm::sys::path::append(directory, ".cache");
+    } else {
+        llvm::sys::path::system_temp_directory(/*ErasedOnReboot=*/false, directory);
+    }
+    llvm::sys::path::append(directory, "armor", kind);
+    return directory.str().str();
+}
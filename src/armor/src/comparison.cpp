@@ -0,0 +1,451 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <functional>
+#include <future>
+#include <memory>
+#include <optional>
+#include <set>
+#include <string>
+#include <system_error>
+#include <vector>
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/Threading.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "beta/include/api_snapshot.hpp"
+#include "ast_cache.hpp"
+#include "comparison.hpp"
+#include "compile_commands.hpp"
+#include "file_digest.hpp"
+#include "git_source_tree.hpp"
+#include "header_discovery.hpp"
+#include "isolated_runner.hpp"
+#include "manifest.hpp"
+#include "output_layout.hpp"
+#include "prelude_pch.hpp"
+#include "shared_parser.hpp"
+#include "user_print.hpp"
+
+namespace {
+
+bool sourceExists(ArmorContext &context, const std::string &path) {
+    if (llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> sources = context.sourceFileSystem()) {
+        return sources->exists(path);
+    }
+    return std::filesystem::exists(path);
+}
+
+// Headers added or removed between two git revisions are compared against an
+// empty file, so everything they declare shows up as added or removed.
+void addEmptyCounterparts(GitSourceTrees &trees, ArmorContext &context, const std::vector<HeaderPair> &pairs) {
+    for (const auto &pair : pairs) {
+        bool exists1 = pair.size1 || sourceExists(context, pair.file1);
+        bool exists2 = pair.size2 || sourceExists(context, pair.file2);
+        if (exists1 == exists2) {
+            continue;
+        }
+        const std::string &missing = exists1 ? pair.file2 : pair.file1;
+        context.debug().log("Header missing in " + std::string(exists1 ? "newer" : "older") +
+                            " revision, comparing against an empty file: " + missing,
+                            DebugConfig::Level::INFO);
+        trees.addEmptyFile(missing);
+    }
+}
+
+// Path of a header relative to a project root, or to the snapshot standing in for one
+std::string relativeHeaderPath(const std::string &projectRoot, const std::string &file) {
+    return std::filesystem::path(file).lexically_normal()
+        .lexically_relative(std::filesystem::path(projectRoot).lexically_normal())
+        .generic_string();
+}
+
+// Snapshot headers below headerSubDir that pass the filter, paired with their
+// counterparts in the newer project root
+std::vector<HeaderPair> snapshotHeaderPairs(const beta::ApiSnapshot &baseline, const std::string &snapshotPath,
+                                            const std::string &projectRoot2, const std::string &headerSubDir,
+                                            const HeaderFilter &filter) {
+    std::vector<HeaderPair> pairs;
+    const std::string prefix = headerSubDir + "/";
+    for (llvm::StringRef header : baseline.headers()) {
+        if (!header.startswith(prefix) || !filter.matches(header.drop_front(prefix.size()))) {
+            continue;
+        }
+        std::string name = header.drop_front(prefix.size()).str();
+        pairs.push_back({name, snapshotPath + "/" + header.str(), projectRoot2 + "/" + header.str(), {}, {}});
+    }
+    return pairs;
+}
+
+// Compares one header pair: v1 first and, if it parsed without fatal errors, v2,
+// both fed from the same parse of each header. Against a snapshot, only the
+// newer header is parsed and compared with v2.
+PairOutcome processHeaderPair(const std::string &projectRoot1, const std::string &projectRoot2,
+                       const HeaderPair &pair, const std::string &reportFormat,
+                       const std::vector<std::string> &IncludePaths,
+                       const std::vector<std::string> &macros,
+                       FileDigestCache &fileDigests,
+                       ArmorContext &context, bool dumpAstDiff,
+                       BaseContextCache *baseCache, PreludePchCache *prelude,
+                       AstFileCache *astCache, const beta::ApiSnapshot *baseline,
+                       beta::ApiSnapshotWriter *snapshot) {
+    // Pairs run on pool threads, which start without the run's DebugConfig
+    ScopedDebugConfig debugScope(context.debug());
+    const std::string &file1 = pair.file1;
+    const std::string &file2 = pair.file2;
+    USER_PRINT(std::string("Processing files: ") + file1 + " " + file2);
+    std::string header;
+    std::optional<FileDigest> baselineDigest;
+    if (baseline) {
+        header = relativeHeaderPath(projectRoot1, file1);
+        baselineDigest = baseline->digest(header);
+    }
+    // Pairs from --header-dir discovery come with both files already stat'ed
+    if (baseline ? !baselineDigest : !pair.size1 && !sourceExists(context, file1)) {
+        USER_ERROR(std::string("Missing header in older version: ") + file1);
+        return PairOutcome::MissingOld;
+    }
+    if (!pair.size2 && !sourceExists(context, file2)) {
+        USER_ERROR(std::string("Missing header in newer version: ") + file2);
+        return PairOutcome::MissingNew;
+    }
+    bool unchanged;
+    if (baseline) {
+        std::optional<FileDigest> digest2 = fileDigests.digest(file2);
+        unchanged = digest2 && digest2->size == baselineDigest->size && digest2->hash == baselineDigest->hash;
+    } else {
+        bool sizesDiffer = pair.size1 && pair.size2 && *pair.size1 != *pair.size2;
+        unchanged = !sizesDiffer && !fileDigests.filesDiffer(file1, file2);
+    }
+    // A snapshot being written needs the tree of every newer header
+    if (unchanged && !snapshot) {
+        USER_PRINT(std::string("No differences found between: ") + file1 + " and " + file2);
+        return PairOutcome::Unchanged;
+    }
+
+    // Manifest entries may add their own include paths and macros to the global ones
+    std::vector<std::string> pairIncludePaths = IncludePaths;
+    pairIncludePaths.insert(pairIncludePaths.end(), pair.includePaths.begin(), pair.includePaths.end());
+    std::vector<std::string> pairMacros = macros;
+    pairMacros.insert(pairMacros.end(), pair.macros.begin(), pair.macros.end());
+
+    PARSING_STATUS parsingStatus = baseline
+        ? processHeaderAgainstSnapshot(context, *baseline, projectRoot1, header, projectRoot2, file2,
+                                       reportFormat, pairIncludePaths, pairMacros, fileDigests, prelude, snapshot)
+        : processHeaderPairShared(context, projectRoot1, file1, projectRoot2, file2,
+                                  reportFormat, pairIncludePaths, pairMacros,
+                                  fileDigests, baseCache, prelude, astCache, snapshot);
+
+    // Only this pair's dump is removed, so runs sharing an output tree keep theirs
+    if (!dumpAstDiff) {
+        std::error_code ec;
+        std::filesystem::remove(context.output().astDiffPath(reportNameForHeader(projectRoot1, file1)), ec);
+    }
+    return parsingStatus == NO_FATAL_ERRORS ? PairOutcome::Compared : PairOutcome::ComparedWithErrors;
+}
+
+// Runs every pair through processPair, on a pool of `jobs` threads when jobs > 1,
+// and returns the outcomes in input order. Each pair's console output is captured
+// and replayed in input order, so the terminal shows exactly what a serial run would print.
+std::vector<PairOutcome> processHeaderPairs(const std::vector<HeaderPair> &pairs, unsigned jobs,
+                                            const std::string &projectRoot1,
+                                            const std::function<PairOutcome(const HeaderPair &)> &processPair) {
+    std::vector<PairOutcome> outcomes;
+    outcomes.reserve(pairs.size());
+    if (jobs <= 1 || pairs.size() <= 1) {
+        for (const auto &pair : pairs) {
+            outcomes.push_back(processPair(pair));
+        }
+        return outcomes;
+    }
+
+    std::vector<std::vector<size_t>> groups = groupPairsByReport(pairs, projectRoot1);
+
+    std::vector<ConsoleCapture> captures(pairs.size());
+    std::vector<PairOutcome> results(pairs.size(), PairOutcome::Unchanged);
+    std::vector<std::shared_future<void>> done(pairs.size());
+
+    llvm::ThreadPool pool(llvm::hardware_concurrency(jobs));
+    for (const auto &group : groups) {
+        std::shared_future<void> future = pool.async([&, group]() {
+            for (size_t i : group) {
+                ScopedConsoleCapture capture(captures[i]);
+                results[i] = processPair(pairs[i]);
+            }
+        });
+        for (size_t i : group) {
+            done[i] = future;
+        }
+    }
+
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        done[i].wait();
+        captures[i].replay();
+        done[i].get();
+        outcomes.push_back(results[i]);
+    }
+    return outcomes;
+}
+
+}
+
+void applyLogLevel(DebugConfig &debug, const std::string &logLevel) {
+    if (logLevel == "DEBUG") {
+        debug.setLevel(DebugConfig::Level::DEBUG);
+        debug.log("Debug level set to DEBUG", DebugConfig::Level::INFO);
+    } else if (logLevel == "INFO") {
+        debug.setLevel(DebugConfig::Level::INFO);
+        debug.log("Debug level set to INFO", DebugConfig::Level::INFO);
+    } else if (logLevel == "LOG") {
+        debug.setLevel(DebugConfig::Level::LOG);
+        debug.log("Debug level set to LOG", DebugConfig::Level::INFO);
+    } else if (logLevel == "ERROR") {
+        debug.setLevel(DebugConfig::Level::ERROR);
+        debug.log("Debug level set to ERROR", DebugConfig::Level::INFO);
+    }
+}
+
+bool runComparison(const ComparisonRequest &request, ArmorContext &context, BaseContextCache *baseCache) {
+    std::string projectRoot1 = request.projectRoot1;
+    std::string projectRoot2 = request.projectRoot2;
+    std::unique_ptr<GitSourceTrees> gitTrees;
+    if (!request.gitRepo.empty()) {
+        std::string error;
+        gitTrees = GitSourceTrees::open(request.gitRepo, request.oldRev, request.newRev, error);
+        if (!gitTrees) {
+            USER_ERROR(error);
+            return false;
+        }
+        projectRoot1 = gitTrees->oldRoot();
+        projectRoot2 = gitTrees->newRoot();
+        context.setSourceFileSystem(gitTrees->fileSystem());
+        context.debug().log("Reading " + request.oldRev + " from " + projectRoot1 + " and " + request.newRev +
+                            " from " + projectRoot2, DebugConfig::Level::INFO);
+    }
+    // The cat-file process ends with the last user of the trees
+    auto dropSources = llvm::make_scope_exit([&]() {
+        if (gitTrees) {
+            context.debug().log("Read " + std::to_string(gitTrees->blobsRead()) + " blobs from " + request.gitRepo,
+                                DebugConfig::Level::INFO);
+            context.setSourceFileSystem(nullptr);
+        }
+    });
+    // An API snapshot may stand in for the older project root
+    std::unique_ptr<beta::ApiSnapshot> baseline;
+    if (!gitTrees && beta::ApiSnapshot::isSnapshot(projectRoot1)) {
+        std::string error;
+        baseline = beta::ApiSnapshot::open(projectRoot1, error);
+        if (!baseline) {
+            USER_ERROR(error);
+            return false;
+        }
+        context.debug().log("Comparing against the API snapshot " + projectRoot1 + " of " +
+                            std::to_string(baseline->headers().size()) + " headers", DebugConfig::Level::INFO);
+    }
+    const std::string &headerSubDir = request.headerSubDir;
+    unsigned jobs = request.jobs;
+    if (jobs == 0) {
+        jobs = llvm::hardware_concurrency().compute_thread_count();
+    }
+
+    // Headers are read through the revisions of a git repository, or from disk
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> sourceFileSystem = context.sourceFileSystem();
+    if (!sourceFileSystem) {
+        sourceFileSystem = llvm::vfs::createPhysicalFileSystem();
+    }
+
+    std::vector<HeaderPair> pairs;
+    if (!request.headers.empty()) {
+        for (const auto &header : request.headers) {
+            std::string file1, file2;
+            if (!headerSubDir.empty()) {
+                file1 = projectRoot1 + "/" + headerSubDir + "/" + header;
+                file2 = projectRoot2 + "/" + headerSubDir + "/" + header;
+            } else {
+                file1 = projectRoot1 + "/" + header;
+                file2 = projectRoot2 + "/" + header;
+            }
+            pairs.push_back({header, file1, file2, {}, {}});
+        }
+    }
+    if (!request.manifestPath.empty()) {
+        if (!loadManifest(request.manifestPath, projectRoot1, projectRoot2, headerSubDir, pairs)) {
+            return false;
+        }
+    }
+    else if (request.headers.empty() && !headerSubDir.empty()) {
+        std::string error;
+        std::unique_ptr<HeaderFilter> filter = HeaderFilter::create(request.headerGlobs, request.excludeGlobs, error);
+        if (!filter) {
+            USER_ERROR(error);
+            return false;
+        }
+        pairs = baseline ? snapshotHeaderPairs(*baseline, projectRoot1, projectRoot2, headerSubDir, *filter)
+                         : discoverHeaderPairs(projectRoot1, projectRoot2, headerSubDir, *filter, *sourceFileSystem);
+        USER_PRINT("List of headers to process:");
+        for (const auto &pair : pairs) {
+            USER_PRINT(std::string("  ") + pair.name);
+        }
+    }
+
+    if (gitTrees) {
+        addEmptyCounterparts(*gitTrees, context, pairs);
+    }
+
+    // Each header gets the flags of its best-matching translation unit; the
+    // database describes the newer tree, or the work tree of the repository
+    size_t buildFlagSets = 0;
+    if (!request.buildDir.empty()) {
+        std::string error;
+        std::unique_ptr<CompileCommandsFlags> buildFlags =
+            CompileCommandsFlags::load(request.buildDir, gitTrees ? request.gitRepo : projectRoot2, error);
+        if (!buildFlags) {
+            USER_ERROR(error);
+            return false;
+        }
+        buildFlagSets = buildFlags->apply(context, projectRoot2, pairs);
+    }
+
+    // Include probes into the project trees are answered from directory listings
+    if (!baseline) {
+        context.statCache().addListedRoot(projectRoot1);
+    }
+    context.statCache().addListedRoot(projectRoot2);
+
+    // Clang flags beyond the include paths, shared by every pair
+    std::vector<std::string> macros = request.macros;
+    if (request.skipFunctionBodies) {
+        macros.insert(macros.end(), {"-Xclang", "-skip-function-bodies"});
+    }
+
+    std::unique_ptr<PreludePchCache> prelude;
+    std::vector<std::string> preludeHeaders = request.prelude;
+    if (request.preludeAuto) {
+        std::vector<std::string> headers;
+        for (const auto &pair : pairs) {
+            headers.push_back(pair.file1);
+            headers.push_back(pair.file2);
+        }
+        for (auto &include : PreludePchCache::detectPrelude(*sourceFileSystem, headers)) {
+            if (std::find(preludeHeaders.begin(), preludeHeaders.end(), include) == preludeHeaders.end()) {
+                context.debug().log("Prelude header detected: " + include, DebugConfig::Level::INFO);
+                preludeHeaders.push_back(std::move(include));
+            }
+        }
+    }
+    if (!preludeHeaders.empty()) {
+        prelude = std::make_unique<PreludePchCache>(PreludePchCache::defaultDirectory(), std::move(preludeHeaders));
+        // Built up front for the run's own flags, so forked workers inherit them
+        // instead of racing to build the same files; manifest flags build theirs on first use
+        if (!baseline) {
+            prelude->flagsFor(context, projectRoot1, {}, request.includePaths, macros);
+        }
+        prelude->flagsFor(context, projectRoot2, {}, request.includePaths, macros);
+        // Flag sets from the compilation database are shared by many headers, so they are built up front too
+        if (buildFlagSets > 0) {
+            std::set<std::pair<std::vector<std::string>, std::vector<std::string>>> warmed;
+            for (const auto &pair : pairs) {
+                if (pair.includePaths.empty() && pair.macros.empty()) {
+                    continue;
+                }
+                std::vector<std::string> pairIncludePaths = request.includePaths;
+                pairIncludePaths.insert(pairIncludePaths.end(), pair.includePaths.begin(), pair.includePaths.end());
+                std::vector<std::string> pairMacros = macros;
+                pairMacros.insert(pairMacros.end(), pair.macros.begin(), pair.macros.end());
+                if (!warmed.emplace(pairIncludePaths, pairMacros).second) {
+                    continue;
+                }
+                if (!baseline) {
+                    prelude->flagsFor(context, projectRoot1, {}, pairIncludePaths, pairMacros);
+                }
+                prelude->flagsFor(context, projectRoot2, {}, pairIncludePaths, pairMacros);
+            }
+        }
+    }
+
+    std::unique_ptr<AstFileCache> astCache;
+    if (request.astCache) {
+        astCache = std::make_unique<AstFileCache>(AstFileCache::defaultDirectory(),
+                                                  uint64_t(request.astCacheSizeMb) << 20);
+    }
+
+    std::unique_ptr<beta::ApiSnapshotWriter> snapshot;
+    if (!request.emitSnapshot.empty()) {
+        // Trees parsed in a forked worker never reach this process
+        if (request.isolate) {
+            USER_ERROR("An API snapshot cannot be written from isolated workers; run without --isolate");
+            return false;
+        }
+        snapshot = std::make_unique<beta::ApiSnapshotWriter>();
+    }
+
+    // Digests of every header read while comparing, kept for the rest of the run
+    FileDigestCache fileDigests(context.sourceFileSystem());
+    auto processPair = [&](const HeaderPair &pair) {
+        return processHeaderPair(projectRoot1, projectRoot2, pair, request.reportFormat, request.includePaths,
+                                 macros, fileDigests, context, request.dumpAstDiff, baseCache,
+                                 prelude.get(), astCache.get(), baseline.get(), snapshot.get());
+    };
+    std::vector<PairOutcome> outcomes = request.isolate
+        ? processHeaderPairsIsolated(pairs, jobs, projectRoot1, std::chrono::seconds(request.isolateTimeoutSec),
+                                     processPair)
+        : processHeaderPairs(pairs, jobs, projectRoot1, processPair);
+    bool processed = std::any_of(outcomes.begin(), outcomes.end(), [](PairOutcome outcome) {
+        return outcome == PairOutcome::Compared || outcome == PairOutcome::ComparedWithErrors;
+    });
+
+    if (snapshot) {
+        std::string error;
+        if (!snapshot->write(request.emitSnapshot, error)) {
+            USER_ERROR(error);
+        } else {
+            USER_PRINT("API snapshot of " + std::to_string(snapshot->size()) + " headers written to " +
+                       request.emitSnapshot);
+        }
+    }
+
+    // A manifest run fails if its status cannot be written
+    bool statusWritten = true;
+    if (!request.manifestPath.empty()) {
+        std::string manifestStatusPath = request.manifestStatusPath.empty()
+            ? context.output().path("armor_reports/manifest_status.json")
+            : request.manifestStatusPath;
+        statusWritten = writeManifestStatus(manifestStatusPath, pairs, outcomes, request.reportFormat,
+                                            projectRoot1, context.output());
+    }
+
+    const StatCache &statCache = context.statCache();
+    uint64_t statCalls = statCache.hits() + statCache.misses();
+    if (statCalls > 0) {
+        context.debug().log("Stat cache: " + std::to_string(statCache.hits()) + " of " + std::to_string(statCalls) +
+                            " stat and open calls answered (" +
+                            std::to_string(statCache.hits() * 100 / statCalls) + "%)",
+                            DebugConfig::Level::INFO);
+    }
+    if (statCache.probesSaved() > 0) {
+        context.debug().log("Include search: " + std::to_string(statCache.probesSaved()) +
+                            " probes answered from directory listings", DebugConfig::Level::INFO);
+    }
+
+    if (prelude) {
+        context.debug().log("Precompiled prelude: " + std::to_string(prelude->built()) + " built, " +
+                            std::to_string(prelude->reused()) + " reused", DebugConfig::Level::INFO);
+    }
+
+    if (astCache) {
+        context.debug().log("AST cache: " + std::to_string(astCache->hits()) + " loaded, " +
+                            std::to_string(astCache->misses()) + " parsed, " +
+                            std::to_string(astCache->stored()) + " stored", DebugConfig::Level::INFO);
+    }
+
+    if (processed && !request.dumpAstDiff) {
+        // Fails harmlessly while another run sharing the output tree still has dumps there
+        std::error_code ec;
+        std::filesystem::remove(context.output().astDiffDir(), ec);
+    }
+    return processed && statusWritten;
+}
@@ -0,0 +1,208 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <filesystem>
+#include <set>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Tooling/JSONCompilationDatabase.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "compile_commands.hpp"
+#include "debug_config.hpp"
+#include "parse_utils.hpp"
+
+namespace {
+
+// Absolute, without dots and, where the path exists, without symlinks
+std::string canonicalPath(llvm::StringRef path, llvm::StringRef baseDir) {
+    llvm::SmallString<256> absolute(path);
+    llvm::sys::fs::make_absolute(baseDir, absolute);
+    llvm::sys::path::remove_dots(absolute, /*remove_dot_dot=*/true);
+    llvm::SmallString<256> real;
+    if (!llvm::sys::fs::real_path(absolute, real)) {
+        return real.str().str();
+    }
+    return absolute.str().str();
+}
+
+// Flags taken from a command line whose value may be joined or the next argument
+enum class ValueFlag { None, Include, Search, Macro, ForcedInclude, Language, Target, Skipped };
+
+ValueFlag valueFlag(llvm::StringRef arg, llvm::StringRef& name) {
+    // Longest spellings first, so "-isystem" is not read as "-i" + "system"
+    static const std::pair<llvm::StringRef, ValueFlag> kFlags[] = {
+        {"-idirafter", ValueFlag::Search}, {"-isystem", ValueFlag::Search}, {"-iquote", ValueFlag::Search},
+        {"-imacros", ValueFlag::ForcedInclude}, {"-include", ValueFlag::ForcedInclude},
+        {"-target", ValueFlag::Target}, {"-I", ValueFlag::Include}, {"-D", ValueFlag::Macro},
+        {"-U", ValueFlag::Macro}, {"-x", ValueFlag::Language},
+        // Outputs and dependency files, whose values must not be read as inputs
+        {"-MF", ValueFlag::Skipped}, {"-MT", ValueFlag::Skipped}, {"-MQ", ValueFlag::Skipped},
+        {"-o", ValueFlag::Skipped},
+    };
+    for (const auto& flag : kFlags) {
+        if (arg.startswith(flag.first)) {
+            name = flag.first;
+            return flag.second;
+        }
+    }
+    return ValueFlag::None;
+}
+
+// Value-less flags that change what a header declares
+bool keepsFlag(llvm::StringRef arg) {
+    if (arg.startswith("-std=") || arg.startswith("--std=") || arg.startswith("--target=") ||
+        arg.startswith("-fpack-struct=") || arg.startswith("-fms-compatibility-version=")) {
+        return true;
+    }
+    return llvm::StringSwitch<bool>(arg)
+        .Cases("-m32", "-m64", "-fms-extensions", "-fms-compatibility", "-fno-rtti", "-fno-exceptions", true)
+        .Cases("-fchar8_t", "-fno-char8_t", "-fsigned-char", "-funsigned-char", "-fshort-wchar", true)
+        .Cases("-fshort-enums", "-fopenmp", "-fgnu-keywords", "-fno-gnu-keywords", "-fblocks", true)
+        .Default(false);
+}
+
+bool isWithin(llvm::StringRef path, llvm::StringRef dir) {
+    return path == dir || (path.consume_front(dir) && path.startswith("/"));
+}
+
+bool isProjectPath(llvm::StringRef path, llvm::StringRef sourceRoot, llvm::StringRef buildDir) {
+    return isWithin(path, sourceRoot) && !isWithin(path, buildDir);
+}
+
+// Include directories and files inside the source root become relative to it,
+// except those of the build tree, whose generated headers only one project root has
+HeaderBuildFlags extractFlags(const clang::tooling::CompileCommand& command, llvm::StringRef sourceRoot,
+                              llvm::StringRef buildDir) {
+    HeaderBuildFlags result;
+    const std::vector<std::string>& args = command.CommandLine;
+    // The first argument is the compiler
+    for (size_t i = 1; i < args.size(); ++i) {
+        llvm::StringRef arg = args[i];
+        llvm::StringRef name;
+        ValueFlag kind = valueFlag(arg, name);
+        if (kind == ValueFlag::None) {
+            if (keepsFlag(arg)) {
+                result.flags.push_back(arg.str());
+            }
+            continue;
+        }
+        std::string value;
+        if (arg.size() > name.size()) {
+            value = arg.drop_front(name.size()).str();
+        } else if (i + 1 < args.size()) {
+            value = args[++i];
+        } else {
+            break;
+        }
+
+        switch (kind) {
+        case ValueFlag::Include: {
+            std::string dir = canonicalPath(value, command.Directory);
+            if (!isProjectPath(dir, sourceRoot, buildDir)) {
+                result.flags.push_back("-I" + dir);
+            } else if (dir.size() == sourceRoot.size()) {
+                result.includePaths.push_back(".");
+            } else {
+                result.includePaths.push_back(dir.substr(sourceRoot.size() + 1));
+            }
+            break;
+        }
+        case ValueFlag::Search:
+        case ValueFlag::ForcedInclude: {
+            std::string path = canonicalPath(value, command.Directory);
+            result.flags.push_back(name.str());
+            if (isProjectPath(path, sourceRoot, buildDir)) {
+                result.flags.push_back(kProjectRootVariable + path.substr(sourceRoot.size()));
+            } else {
+                result.flags.push_back(std::move(path));
+            }
+            break;
+        }
+        case ValueFlag::Macro:
+        case ValueFlag::Language:
+            result.flags.push_back(name.str() + value);
+            break;
+        case ValueFlag::Target:
+            result.flags.push_back("--target=" + value);
+            break;
+        case ValueFlag::Skipped:
+        case ValueFlag::None:
+            break;
+        }
+    }
+    return result;
+}
+
+}
+
+std::unique_ptr<CompileCommandsFlags> CompileCommandsFlags::load(const std::string& buildDir,
+                                                                 const std::string& sourceRoot,
+                                                                 std::string& error) {
+    llvm::SmallString<256> path(buildDir);
+    llvm::sys::path::append(path, "compile_commands.json");
+    std::string loadError;
+    std::unique_ptr<clang::tooling::JSONCompilationDatabase> database =
+        clang::tooling::JSONCompilationDatabase::loadFromFile(
+            path, loadError, clang::tooling::JSONCommandLineSyntax::Gnu);
+    if (!database) {
+        error = "Cannot read compilation database " + path.str().str() + ": " + loadError;
+        return nullptr;
+    }
+    if (database->getAllFiles().empty()) {
+        error = "Compilation database " + path.str().str() + " has no entries";
+        return nullptr;
+    }
+    llvm::SmallString<256> currentDir;
+    llvm::sys::fs::current_path(currentDir);
+    return std::unique_ptr<CompileCommandsFlags>(new CompileCommandsFlags(
+        clang::tooling::inferMissingCompileCommands(std::move(database)),
+        canonicalPath(sourceRoot, currentDir), canonicalPath(buildDir, currentDir)));
+}
+
+std::optional<HeaderBuildFlags> CompileCommandsFlags::flagsFor(const std::string& relativeHeader) const {
+    llvm::SmallString<256> file(m_sourceRoot);
+    llvm::sys::path::append(file, relativeHeader);
+    std::vector<clang::tooling::CompileCommand> commands = m_database->getCompileCommands(file);
+    if (commands.empty()) {
+        return std::nullopt;
+    }
+    const clang::tooling::CompileCommand& command = commands.front();
+    DebugConfig::instance().log("Flags of " + relativeHeader + ": " +
+                                (command.Heuristic.empty() ? "compile command of " + command.Filename
+                                                           : command.Heuristic),
+                                DebugConfig::Level::DEBUG);
+    return extractFlags(command, m_sourceRoot, m_buildDir);
+}
+
+size_t CompileCommandsFlags::apply(ArmorContext& context, const std::string& projectRoot2,
+                                   std::vector<HeaderPair>& pairs) const {
+    const std::filesystem::path root = std::filesystem::path(projectRoot2).lexically_normal();
+    // Distinct flag sets handed out
+    std::set<HeaderBuildFlags> groups;
+    size_t matched = 0;
+    for (auto& pair : pairs) {
+        std::string header = std::filesystem::path(pair.file2).lexically_normal().lexically_relative(root)
+                                 .generic_string();
+        std::optional<HeaderBuildFlags> flags = flagsFor(header);
+        if (!flags) {
+            context.debug().log("No compile command matches " + header + ", using the global flags",
+                                DebugConfig::Level::INFO);
+            continue;
+        }
+        ++matched;
+        const HeaderBuildFlags& shared = *groups.insert(std::move(*flags)).first;
+        pair.includePaths.insert(pair.includePaths.end(), shared.includePaths.begin(), shared.includePaths.end());
+        pair.macros.insert(pair.macros.end(), shared.flags.begin(), shared.flags.end());
+    }
+    context.debug().log("compile_commands.json: " + std::to_string(matched) + " of " +
+                        std::to_string(pairs.size()) + " headers matched, in " + std::to_string(groups.size()) +
+                        " flag sets", DebugConfig::Level::INFO);
+    return groups.size();
+}
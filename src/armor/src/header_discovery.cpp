@@ -0,0 +1,167 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <future>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+#include "debug_config.hpp"
+#include "header_discovery.hpp"
+#include "user_print.hpp"
+
+namespace {
+
+struct FoundHeader {
+    std::string relativePath;
+    uint64_t size;
+};
+
+bool hasHeaderExtension(llvm::StringRef path) {
+    return llvm::StringSwitch<bool>(llvm::sys::path::extension(path))
+        .Cases(".h", ".hh", ".hpp", ".hxx", ".inl", true)
+        .Default(false);
+}
+
+// Walks dir recursively and returns the matching headers sorted by relative
+// path. Problems are returned in `error` rather than printed, so a walk on a
+// second thread cannot interleave with the console.
+std::vector<FoundHeader> walkHeaders(llvm::vfs::FileSystem& fileSystem, const std::string& dir,
+                                     const HeaderFilter& filter, std::string& error) {
+    std::vector<FoundHeader> found;
+    // Entries are named dir + "/" + name, so dir must be spelled as the file system reports it
+    llvm::SmallString<256> root(dir);
+    llvm::sys::path::remove_dots(root, /*remove_dot_dot=*/true);
+    while (root.size() > 1 && llvm::sys::path::is_separator(root.back())) {
+        root.pop_back();
+    }
+    std::error_code ec;
+    llvm::vfs::recursive_directory_iterator it(fileSystem, root, ec);
+    if (ec) {
+        error = "Cannot read header directory " + dir + ": " + ec.message();
+        return found;
+    }
+    for (llvm::vfs::recursive_directory_iterator end; it != end; it.increment(ec)) {
+        if (ec) {
+            if (ec == std::errc::permission_denied) {
+                ec.clear();
+                continue;
+            }
+            error = "Stopped reading header directory " + dir + ": " + ec.message();
+            break;
+        }
+        llvm::StringRef path = it->path();
+        if (!path.startswith(root)) {
+            continue;
+        }
+        std::string relativePath = llvm::sys::path::convert_to_slash(path.drop_front(root.size()).ltrim("/"));
+        if (!filter.matches(relativePath)) {
+            continue;
+        }
+        // Symlinks to headers count like the headers themselves
+        llvm::ErrorOr<llvm::vfs::Status> status = fileSystem.status(path);
+        if (!status || !status->isRegularFile()) {
+            continue;
+        }
+        found.push_back({std::move(relativePath), status->getSize()});
+    }
+    std::sort(found.begin(), found.end(), [](const FoundHeader& a, const FoundHeader& b) {
+        return a.relativePath < b.relativePath;
+    });
+    return found;
+}
+
+}
+
+std::unique_ptr<HeaderFilter> HeaderFilter::create(const std::vector<std::string>& includeGlobs,
+                                                   const std::vector<std::string>& excludeGlobs,
+                                                   std::string& error) {
+    std::unique_ptr<HeaderFilter> filter(new HeaderFilter());
+    auto compile = [&](const std::vector<std::string>& globs, std::vector<llvm::GlobPattern>& patterns) {
+        for (const auto& glob : globs) {
+            filter->m_patternText.push_back(std::make_unique<std::string>(glob));
+            llvm::Expected<llvm::GlobPattern> pattern = llvm::GlobPattern::create(*filter->m_patternText.back());
+            if (!pattern) {
+                error = "Invalid glob '" + glob + "': " + llvm::toString(pattern.takeError());
+                return false;
+            }
+            patterns.push_back(std::move(*pattern));
+        }
+        return true;
+    };
+    if (!compile(includeGlobs, filter->m_include) || !compile(excludeGlobs, filter->m_exclude)) {
+        return nullptr;
+    }
+    return filter;
+}
+
+bool HeaderFilter::matches(llvm::StringRef relativePath) const {
+    if (!hasHeaderExtension(relativePath)) {
+        return false;
+    }
+    auto matchesAny = [&](const std::vector<llvm::GlobPattern>& patterns) {
+        return std::any_of(patterns.begin(), patterns.end(),
+                           [&](const llvm::GlobPattern& pattern) { return pattern.match(relativePath); });
+    };
+    if (!m_include.empty() && !matchesAny(m_include)) {
+        return false;
+    }
+    return !matchesAny(m_exclude);
+}
+
+std::vector<HeaderPair> discoverHeaderPairs(const std::string& projectRoot1,
+                                            const std::string& projectRoot2,
+                                            const std::string& headerSubDir,
+                                            const HeaderFilter& filter,
+                                            llvm::vfs::FileSystem& fileSystem) {
+    const std::string dir1 = projectRoot1 + "/" + headerSubDir;
+    const std::string dir2 = projectRoot2 + "/" + headerSubDir;
+
+    std::string error1;
+    std::string error2;
+    std::future<std::vector<FoundHeader>> newerWalk = std::async(std::launch::async, [&]() {
+        return walkHeaders(fileSystem, dir2, filter, error2);
+    });
+    std::vector<FoundHeader> older = walkHeaders(fileSystem, dir1, filter, error1);
+    std::vector<FoundHeader> newer = newerWalk.get();
+    for (const std::string* error : {&error1, &error2}) {
+        if (!error->empty()) {
+            USER_ERROR(*error);
+        }
+    }
+
+    llvm::StringMap<uint64_t> newerSizes;
+    for (const auto& header : newer) {
+        newerSizes[header.relativePath] = header.size;
+    }
+
+    std::vector<HeaderPair> pairs;
+    pairs.reserve(older.size());
+    for (const auto& header : older) {
+        HeaderPair pair{header.relativePath, dir1 + "/" + header.relativePath, dir2 + "/" + header.relativePath, {}, {}};
+        pair.size1 = header.size;
+        auto it = newerSizes.find(header.relativePath);
+        if (it != newerSizes.end()) {
+            pair.size2 = it->second;
+            newerSizes.erase(it);
+        }
+        pairs.push_back(std::move(pair));
+    }
+
+    for (const auto& header : newer) {
+        if (newerSizes.count(header.relativePath)) {
+            DebugConfig::instance().log("Header only in newer version: " + dir2 + "/" + header.relativePath,
+                                        DebugConfig::Level::INFO);
+        }
+    }
+    return pairs;
+}
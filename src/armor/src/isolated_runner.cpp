@@ -0,0 +1,393 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <nlohmann/json.hpp>
+#include <poll.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "llvm/Support/raw_ostream.h"
+
+#include "isolated_runner.hpp"
+#include "user_print.hpp"
+
+namespace {
+
+// Consecutive worker deaths with no pair in flight before the run gives up
+constexpr unsigned kMaxIdleDeaths = 3;
+
+struct Worker {
+    pid_t pid = -1;
+    // Supervisor to worker: the pair indices of one group
+    int commandFd = -1;
+    // Worker to supervisor: one result frame per pair
+    int resultFd = -1;
+    // Pairs sent to the worker and not answered yet, in the order it runs them
+    std::deque<size_t> inFlight;
+    // When the pair at the front of inFlight has run too long
+    std::chrono::steady_clock::time_point deadline;
+};
+
+bool writeFull(int fd, const void *data, size_t size) {
+    const char *p = static_cast<const char *>(data);
+    while (size > 0) {
+        ssize_t written = ::write(fd, p, size);
+        if (written < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        p += written;
+        size -= static_cast<size_t>(written);
+    }
+    return true;
+}
+
+// Returns false on end of file or error.
+bool readFull(int fd, void *data, size_t size) {
+    char *p = static_cast<char *>(data);
+    while (size > 0) {
+        ssize_t received = ::read(fd, p, size);
+        if (received < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            return false;
+        }
+        if (received == 0) {
+            return false;
+        }
+        p += received;
+        size -= static_cast<size_t>(received);
+    }
+    return true;
+}
+
+// Frames are a 32-bit length followed by that many bytes of JSON.
+bool writeFrame(int fd, const std::string &payload) {
+    uint32_t size = static_cast<uint32_t>(payload.size());
+    return writeFull(fd, &size, sizeof(size)) && writeFull(fd, payload.data(), payload.size());
+}
+
+bool readFrame(int fd, std::string &payload) {
+    uint32_t size = 0;
+    if (!readFull(fd, &size, sizeof(size))) {
+        return false;
+    }
+    payload.resize(size);
+    return readFull(fd, payload.data(), size);
+}
+
+[[noreturn]] void runWorker(int commandFd, int resultFd, const std::vector<HeaderPair> &pairs,
+                            const std::function<PairOutcome(const HeaderPair &)> &processPair) {
+    std::string command;
+    while (readFrame(commandFd, command)) {
+        for (size_t i : nlohmann::json::parse(command).get<std::vector<size_t>>()) {
+            ConsoleCapture capture;
+            PairOutcome outcome;
+            {
+                ScopedConsoleCapture captureScope(capture);
+                outcome = processPair(pairs[i]);
+            }
+            nlohmann::json result = {
+                {"index", i},
+                {"outcome", static_cast<int>(outcome)},
+                {"stdout", capture.out.str()},
+                {"stderr", capture.errStream.str()},
+            };
+            if (!writeFrame(resultFd, result.dump())) {
+                ::_exit(1);
+            }
+        }
+    }
+    // Skip exit handlers and destructors: they belong to the supervisor
+    ::_exit(0);
+}
+
+void closeWorkerFds(Worker &worker) {
+    if (worker.commandFd >= 0) {
+        ::close(worker.commandFd);
+        worker.commandFd = -1;
+    }
+    if (worker.resultFd >= 0) {
+        ::close(worker.resultFd);
+        worker.resultFd = -1;
+    }
+}
+
+// Waits for a worker that exited and returns its wait status.
+int reapWorker(Worker &worker) {
+    int status = 0;
+    ::waitpid(worker.pid, &status, 0);
+    closeWorkerFds(worker);
+    worker.pid = -1;
+    return status;
+}
+
+bool spawnWorker(std::vector<Worker> &workers, size_t slot, const std::vector<HeaderPair> &pairs,
+                 const std::function<PairOutcome(const HeaderPair &)> &processPair) {
+    int command[2];
+    int result[2];
+    if (::pipe2(command, O_CLOEXEC) != 0) {
+        return false;
+    }
+    if (::pipe2(result, O_CLOEXEC) != 0) {
+        ::close(command[0]);
+        ::close(command[1]);
+        return false;
+    }
+
+    // Nothing buffered may be written twice
+    std::cout.flush();
+    llvm::outs().flush();
+    llvm::errs().flush();
+
+    pid_t pid = ::fork();
+    if (pid < 0) {
+        for (int fd : {command[0], command[1], result[0], result[1]}) {
+            ::close(fd);
+        }
+        return false;
+    }
+    if (pid == 0) {
+        // Other workers' pipe ends would keep their EOF from reaching the supervisor
+        for (Worker &other : workers) {
+            closeWorkerFds(other);
+        }
+        ::close(command[1]);
+        ::close(result[0]);
+        runWorker(command[0], result[1], pairs, processPair);
+    }
+
+    ::close(command[0]);
+    ::close(result[1]);
+    Worker &worker = workers[slot];
+    worker.pid = pid;
+    worker.commandFd = command[1];
+    worker.resultFd = result[0];
+    worker.inFlight.clear();
+    return true;
+}
+
+std::string describeExit(int status) {
+    if (WIFSIGNALED(status)) {
+        const char *name = ::strsignal(WTERMSIG(status));
+        return "killed by signal " + std::to_string(WTERMSIG(status)) + (name ? std::string(" (") + name + ")" : "");
+    }
+    if (WIFEXITED(status)) {
+        return "exited with status " + std::to_string(WEXITSTATUS(status));
+    }
+    return "stopped";
+}
+
+// Restores SIGPIPE handling on scope exit; a worker that died must not take the
+// supervisor down when it is sent its next group.
+class IgnoreSigpipe {
+public:
+    IgnoreSigpipe() {
+        struct sigaction ignore;
+        std::memset(&ignore, 0, sizeof(ignore));
+        ignore.sa_handler = SIG_IGN;
+        ::sigaction(SIGPIPE, &ignore, &previous);
+    }
+    ~IgnoreSigpipe() { ::sigaction(SIGPIPE, &previous, nullptr); }
+
+    IgnoreSigpipe(const IgnoreSigpipe &) = delete;
+    IgnoreSigpipe &operator=(const IgnoreSigpipe &) = delete;
+
+private:
+    struct sigaction previous;
+};
+
+}
+
+std::vector<PairOutcome> processHeaderPairsIsolated(const std::vector<HeaderPair> &pairs, unsigned workers,
+                                                    const std::string &projectRoot1, std::chrono::seconds pairTimeout,
+                                                    const std::function<PairOutcome(const HeaderPair &)> &processPair) {
+    std::deque<std::vector<size_t>> pending;
+    for (auto &group : groupPairsByReport(pairs, projectRoot1)) {
+        pending.push_back(std::move(group));
+    }
+
+    std::vector<std::optional<PairOutcome>> results(pairs.size());
+    std::vector<std::string> outputs(pairs.size());
+    std::vector<std::string> errors(pairs.size());
+    std::vector<std::string> crashes(pairs.size());
+    size_t nextToReplay = 0;
+
+    IgnoreSigpipe ignoreSigpipe;
+    std::vector<Worker> pool(std::max<size_t>(1, std::min<size_t>(workers, pending.size())));
+    unsigned idleDeaths = 0;
+    bool canStart = true;
+
+    auto markCrashed = [&](size_t i, const std::string &reason) {
+        results[i] = PairOutcome::Crashed;
+        crashes[i] = "Worker " + reason + " while comparing " + pairs[i].file1 + " " + pairs[i].file2;
+    };
+    auto restartClock = [&](Worker &worker) {
+        worker.deadline = std::chrono::steady_clock::now() + pairTimeout;
+    };
+    // The pair it was on is lost, the rest of its group is not
+    auto loseWorker = [&](Worker &worker, const std::string &reason) {
+        size_t lost = worker.inFlight.front();
+        worker.inFlight.pop_front();
+        markCrashed(lost, reason);
+        if (!worker.inFlight.empty()) {
+            pending.emplace_front(worker.inFlight.begin(), worker.inFlight.end());
+            worker.inFlight.clear();
+        }
+    };
+
+    while (true) {
+        // Hand queued groups to idle workers, starting workers as needed
+        size_t slot = 0;
+        while (canStart && slot < pool.size() && !pending.empty()) {
+            Worker &worker = pool[slot];
+            if (!worker.inFlight.empty()) {
+                ++slot;
+                continue;
+            }
+            if (worker.pid < 0 && !spawnWorker(pool, slot, pairs, processPair)) {
+                USER_ERROR(std::string("Failed to start worker process: ") + std::strerror(errno));
+                canStart = false;
+                break;
+            }
+            if (!writeFrame(worker.commandFd, nlohmann::json(pending.front()).dump())) {
+                // The worker died while idle; the group goes to its replacement
+                reapWorker(worker);
+                if (++idleDeaths > kMaxIdleDeaths) {
+                    USER_ERROR("Worker processes keep exiting before taking any header, giving up");
+                    canStart = false;
+                }
+                continue;
+            }
+            worker.inFlight.assign(pending.front().begin(), pending.front().end());
+            pending.pop_front();
+            restartClock(worker);
+            ++slot;
+        }
+
+        std::vector<pollfd> fds;
+        std::vector<size_t> slots;
+        int timeoutMs = -1;
+        const auto now = std::chrono::steady_clock::now();
+        for (size_t slot = 0; slot < pool.size(); ++slot) {
+            if (pool[slot].pid >= 0 && !pool[slot].inFlight.empty()) {
+                fds.push_back({pool[slot].resultFd, POLLIN, 0});
+                slots.push_back(slot);
+                if (pairTimeout.count() > 0) {
+                    // Rounded up, so the poll does not wake just short of the deadline
+                    auto left = std::chrono::ceil<std::chrono::milliseconds>(pool[slot].deadline - now).count();
+                    left = std::max<decltype(left)>(left, 0);
+                    timeoutMs = timeoutMs < 0 ? int(left) : std::min(timeoutMs, int(left));
+                }
+            }
+        }
+        if (fds.empty()) {
+            // Every group that could be started has been answered; whatever is
+            // still queued could not get a worker
+            while (!pending.empty()) {
+                for (size_t i : pending.front()) {
+                    markCrashed(i, "could not be started");
+                }
+                pending.pop_front();
+            }
+            break;
+        }
+        if (::poll(fds.data(), fds.size(), timeoutMs) < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            USER_ERROR(std::string("Waiting for worker processes failed: ") + std::strerror(errno));
+            break;
+        }
+
+        for (size_t k = 0; k < fds.size(); ++k) {
+            if (fds[k].revents == 0) {
+                continue;
+            }
+            Worker &worker = pool[slots[k]];
+            std::string payload;
+            if (readFrame(worker.resultFd, payload)) {
+                nlohmann::json result = nlohmann::json::parse(payload);
+                size_t i = result["index"].get<size_t>();
+                results[i] = static_cast<PairOutcome>(result["outcome"].get<int>());
+                outputs[i] = result["stdout"].get<std::string>();
+                errors[i] = result["stderr"].get<std::string>();
+                worker.inFlight.pop_front();
+                restartClock(worker);
+                idleDeaths = 0;
+                continue;
+            }
+
+            // The worker died
+            loseWorker(worker, describeExit(reapWorker(worker)));
+        }
+
+        // A worker stuck on one pair past the deadline is killed like one that crashed
+        if (pairTimeout.count() > 0) {
+            const auto expired = std::chrono::steady_clock::now();
+            for (size_t slot : slots) {
+                Worker &worker = pool[slot];
+                if (worker.pid >= 0 && !worker.inFlight.empty() && worker.deadline <= expired) {
+                    ::kill(worker.pid, SIGKILL);
+                    reapWorker(worker);
+                    loseWorker(worker, "timed out after " + std::to_string(pairTimeout.count()) + " seconds");
+                }
+            }
+        }
+
+        // Output of finished pairs is replayed in input order
+        while (nextToReplay < pairs.size() && results[nextToReplay]) {
+            userOut() << outputs[nextToReplay] << std::flush;
+            userErr() << errors[nextToReplay];
+            userErr().flush();
+            if (!crashes[nextToReplay].empty()) {
+                USER_ERROR(crashes[nextToReplay]);
+            }
+            ++nextToReplay;
+        }
+    }
+
+    // Closing the command pipes lets idle workers exit
+    for (Worker &worker : pool) {
+        closeWorkerFds(worker);
+    }
+    for (Worker &worker : pool) {
+        if (worker.pid >= 0) {
+            ::waitpid(worker.pid, nullptr, 0);
+        }
+    }
+
+    std::vector<PairOutcome> outcomes;
+    outcomes.reserve(pairs.size());
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        if (!results[i]) {
+            markCrashed(i, "never answered");
+        }
+        if (i >= nextToReplay) {
+            userOut() << outputs[i] << std::flush;
+            userErr() << errors[i];
+            userErr().flush();
+            if (!crashes[i].empty()) {
+                USER_ERROR(crashes[i]);
+            }
+        }
+        outcomes.push_back(*results[i]);
+    }
+    return outcomes;
+}
@@ -1,11 +1,38 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <string_view>
+
+#include "ast_cache.hpp"
 #include "options_handler.hpp"
 
+namespace {
+
+// With --ast-cache, or as a daemon whose clients may pass it
+bool mayLoadCachedAsts(int argc, const char **argv) {
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg(argv[i]);
+        if (arg == "--") {
+            break;
+        }
+        for (std::string_view option : {"--ast-cache", "--serve"}) {
+            if (arg == option || (arg.substr(0, option.size()) == option && arg[option.size()] == '=')) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+}
+
 int main(int argc, const char **argv) {
+    // Changes the environment, so before any thread can be inside Clang
+    if (mayLoadCachedAsts(argc, argv)) {
+        AstFileCache::disableInputValidation();
+    }
     if (!runArmorTool(argc, argv)) {
         return 1;
     }
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,204 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <system_error>
+#include <vector>
+#include <nlohmann/json.hpp>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileUtilities.h"
+
+#include "manifest.hpp"
+#include "user_print.hpp"
+
+using json = nlohmann::json;
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string resolveUnderRoot(const std::string& root, const std::string& path) {
+    return fs::path(path).is_absolute() ? path : root + "/" + path;
+}
+
+std::vector<std::string> splitMacroFlags(const std::string& macroFlags) {
+    std::vector<std::string> macros;
+    std::istringstream iss(macroFlags);
+    std::string flag;
+    while (iss >> flag) {
+        macros.push_back(flag);
+    }
+    return macros;
+}
+
+const char* outcomeToString(PairOutcome outcome) {
+    switch (outcome) {
+        case PairOutcome::MissingOld:         return "missing_old";
+        case PairOutcome::MissingNew:         return "missing_new";
+        case PairOutcome::Unchanged:          return "unchanged";
+        case PairOutcome::Compared:           return "compared";
+        case PairOutcome::ComparedWithErrors: return "parse_errors";
+        case PairOutcome::Crashed:            return "crashed";
+    }
+    return "unknown";
+}
+
+bool parseEntry(const json& entry, const std::string& projectRoot1, const std::string& projectRoot2,
+                const std::string& headerSubDir, HeaderPair& pair) {
+    if (entry.is_string()) {
+        return parseEntry(json{{"header", entry}}, projectRoot1, projectRoot2, headerSubDir, pair);
+    }
+    if (!entry.is_object()) {
+        return false;
+    }
+
+    if (entry.contains("header")) {
+        pair.name = entry.at("header").get<std::string>();
+        std::string relative = headerSubDir.empty() ? pair.name : headerSubDir + "/" + pair.name;
+        pair.file1 = projectRoot1 + "/" + relative;
+        pair.file2 = projectRoot2 + "/" + relative;
+    } else if (entry.contains("old") && entry.contains("new")) {
+        const std::string oldPath = entry.at("old").get<std::string>();
+        pair.name = oldPath;
+        pair.file1 = resolveUnderRoot(projectRoot1, oldPath);
+        pair.file2 = resolveUnderRoot(projectRoot2, entry.at("new").get<std::string>());
+    } else {
+        return false;
+    }
+
+    if (entry.contains("include_paths")) {
+        pair.includePaths = entry.at("include_paths").get<std::vector<std::string>>();
+    }
+    if (entry.contains("macro_flags")) {
+        const json& macros = entry.at("macro_flags");
+        pair.macros = macros.is_string() ? splitMacroFlags(macros.get<std::string>())
+                                         : macros.get<std::vector<std::string>>();
+    }
+    return true;
+}
+
+}
+
+bool loadManifest(const std::string& manifestPath,
+                  const std::string& projectRoot1,
+                  const std::string& projectRoot2,
+                  const std::string& headerSubDir,
+                  std::vector<HeaderPair>& pairs) {
+    std::ifstream in(manifestPath);
+    if (!in.is_open()) {
+        USER_ERROR(std::string("Failed to open manifest: ") + manifestPath);
+        return false;
+    }
+    std::stringstream buffer;
+    buffer << in.rdbuf();
+    const std::string contents = buffer.str();
+
+    // A whole-file JSON array is the plain JSON form; anything else is read as NDJSON
+    std::vector<json> entries;
+    json document = json::parse(contents, nullptr, /*allow_exceptions=*/false);
+    if (document.is_array()) {
+        entries.assign(document.begin(), document.end());
+    } else {
+        std::istringstream lines(contents);
+        std::string line;
+        size_t lineNumber = 0;
+        while (std::getline(lines, line)) {
+            ++lineNumber;
+            if (line.find_first_not_of(" \t\r") == std::string::npos) {
+                continue;
+            }
+            json entry = json::parse(line, nullptr, /*allow_exceptions=*/false);
+            if (entry.is_discarded()) {
+                USER_ERROR("Invalid JSON in manifest " + manifestPath + " at line " + std::to_string(lineNumber));
+                return false;
+            }
+            entries.push_back(std::move(entry));
+        }
+    }
+
+    for (size_t i = 0; i < entries.size(); ++i) {
+        HeaderPair pair;
+        bool valid = false;
+        try {
+            valid = parseEntry(entries[i], projectRoot1, projectRoot2, headerSubDir, pair);
+        } catch (const json::exception& e) {
+            USER_ERROR(std::string("Invalid manifest entry: ") + e.what());
+        }
+        if (!valid) {
+            USER_ERROR("Manifest entry " + std::to_string(i + 1) + " in " + manifestPath +
+                       " needs a \"header\" or both \"old\" and \"new\": " + entries[i].dump());
+            return false;
+        }
+        pairs.push_back(std::move(pair));
+    }
+    return true;
+}
+
+std::vector<std::vector<size_t>> groupPairsByReport(const std::vector<HeaderPair>& pairs,
+                                                    const std::string& projectRoot1) {
+    std::vector<std::vector<size_t>> groups;
+    llvm::StringMap<size_t> groupIndex;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        std::string name = reportNameForHeader(projectRoot1, pairs[i].file1);
+        auto it = groupIndex.try_emplace(name, groups.size()).first;
+        if (it->second == groups.size()) {
+            groups.emplace_back();
+        }
+        groups[it->second].push_back(i);
+    }
+    return groups;
+}
+
+bool writeManifestStatus(const std::string& statusPath,
+                         const std::vector<HeaderPair>& pairs,
+                         const std::vector<PairOutcome>& outcomes,
+                         const std::string& reportFormat,
+                         const std::string& projectRoot1,
+                         const OutputLayout& output) {
+    json headers = json::array();
+    bool success = true;
+    for (size_t i = 0; i < pairs.size(); ++i) {
+        const PairOutcome outcome = outcomes[i];
+        if (outcome != PairOutcome::Compared && outcome != PairOutcome::Unchanged) {
+            success = false;
+        }
+
+        json entry = {
+            {"header", pairs[i].name},
+            {"old", pairs[i].file1},
+            {"new", pairs[i].file2},
+            {"result", outcomeToString(outcome)}
+        };
+        if (outcome == PairOutcome::Compared || outcome == PairOutcome::ComparedWithErrors) {
+            const std::string headerName = reportNameForHeader(projectRoot1, pairs[i].file1);
+            entry["html_report"] = output.htmlReportPath(headerName);
+            const std::string jsonReport = output.jsonReportPath(headerName);
+            if (reportFormat == "json" && fs::exists(jsonReport)) {
+                entry["json_report"] = jsonReport;
+            }
+        }
+        headers.push_back(std::move(entry));
+    }
+
+    json status = {
+        {"status", success ? "success" : "failure"},
+        {"headers", std::move(headers)}
+    };
+
+    std::error_code ec;
+    fs::path parent = fs::path(statusPath).parent_path();
+    if (!parent.empty()) {
+        fs::create_directories(parent, ec);
+    }
+    // Renamed into place, so a reader never sees half a status file
+    if (llvm::Error error = llvm::writeFileAtomically(statusPath + ".tmp%%%%%%", statusPath, status.dump(4))) {
+        USER_ERROR("Failed to write manifest status " + statusPath + ": " + llvm::toString(std::move(error)));
+        return false;
+    }
+    USER_PRINT(std::string("Manifest status written to: ") + statusPath);
+    return true;
+}
@@ -1,29 +1,24 @@
 // Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
 // SPDX-License-Identifier: BSD-3-Clause
 
+#include <cstddef>
 #include <iostream>
+#include <sstream>
 #include <vector>
 #include <string>
-#include <filesystem>
 #include "CLI/CLI.hpp"
 #include "llvm/Support/raw_ostream.h"
 #include "options_handler.hpp"
-
-#include <session.hpp>
-
-#include "alpha/include/header_processor.hpp"
-#include "beta/include/header_processor.hpp"
+#include "armor_context.hpp"
+#include "armor_server.hpp"
+#include "comparison.hpp"
+#include "output_layout.hpp"
 #include "user_print.hpp"
 
 #ifndef TOOL_VERSION
 #define TOOL_VERSION ""
 #endif
 
-bool filesAreDifferentUsingDiff(const std::string &file1, const std::string &file2) {
-    std::string command = "diff -q " + file1 + " " + file2 + " > /dev/null";
-    return std::system(command.c_str()) != 0;
-}
-
 bool runArmorTool(int argc, const char **argv) {
     CLI::App app{"ARMOR"};
     std::string projectRoot1;
@@ -36,12 +31,36 @@ bool runArmorTool(int argc, const char **argv) {
     std::vector<std::string> IncludePaths;
     std::vector<std::string> macros;
     std::string macroFlags;
+    std::string buildDir;
+    unsigned jobs = 1;
+    std::string manifestPath;
+    std::string manifestStatusPath;
+    std::string outputDir;
+    std::string servePath;
+    std::string connectPath;
+    bool stopServer = false;
+    size_t cacheEntries = 1024;
+    bool isolate = false;
+    unsigned isolateTimeoutSec = 600;
+    std::vector<std::string> headerGlobs;
+    std::vector<std::string> excludeGlobs;
+    std::string gitRepo;
+    std::string oldRev;
+    std::string newRev;
+    std::vector<std::string> prelude;
+    bool preludeAuto = false;
+    bool astCache = false;
+    unsigned astCacheSizeMb = 2048;
+    std::string emitSnapshot;
+    bool skipFunctionBodies = false;
     auto fmt = std::make_shared<CLI::Formatter>();
     fmt->column_width(40);
     app.formatter(fmt);
     // Positional arguments
-    app.add_option("projectroot1", projectRoot1, "Path to the project root dir of the older version")->required();
-    app.add_option("projectroot2", projectRoot2, "Path to the project root dir of the newer version")->required();
+    // Required unless serving or stopping a daemon, which is checked after parsing
+    app.add_option("projectroot1", projectRoot1,
+        "Path to the project root dir of the older version, or an API snapshot written by --emit-snapshot");
+    app.add_option("projectroot2", projectRoot2, "Path to the project root dir of the newer version");
     app.add_option("headers", headers,
         "List of header files to compare between the two versions.\n"
         "\n"
@@ -58,7 +77,17 @@ bool runArmorTool(int argc, const char **argv) {
         "        include/api/foo.h include/api/bar.hpp\n"
     );
     // Optional arguments
-    app.add_option("--header-dir", headerSubDir, "Subdirectory under each project root containing headers");
+    auto headerDirOpt = app.add_option("--header-dir", headerSubDir,
+        "Subdirectory under each project root containing headers.\n"
+        "Without header arguments, every .h, .hh, .hpp, .hxx and .inl file below it is compared.");
+    app.add_option("--header-glob", headerGlobs,
+        "With --header-dir, only compare headers whose path relative to it matches\n"
+        "one of these globs ('*' also matches '/'). Example: --header-glob 'net/*'")
+        ->needs(headerDirOpt);
+    app.add_option("--exclude-glob", excludeGlobs,
+        "With --header-dir, skip headers whose path relative to it matches one of these globs.\n"
+        "Example: --exclude-glob '*/internal/*'")
+        ->needs(headerDirOpt);
     app.add_option("--report-format,-r", reportFormat, "Report format: html (default).\n"
                                                        "If json is provided, both html and json reports will be generated.")
         ->check(CLI::IsMember({"html", "json"}));
@@ -72,110 +101,138 @@ bool runArmorTool(int argc, const char **argv) {
         "Example: -I path/to/include1 -I path/to/include2");
     app.add_option("-m,--macro-flags", macroFlags,
         "Macro flags to be passed for headers.\n");
+    app.add_option("-p,--build-dir", buildDir,
+        "Build directory holding the compile_commands.json of projectroot2. Each header is parsed\n"
+        "with the include paths, macros and language flags of its best-matching translation unit.")
+        ->check(CLI::ExistingDirectory);
+    app.add_flag("--skip-function-bodies", skipFunctionBodies,
+        "Parse declarations only. Function bodies, which no report depends on, are skipped\n"
+        "unless the function is constexpr or has a deduced return type.");
+    app.add_option("-j,--jobs", jobs,
+        "Number of header pairs to process in parallel (default 1).\n"
+        "Use 0 to run one job per hardware thread.")
+        ->check(CLI::NonNegativeNumber);
+    app.add_option("--manifest", manifestPath,
+        "JSON or NDJSON file listing the header pairs to compare, with optional\n"
+        "per-header include_paths and macro_flags. Compared after any positional headers.")
+        ->check(CLI::ExistingFile);
+    app.add_option("--manifest-status", manifestStatusPath,
+        "Where to write the combined status of a --manifest run\n"
+        "(default armor_reports/manifest_status.json under the output directory).");
+    app.add_option("--output-dir", outputDir,
+        "Directory to write armor_reports/ and debug_output/ into (default: current directory).\n"
+        "Several runs may share one output directory.");
+    auto isolateOpt = app.add_flag("--isolate", isolate,
+        "Compare headers in forked worker processes (-j of them). A worker that crashes\n"
+        "is replaced and only the header it was comparing is lost.");
+    app.add_option("--isolate-timeout", isolateTimeoutSec,
+        "With --isolate, seconds a worker may spend on one header before it is killed\n"
+        "and the header reported as crashed (default 600, 0 for no limit).")
+        ->needs(isolateOpt);
+    auto serveOpt = app.add_option("--serve", servePath,
+        "Run as a daemon answering comparison requests on this Unix domain socket.\n"
+        "Trees of older headers are cached between requests.");
+    auto connectOpt = app.add_option("--connect", connectPath,
+        "Send the comparison to an armor --serve daemon listening on this socket\n"
+        "instead of running it here.");
+    app.add_flag("--stop-server", stopServer, "With --connect, ask the daemon to exit.")
+        ->needs(connectOpt);
+    app.add_option("--cache-entries", cacheEntries,
+        "With --serve, number of older headers whose trees are kept (default 1024).")
+        ->needs(serveOpt);
+    serveOpt->excludes(connectOpt);
+    auto gitRepoOpt = app.add_option("--git-repo", gitRepo,
+        "Compare two revisions of this local git repository, read straight from its\n"
+        "object store; no checkout is needed. All positional arguments are then headers.\n"
+        "Example: --git-repo . --old-rev v1.0 --new-rev HEAD include/api/foo.h")
+        ->check(CLI::ExistingDirectory);
+    auto oldRevOpt = app.add_option("--old-rev", oldRev, "With --git-repo, revision of the older version.")
+        ->needs(gitRepoOpt);
+    auto newRevOpt = app.add_option("--new-rev", newRev, "With --git-repo, revision of the newer version.")
+        ->needs(gitRepoOpt);
+    app.add_option("--prelude", prelude,
+        "Header that the compared headers include first, precompiled once per project root\n"
+        "and flag set and kept in ~/.cache/armor/pch across runs. Spelled as in the include.\n"
+        "Example: --prelude '<cstdint>' --prelude sdk/types.h");
+    app.add_flag("--prelude-auto", preludeAuto,
+        "Also precompile every <...> include that all compared headers share.");
+    auto astCacheOpt = app.add_flag("--ast-cache", astCache,
+        "Keep the parsed AST of every older header in ~/.cache/armor/ast and load it instead of\n"
+        "parsing while neither the header, anything it includes, nor the flags changed.");
+    app.add_option("--ast-cache-size", astCacheSizeMb,
+        "With --ast-cache, megabytes of ASTs kept; the least recently used go first (default 2048).")
+        ->check(CLI::PositiveNumber)
+        ->needs(astCacheOpt);
+    auto emitSnapshotOpt = app.add_option("--emit-snapshot", emitSnapshot,
+        "Write the trees of the newer headers to this file as an API snapshot, which later\n"
+        "runs accept in place of projectroot1. Unchanged headers are parsed too.");
+    emitSnapshotOpt->excludes(isolateOpt);
+    gitRepoOpt->needs(oldRevOpt)->needs(newRevOpt)->excludes(serveOpt);
     CLI11_PARSE(app, argc, argv);
+    if (!gitRepo.empty()) {
+        // The project roots come from the repository, so the positionals filled in as roots are headers
+        for (std::string* root : {&projectRoot2, &projectRoot1}) {
+            if (!root->empty()) {
+                headers.insert(headers.begin(), *root);
+                root->clear();
+            }
+        }
+    }
+    else if (servePath.empty() && !stopServer && (projectRoot1.empty() || projectRoot2.empty())) {
+        app.exit(CLI::RequiredError(projectRoot1.empty() ? "projectroot1" : "projectroot2"));
+        return false;
+    }
+    ArmorContext context{OutputLayout(outputDir)};
+    ScopedDebugConfig debugScope(context.debug());
+    // Open the log under the output directory before anything is logged
+    context.openDiagnosticsLog();
     std::istringstream iss(macroFlags);
     std::string flag;
     while (iss >> flag) {
         macros.push_back(flag);
     }
     // Set level and announce (now goes to the file)
-    if (debugLevel == "DEBUG") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::DEBUG);
-        DebugConfig::instance().log("Debug level set to DEBUG", DebugConfig::Level::INFO);
-    } else if (debugLevel == "INFO") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::INFO);
-        DebugConfig::instance().log("Debug level set to INFO", DebugConfig::Level::INFO);
-    } else if (debugLevel == "LOG") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::LOG);
-        DebugConfig::instance().log("Debug level set to LOG", DebugConfig::Level::INFO);
-    } else if (debugLevel == "ERROR") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::ERROR);
-        DebugConfig::instance().log("Debug level set to ERROR", DebugConfig::Level::INFO);
-    }
+    applyLogLevel(context.debug(), debugLevel);
 
-    bool processed = false;
-    std::vector<std::string> headersToCompare;
-    if (!headers.empty()) {
-        for (const auto &header : headers) {
-            std::string file1, file2;
-            if (!headerSubDir.empty()) {
-                file1 = projectRoot1 + "/" + headerSubDir + "/" + header;
-                file2 = projectRoot2 + "/" + headerSubDir + "/" + header;
-            } else {
-                file1 = projectRoot1 + "/" + header;
-                file2 = projectRoot2 + "/" + header;
-            }
-            USER_PRINT(std::string("Processing files: ") + file1 + " " + file2);
-            if (!std::filesystem::exists(file1)) {
-                USER_ERROR(std::string("Missing header in older version: ") + file1);
-            } else if (!std::filesystem::exists(file2)) {
-                USER_ERROR(std::string("Missing header in newer version: ") + file2);
-            } else if (filesAreDifferentUsingDiff(file1, file2)) {
-                PARSING_STATUS parsingStatus = processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                IncludePaths, macros);
-                switch (parsingStatus) {
-                    case NO_FATAL_ERRORS:
-                        DebugConfig::instance().log("Processing Headers again via v2", DebugConfig::Level::INFO);
-                        processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                    IncludePaths, macros);
-                        break;
-                    case FATAL_ERRORS:
-                        DebugConfig::instance().log("Processing Headers stopped at v1", DebugConfig::Level::INFO);
-                        break;
-                }
-                processed = true;
-            } else {
-                USER_PRINT(std::string("No differences found between: ") + file1 + " and " + file2);
-            }
-        }
-    }
-    else if (!headerSubDir.empty()) {
-        std::string dir1 = projectRoot1 + "/" + headerSubDir;
-        std::string dir2 = projectRoot2 + "/" + headerSubDir;
-        for (const auto &entry : std::filesystem::directory_iterator(dir1)) {
-            if (entry.path().extension() == ".h" || entry.path().extension() == ".hpp") {
-                headersToCompare.push_back(entry.path().filename().string());
-            }
-        }
-        USER_PRINT("List of headers to process:");
-        for (const auto &h : headersToCompare) {
-            USER_PRINT(std::string("  ") + h);
-        }
-        for (const auto &header : headersToCompare) {
-            std::string file1 = dir1 + "/" + header;
-            std::string file2 = dir2 + "/" + header;
-            USER_PRINT(std::string("Processing files: ") + file1 + " " + file2);
-            if (!std::filesystem::exists(file1)) {
-                USER_ERROR(std::string("Missing header in older version: ") + file1);
-            } else if (!std::filesystem::exists(file2)) {
-                USER_ERROR(std::string("Missing header in newer version: ") + file2);
-            } else if (filesAreDifferentUsingDiff(file1, file2)) {
-                PARSING_STATUS parsingStatus = processHeaderPairAlpha(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                IncludePaths, macros);
-                switch (parsingStatus) {
-                    case NO_FATAL_ERRORS:
-                        DebugConfig::instance().log("Processing Headers again via v2", DebugConfig::Level::INFO);
-                        processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
-                                    IncludePaths, macros);
-                        break;
-                    case FATAL_ERRORS:
-                        DebugConfig::instance().log("Processing Headers stopped at v1", DebugConfig::Level::INFO);
-                        break;
-                }
-                processed = true;
-            } else {
-                USER_PRINT(std::string("No differences found between: ") + file1 + " and " + file2);
-            }
-        }
+    if (!servePath.empty()) {
+        return runArmorServer(context, servePath, jobs, cacheEntries);
     }
-    if (processed && !dumpAstDiff) {
-        try {
-            std::filesystem::remove_all("debug_output/ast_diffs");
-        } catch (const std::exception &e) {
-            USER_ERROR(std::string("Failed to remove debug_output directory: ") + e.what());
-        }
+    if (stopServer) {
+        return stopArmorServer(connectPath);
     }
-    if (!processed && headers.empty() && headerSubDir.empty()) {
+
+    ComparisonRequest request;
+    request.projectRoot1 = projectRoot1;
+    request.projectRoot2 = projectRoot2;
+    request.headers = headers;
+    request.headerSubDir = headerSubDir;
+    request.headerGlobs = headerGlobs;
+    request.excludeGlobs = excludeGlobs;
+    request.manifestPath = manifestPath;
+    request.manifestStatusPath = manifestStatusPath;
+    request.outputDir = outputDir;
+    request.reportFormat = reportFormat;
+    request.logLevel = debugLevel;
+    request.dumpAstDiff = dumpAstDiff;
+    request.includePaths = IncludePaths;
+    request.macros = macros;
+    request.buildDir = buildDir;
+    request.skipFunctionBodies = skipFunctionBodies;
+    request.jobs = jobs;
+    request.isolate = isolate;
+    request.isolateTimeoutSec = isolateTimeoutSec;
+    request.gitRepo = gitRepo;
+    request.oldRev = oldRev;
+    request.newRev = newRev;
+    request.prelude = prelude;
+    request.preludeAuto = preludeAuto;
+    request.astCache = astCache;
+    request.astCacheSizeMb = astCacheSizeMb;
+    request.emitSnapshot = emitSnapshot;
+
+    bool processed = connectPath.empty() ? runComparison(request, context)
+                                         : runArmorClient(connectPath, request);
+    if (!processed && headers.empty() && headerSubDir.empty() && manifestPath.empty()) {
         const std::string argv0 = argv[0] ? std::string(argv[0]) : std::string("armor");
         USER_ERROR(
             std::string("Usage: ") + argv0 + " <projectroot1> <projectroot2> <header1> <header2> ...\n"
@@ -0,0 +1,367 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/Version.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendActions.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
+
+#include "cache_directory.hpp"
+#include "debug_config.hpp"
+#include "parse_utils.hpp"
+#include "prelude_pch.hpp"
+
+namespace {
+
+// The prelude's command line is the one of a header directly in the project root
+constexpr const char* kPreludeName = "armor_prelude.h";
+
+// Records every file the prelude reads, system headers included
+class PreludeInputCollector : public clang::DependencyCollector {
+public:
+    bool needSystemDependencies() override { return true; }
+};
+
+class PrecompilePreludeAction : public clang::GeneratePCHAction {
+public:
+    PrecompilePreludeAction(const std::string& outputPath, PreludeInputCollector& inputs)
+        : m_outputPath(outputPath), m_inputs(inputs) {}
+
+protected:
+    bool BeginInvocation(clang::CompilerInstance& ci) override {
+        // The tool strips -o from the command line
+        ci.getFrontendOpts().OutputFile = m_outputPath;
+        return GeneratePCHAction::BeginInvocation(ci);
+    }
+
+    bool BeginSourceFileAction(clang::CompilerInstance& ci) override {
+        m_inputs.attachToPreprocessor(ci.getPreprocessor());
+        return GeneratePCHAction::BeginSourceFileAction(ci);
+    }
+
+private:
+    const std::string& m_outputPath;
+    PreludeInputCollector& m_inputs;
+};
+
+class PrecompilePreludeActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    PrecompilePreludeActionFactory(const std::string& outputPath, PreludeInputCollector& inputs)
+        : m_outputPath(outputPath), m_inputs(inputs) {}
+
+    std::unique_ptr<clang::FrontendAction> create() override {
+        return std::make_unique<PrecompilePreludeAction>(m_outputPath, m_inputs);
+    }
+
+private:
+    const std::string& m_outputPath;
+    PreludeInputCollector& m_inputs;
+};
+
+std::string includeLine(const std::string& target) {
+    if (llvm::StringRef(target).startswith("<") || llvm::StringRef(target).startswith("\"")) {
+        return "#include " + target + "\n";
+    }
+    return "#include \"" + target + "\"\n";
+}
+
+// Paths are compared in this form, however the include that found them spelled them
+std::string normalizedPath(llvm::StringRef path) {
+    llvm::SmallString<256> normalized(path);
+    llvm::sys::path::remove_dots(normalized, /*remove_dot_dot=*/true);
+    return normalized.str().str();
+}
+
+bool digestOf(llvm::vfs::FileSystem& fileSystem, const std::string& path, uint64_t& size, uint64_t& hash) {
+    auto buffer = fileSystem.getBufferForFile(path, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        return false;
+    }
+    size = (*buffer)->getBufferSize();
+    hash = llvm::xxHash64((*buffer)->getBuffer());
+    return true;
+}
+
+// A PCH is named by its key and the listing of its inputs, so a rebuild from
+// other inputs never replaces a file another process may be loading
+std::string pchPathFor(const std::string& base, llvm::StringRef inputsText) {
+    return base + "-" + llvm::utohexstr(llvm::xxHash64(inputsText), /*LowerCase=*/true) + ".pch";
+}
+
+// The .inputs file holds "<size> <xxhash> <path>" for every file the PCH was built from
+bool inputsUnchanged(llvm::vfs::FileSystem& fileSystem, const std::string& inputsPath, llvm::StringSet<>& inputs,
+                     std::string& pchPath, const std::string& base) {
+    auto listing = llvm::MemoryBuffer::getFile(inputsPath);
+    if (!listing) {
+        return false;
+    }
+    pchPath = pchPathFor(base, (*listing)->getBuffer());
+    llvm::SmallVector<llvm::StringRef, 64> lines;
+    (*listing)->getBuffer().split(lines, '\n', -1, /*KeepEmpty=*/false);
+    if (lines.empty()) {
+        return false;
+    }
+    for (llvm::StringRef line : lines) {
+        llvm::StringRef sizeText, hashText, path;
+        std::tie(sizeText, line) = line.split(' ');
+        std::tie(hashText, path) = line.split(' ');
+        uint64_t recordedSize = 0, recordedHash = 0, size = 0, hash = 0;
+        if (sizeText.getAsInteger(10, recordedSize) || hashText.getAsInteger(16, recordedHash) || path.empty() ||
+            !digestOf(fileSystem, path.str(), size, hash) || size != recordedSize || hash != recordedHash) {
+            return false;
+        }
+        inputs.insert(normalizedPath(path));
+    }
+    return true;
+}
+
+// Lines of the form `#include <target>` outside conditional blocks. The only
+// block that does not count is an include guard: an #ifndef X that is the
+// file's first directive and is followed at once by #define X.
+std::vector<std::string> topLevelSystemIncludes(llvm::StringRef text) {
+    std::vector<std::string> includes;
+    // One entry per open conditional: whether its current branch is always taken
+    llvm::SmallVector<bool, 8> blocks;
+    llvm::StringRef guardMacro;
+    bool firstDirective = true;
+    bool afterGuard = false;
+    while (!text.empty()) {
+        llvm::StringRef line;
+        std::tie(line, text) = text.split('\n');
+        line = line.ltrim();
+        if (!line.consume_front("#")) {
+            continue;
+        }
+        line = line.ltrim();
+        const bool first = firstDirective;
+        const bool expectDefine = afterGuard;
+        firstDirective = false;
+        afterGuard = false;
+        if (first && line.consume_front("ifndef")) {
+            guardMacro = line.trim();
+            blocks.push_back(false);
+            afterGuard = !guardMacro.empty();
+        } else if (line.startswith("if")) {
+            blocks.push_back(false);
+        } else if (line.startswith("elif") || line.startswith("else")) {
+            if (!blocks.empty()) {
+                blocks.back() = false;
+            }
+        } else if (line.startswith("endif")) {
+            if (!blocks.empty()) {
+                blocks.pop_back();
+            }
+        } else if (expectDefine && line.consume_front("define") && line.trim() == guardMacro) {
+            blocks.back() = true;
+        } else if (line.consume_front("include") &&
+                   std::all_of(blocks.begin(), blocks.end(), [](bool taken) { return taken; })) {
+            line = line.ltrim();
+            size_t end = line.find('>');
+            if (line.startswith("<") && end != llvm::StringRef::npos) {
+                includes.push_back(line.take_front(end + 1).str());
+            }
+        }
+    }
+    return includes;
+}
+
+}
+
+PreludePchCache::PreludePchCache(std::string directory, std::vector<std::string> prelude)
+    : m_directory(std::move(directory)), m_prelude(std::move(prelude)) {}
+
+std::string PreludePchCache::defaultDirectory() {
+    return userCacheDirectory("pch");
+}
+
+std::vector<std::string> PreludePchCache::detectPrelude(llvm::vfs::FileSystem& fileSystem,
+                                                        const std::vector<std::string>& headers) {
+    std::vector<std::string> common;
+    bool first = true;
+    for (const auto& header : headers) {
+        auto buffer = fileSystem.getBufferForFile(header);
+        if (!buffer) {
+            continue;
+        }
+        std::vector<std::string> includes = topLevelSystemIncludes((*buffer)->getBuffer());
+        if (first) {
+            llvm::StringSet<> seen;
+            for (auto& include : includes) {
+                if (seen.insert(include).second) {
+                    common.push_back(std::move(include));
+                }
+            }
+            first = false;
+            continue;
+        }
+        llvm::StringSet<> present;
+        for (const auto& include : includes) {
+            present.insert(include);
+        }
+        common.erase(std::remove_if(common.begin(), common.end(),
+                                    [&](const std::string& include) { return !present.count(include); }),
+                     common.end());
+        if (common.empty()) {
+            break;
+        }
+    }
+    return common;
+}
+
+std::vector<std::string> PreludePchCache::flagsFor(ArmorContext& context,
+                                                   const std::string& projectRoot,
+                                                   const std::string& headerPath,
+                                                   const std::vector<std::string>& includePaths,
+                                                   const std::vector<std::string>& macroFlags) {
+    if (m_prelude.empty()) {
+        return {};
+    }
+    std::vector<std::string> flags =
+        buildClangFlags(projectRoot, projectRoot + "/" + kPreludeName, includePaths, macroFlags);
+
+    std::string keyText = clang::getClangFullVersion();
+    for (const auto& part : {flags, m_prelude}) {
+        for (const auto& item : part) {
+            keyText += '\n' + item;
+        }
+        keyText += '\n';
+    }
+    std::string key = llvm::utohexstr(llvm::xxHash64(keyText), /*LowerCase=*/true);
+
+    std::promise<Pch> promise;
+    std::shared_future<Pch> pch;
+    bool builder = false;
+    {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        auto it = m_pchs.find(key);
+        if (it == m_pchs.end()) {
+            pch = promise.get_future().share();
+            m_pchs[key] = pch;
+            builder = true;
+        } else {
+            pch = it->second;
+        }
+    }
+    // Parses needing the same PCH wait for the first one to build it
+    if (builder) {
+        promise.set_value(prepare(context, projectRoot, key, flags));
+    }
+
+    const Pch& ready = pch.get();
+    if (ready.path.empty()) {
+        return {};
+    }
+    if (ready.inputs.count(normalizedPath(headerPath))) {
+        // Its include guard would already be defined, leaving nothing to parse
+        context.debug().log("Parsing " + headerPath + " without the precompiled prelude it is part of",
+                            DebugConfig::Level::INFO);
+        return {};
+    }
+    return {"-include-pch", ready.path, "-Xclang", "-fno-validate-pch"};
+}
+
+PreludePchCache::Pch PreludePchCache::prepare(ArmorContext& context, const std::string& projectRoot,
+                                              const std::string& key, const std::vector<std::string>& flags) {
+    Pch pch;
+    const std::string base = m_directory + "/" + key;
+    std::string pchPath;
+    const std::string inputsPath = base + ".inputs";
+    const std::string preludePath = base + ".h";
+
+    // Inputs are read the way the parses read them
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = llvm::vfs::createPhysicalFileSystem();
+    if (llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> sources = context.sourceFileSystem()) {
+        llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> overlay(new llvm::vfs::OverlayFileSystem(fileSystem));
+        overlay->pushOverlay(sources);
+        fileSystem = overlay;
+    }
+
+    if (inputsUnchanged(*fileSystem, inputsPath, pch.inputs, pchPath, base) && llvm::sys::fs::exists(pchPath)) {
+        context.debug().log("Reusing precompiled prelude " + pchPath + " for " + projectRoot,
+                            DebugConfig::Level::INFO);
+        pch.path = pchPath;
+        ++m_reused;
+        return pch;
+    }
+    pch.inputs.clear();
+
+    // Nothing is removed here: other armor processes may still load the PCH the
+    // listing names, and a stale listing never matches its inputs again
+    if (std::error_code ec = llvm::sys::fs::create_directories(m_directory)) {
+        context.debug().log("Cannot create PCH cache directory " + m_directory + ": " + ec.message(),
+                            DebugConfig::Level::ERROR);
+        return pch;
+    }
+    std::string preludeText;
+    for (const auto& target : m_prelude) {
+        preludeText += includeLine(target);
+    }
+    if (llvm::Error error = llvm::writeFileAtomically(preludePath + ".tmp%%%%%%", preludePath, preludeText)) {
+        context.debug().log("Cannot write " + preludePath + ": " + llvm::toString(std::move(error)),
+                            DebugConfig::Level::ERROR);
+        return pch;
+    }
+
+    // Built under a name of its own and published by rename once its inputs are known
+    llvm::SmallString<256> buildPath;
+    llvm::sys::fs::createUniquePath(base + "-%%%%%%%%.pch.tmp", buildPath, /*MakeAbsolute=*/false);
+    const std::string tempPath = buildPath.str().str();
+
+    // Compiled from the project root, so quoted prelude entries resolve against it
+    clang::tooling::FixedCompilationDatabase compDB(projectRoot, flags);
+    PreludeInputCollector collector;
+    PrecompilePreludeActionFactory factory(tempPath, collector);
+    if (runNormalizeTool(context, preludePath, compDB, factory) == FATAL_ERRORS || !llvm::sys::fs::exists(tempPath)) {
+        context.debug().log("Cannot precompile the prelude for " + projectRoot + "; parsing without it",
+                            DebugConfig::Level::ERROR);
+        llvm::sys::fs::remove(tempPath);
+        return pch;
+    }
+
+    std::string inputsText;
+    for (const auto& input : collector.getDependencies()) {
+        uint64_t size = 0;
+        uint64_t hash = 0;
+        if (!digestOf(*fileSystem, input, size, hash)) {
+            continue;
+        }
+        inputsText += std::to_string(size) + " " + llvm::utohexstr(hash, /*LowerCase=*/true) + " " + input + "\n";
+        pch.inputs.insert(normalizedPath(input));
+    }
+    pchPath = pchPathFor(base, inputsText);
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, pchPath)) {
+        context.debug().log("Cannot publish " + pchPath + ": " + ec.message() + "; parsing without the prelude",
+                            DebugConfig::Level::ERROR);
+        llvm::sys::fs::remove(tempPath);
+        pch.inputs.clear();
+        return pch;
+    }
+    // The listing goes last: until it is replaced, readers keep using the PCH it names
+    if (llvm::Error error = llvm::writeFileAtomically(inputsPath + ".tmp%%%%%%", inputsPath, inputsText)) {
+        // The PCH still serves this run; the next one builds it again
+        context.debug().log("Cannot write " + inputsPath + ": " + llvm::toString(std::move(error)),
+                            DebugConfig::Level::ERROR);
+    }
+    context.debug().log("Built precompiled prelude " + pchPath + " for " + projectRoot + " from " +
+                        std::to_string(pch.inputs.size()) + " files", DebugConfig::Level::INFO);
+    pch.path = pchPath;
+    ++m_built;
+    return pch;
+}
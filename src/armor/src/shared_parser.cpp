@@ -0,0 +1,376 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <filesystem>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "clang/AST/ASTConsumer.h"
+#include "clang/Frontend/ASTUnit.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/FrontendAction.h"
+#include "clang/Frontend/MultiplexConsumer.h"
+#include "clang/Frontend/Utils.h"
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "alpha/include/header_processor.hpp"
+#include "beta/include/api_snapshot.hpp"
+#include "beta/include/header_processor.hpp"
+#include "armor_context.hpp"
+#include "ast_cache.hpp"
+#include "base_context_cache.hpp"
+#include "debug_config.hpp"
+#include "parse_utils.hpp"
+#include "prelude_pch.hpp"
+#include "shared_parser.hpp"
+#include "shared_preamble.hpp"
+#include "string_pool.hpp"
+#include "user_print.hpp"
+
+namespace {
+
+// Hands one AST to the alpha and the beta normalizer
+std::unique_ptr<clang::ASTConsumer> createSharedConsumer(alpha::APISession& alphaSession,
+                                                         beta::APISession& betaSession,
+                                                         const std::string& fileName) {
+    std::vector<std::unique_ptr<clang::ASTConsumer>> consumers;
+    consumers.push_back(alphaSession.createConsumer(fileName));
+    consumers.push_back(betaSession.createConsumer(fileName));
+    return std::make_unique<clang::MultiplexConsumer>(std::move(consumers));
+}
+
+void normalizeUnit(alpha::APISession& alphaSession, beta::APISession& betaSession,
+                   const std::string& fileName, clang::ASTUnit& unit) {
+    std::unique_ptr<clang::ASTConsumer> consumer = createSharedConsumer(alphaSession, betaSession, fileName);
+    consumer->Initialize(unit.getASTContext());
+    consumer->HandleTranslationUnit(unit.getASTContext());
+}
+
+// Records every file a parse reads, those of a loaded PCH or preamble included
+class ClosureCollector : public clang::DependencyCollector {
+public:
+    bool needSystemDependencies() override { return true; }
+};
+
+// Feeds the AST of one parse to the alpha and the beta normalizer.
+class SharedNormalizeAction : public clang::ASTFrontendAction {
+public:
+    SharedNormalizeAction(alpha::APISession* alphaSession, beta::APISession* betaSession,
+                          const std::string& fileName, std::shared_ptr<ClosureCollector> closure)
+        : alphaSession(alphaSession), betaSession(betaSession), fileName(fileName), closure(std::move(closure)) {}
+
+    std::unique_ptr<clang::ASTConsumer> CreateASTConsumer(clang::CompilerInstance &, clang::StringRef) override {
+        return createSharedConsumer(*alphaSession, *betaSession, fileName);
+    }
+
+protected:
+    bool BeginInvocation(clang::CompilerInstance& ci) override {
+        if (closure) {
+            ci.addDependencyCollector(closure);
+        }
+        return clang::ASTFrontendAction::BeginInvocation(ci);
+    }
+
+private:
+    alpha::APISession* alphaSession;
+    beta::APISession* betaSession;
+    const std::string& fileName;
+    std::shared_ptr<ClosureCollector> closure;
+};
+
+class SharedNormalizeActionFactory : public clang::tooling::FrontendActionFactory {
+public:
+    SharedNormalizeActionFactory(alpha::APISession* alphaSession, beta::APISession* betaSession,
+                                 const std::string& fileName, std::shared_ptr<ClosureCollector> closure)
+        : alphaSession(alphaSession), betaSession(betaSession), fileName(fileName), closure(std::move(closure)) {}
+
+    std::unique_ptr<clang::FrontendAction> create() override {
+        return std::make_unique<SharedNormalizeAction>(alphaSession, betaSession, fileName, closure);
+    }
+
+private:
+    alpha::APISession* alphaSession;
+    beta::APISession* betaSession;
+    const std::string& fileName;
+    std::shared_ptr<ClosureCollector> closure;
+};
+
+// Parses one header into an ASTUnit, which outlives the parse so it can be
+// stored in the AST cache once both normalizers have seen it.
+class CachingNormalizeAction : public clang::tooling::ToolAction {
+public:
+    CachingNormalizeAction(ArmorContext& context, alpha::APISession& alphaSession, beta::APISession& betaSession,
+                           const std::string& fileName, const std::vector<std::string>& flags,
+                           AstFileCache& astCache, FileDigestCache& fileDigests, std::vector<std::string>* closure)
+        : context(context), alphaSession(alphaSession), betaSession(betaSession), fileName(fileName),
+          flags(flags), astCache(astCache), fileDigests(fileDigests), closure(closure) {}
+
+    bool runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation, clang::FileManager* files,
+                       std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                       clang::DiagnosticConsumer* diagConsumer) override {
+        std::unique_ptr<clang::ASTUnit> unit = clang::ASTUnit::LoadFromCompilerInvocation(
+            invocation, std::move(pchContainerOps),
+            clang::CompilerInstance::createDiagnostics(&invocation->getDiagnosticOpts(), diagConsumer,
+                                                       /*ShouldOwnClient=*/false),
+            files);
+        if (!unit) {
+            return false;
+        }
+        normalizeUnit(alphaSession, betaSession, fileName, *unit);
+        // Same outcome as a FrontendActionFactory run: any error fails the file
+        if (unit->getDiagnostics().hasErrorOccurred()) {
+            return false;
+        }
+        astCache.store(context, fileName, flags, *unit, fileDigests, closure);
+        return true;
+    }
+
+private:
+    ArmorContext& context;
+    alpha::APISession& alphaSession;
+    beta::APISession& betaSession;
+    const std::string& fileName;
+    const std::vector<std::string>& flags;
+    AstFileCache& astCache;
+    FileDigestCache& fileDigests;
+    std::vector<std::string>* closure;
+};
+
+PARSING_STATUS parseShared(ArmorContext& context,
+                           alpha::APISession& alphaSession, beta::APISession& betaSession,
+                           const std::string& fileName,
+                           const clang::tooling::CompilationDatabase& compDB,
+                           SharedPreamble* preamble = nullptr,
+                           std::vector<std::string>* closure = nullptr) {
+    // Contexts exist even if clang gives up before creating the consumers,
+    // so reporting always finds both sides.
+    alphaSession.createNormalizedASTContext(fileName);
+    betaSession.createNormalizedASTContext(fileName);
+
+    std::shared_ptr<ClosureCollector> collector = closure ? std::make_shared<ClosureCollector>() : nullptr;
+    SharedNormalizeActionFactory factory(&alphaSession, &betaSession, fileName, collector);
+    PARSING_STATUS status;
+    if (preamble) {
+        std::unique_ptr<clang::tooling::FrontendActionFactory> withPreamble = preamble->wrap(fileName, factory);
+        status = runNormalizeTool(context, fileName, compDB, *withPreamble);
+    } else {
+        status = runNormalizeTool(context, fileName, compDB, factory);
+    }
+    if (collector) {
+        closure->assign(collector->getDependencies().begin(), collector->getDependencies().end());
+    }
+    return status;
+}
+
+// Loads the header's AST from the cache, or parses it and stores the result
+PARSING_STATUS parseCached(ArmorContext& context,
+                           alpha::APISession& alphaSession, beta::APISession& betaSession,
+                           const std::string& fileName,
+                           const clang::tooling::CompilationDatabase& compDB,
+                           const std::vector<std::string>& flags,
+                           AstFileCache& astCache, FileDigestCache& fileDigests,
+                           std::vector<std::string>* closure = nullptr) {
+    alphaSession.createNormalizedASTContext(fileName);
+    betaSession.createNormalizedASTContext(fileName);
+
+    // Only ASTs of error-free parses are stored
+    if (std::unique_ptr<clang::ASTUnit> unit = astCache.load(context, fileName, flags, fileDigests, closure)) {
+        normalizeUnit(alphaSession, betaSession, fileName, *unit);
+        return NO_FATAL_ERRORS;
+    }
+    CachingNormalizeAction action(context, alphaSession, betaSession, fileName, flags, astCache, fileDigests,
+                                  closure);
+    return runNormalizeTool(context, fileName, compDB, action);
+}
+
+// Files the newer header's beta tree in the snapshot being written
+void addToSnapshot(beta::ApiSnapshotWriter& snapshot, beta::APISession& betaSession,
+                   const std::string& projectRoot2, const std::string& file2, FileDigestCache& fileDigests) {
+    std::optional<FileDigest> digest = fileDigests.digest(file2);
+    if (!digest) {
+        return;
+    }
+    std::string header = std::filesystem::path(file2).lexically_normal()
+                             .lexically_relative(std::filesystem::path(projectRoot2).lexically_normal())
+                             .generic_string();
+    snapshot.add(header, *digest, betaSession.shareContext(file2));
+}
+
+void logClangFlags(DebugConfig& debug, const std::string& title, const std::string& file,
+                   const std::vector<std::string>& flags) {
+    debug.log(title + " : " + file, DebugConfig::Level::INFO);
+    for (auto& x : flags) {
+        debug.log("Clang search path : " + x, DebugConfig::Level::INFO);
+    }
+}
+
+}
+
+PARSING_STATUS processHeaderPairShared(ArmorContext& context,
+                                       const std::string& project1,
+                                       const std::string& file1,
+                                       const std::string& project2,
+                                       const std::string& file2,
+                                       const std::string& reportFormat,
+                                       const std::vector<std::string>& IncludePaths,
+                                       const std::vector<std::string>& macroFlags,
+                                       FileDigestCache& fileDigests,
+                                       BaseContextCache* baseCache,
+                                       PreludePchCache* prelude,
+                                       AstFileCache* astCache,
+                                       beta::ApiSnapshotWriter* snapshot) {
+
+    ScopedDebugConfig debugScope(context.debug());
+    context.openDiagnosticsLog();
+
+    std::vector<std::string> Flags1 = buildClangFlags(project1, file1, IncludePaths, macroFlags);
+    std::vector<std::string> Flags2 = buildClangFlags(project2, file2, IncludePaths, macroFlags);
+    bool usesPrelude = false;
+    if (prelude) {
+        // Part of the base cache key too: trees parsed with and without the PCH are not mixed
+        std::vector<std::string> pch1 = prelude->flagsFor(context, project1, file1, IncludePaths, macroFlags);
+        std::vector<std::string> pch2 = prelude->flagsFor(context, project2, file2, IncludePaths, macroFlags);
+        Flags1.insert(Flags1.end(), pch1.begin(), pch1.end());
+        Flags2.insert(Flags2.end(), pch2.begin(), pch2.end());
+        usesPrelude = !pch1.empty() || !pch2.empty();
+    }
+
+    clang::tooling::FixedCompilationDatabase compDB1(project1, Flags1);
+    clang::tooling::FixedCompilationDatabase compDB2(project2, Flags2);
+
+    logClangFlags(context.debug(), "Processing File1", file1, Flags1);
+    logClangFlags(context.debug(), "Processing File2", file2, Flags2);
+
+    std::string baseKey;
+    std::optional<BaseContextCache::Entry> cachedBase;
+    if (baseCache) {
+        baseKey = BaseContextCache::makeKey(file1, Flags1);
+        cachedBase = baseCache->lookup(baseKey, fileDigests);
+    }
+    // Every file the older parse reads, which keys its trees in the base cache
+    std::vector<std::string> closure1;
+    std::vector<std::string>* recordClosure1 = baseKey.empty() ? nullptr : &closure1;
+
+    // Both parsers intern into one pool of this comparison. With reused trees it is
+    // layered over theirs: shared strings still compare by pointer, but the cached
+    // pool does not grow with every newer header compared against it.
+    std::shared_ptr<StringPool> strings =
+        cachedBase ? std::make_shared<StringPool>(cachedBase->beta->stringPool()) : std::make_shared<StringPool>();
+    alpha::APISession alphaSession(context, strings);
+    beta::APISession betaSession(context, strings);
+
+    // Stored ASTs are read from disk, so revisions read from git are not cached. A
+    // cached AST would also have to load the prelude PCH it was built on.
+    bool cachesAst = astCache && !usesPrelude && !context.sourceFileSystem();
+
+    // Both versions parse the include block they share once (a prelude PCH already
+    // covers it, and the AST cache would keep the older one from being built)
+    std::unique_ptr<SharedPreamble> preamble;
+    if (!cachedBase && !usesPrelude && !cachesAst) {
+        preamble = SharedPreamble::create(context, project1, file1, Flags1, project2, file2, Flags2, fileDigests);
+    }
+
+    PARSING_STATUS header1ParsingStatus;
+    PARSING_STATUS header2ParsingStatus;
+    if (cachedBase) {
+        context.debug().log("Reusing cached trees of " + file1, DebugConfig::Level::INFO);
+        context.debug().log("Cached string pool size: " + std::to_string(cachedBase->beta->stringPool()->size()),
+                            DebugConfig::Level::INFO);
+        alphaSession.addContext(file1, cachedBase->alpha);
+        betaSession.addContext(file1, cachedBase->beta);
+        header1ParsingStatus = cachedBase->parsingStatus;
+        header2ParsingStatus = parseShared(context, alphaSession, betaSession, file2, compDB2);
+    } else {
+        std::tie(header1ParsingStatus, header2ParsingStatus) = parseHeaderPairConcurrently(
+            [&]() {
+                if (cachesAst) {
+                    return parseCached(context, alphaSession, betaSession, file1, compDB1, Flags1, *astCache,
+                                       fileDigests, recordClosure1);
+                }
+                return parseShared(context, alphaSession, betaSession, file1, compDB1, preamble.get(),
+                                   recordClosure1);
+            },
+            [&]() { return parseShared(context, alphaSession, betaSession, file2, compDB2, preamble.get()); });
+        if (!baseKey.empty() && !closure1.empty()) {
+            baseCache->insert(baseKey, std::move(closure1),
+                              {alphaSession.shareContext(file1), betaSession.shareContext(file1),
+                               header1ParsingStatus},
+                              fileDigests);
+        }
+    }
+
+    if (snapshot && header2ParsingStatus == NO_FATAL_ERRORS) {
+        addToSnapshot(*snapshot, betaSession, project2, file2, fileDigests);
+    }
+
+    PARSING_STATUS parsingStatus = header1ParsingStatus == header2ParsingStatus ? header1ParsingStatus : FATAL_ERRORS;
+
+    if (!reportHeaderPairAlpha(alphaSession, project1, file1, file2, reportFormat)) {
+        return FATAL_ERRORS;
+    }
+
+    switch (parsingStatus) {
+        case NO_FATAL_ERRORS:
+            context.debug().log("Processing Headers again via v2", DebugConfig::Level::INFO);
+            reportHeaderPairBeta(betaSession, project1, file1, file2, reportFormat);
+            break;
+        case FATAL_ERRORS:
+            context.debug().log("Processing Headers stopped at v1", DebugConfig::Level::INFO);
+            break;
+    }
+    return parsingStatus;
+}
+
+PARSING_STATUS processHeaderAgainstSnapshot(ArmorContext& context,
+                                            const beta::ApiSnapshot& baseline,
+                                            const std::string& snapshotPath,
+                                            const std::string& header,
+                                            const std::string& project2,
+                                            const std::string& file2,
+                                            const std::string& reportFormat,
+                                            const std::vector<std::string>& IncludePaths,
+                                            const std::vector<std::string>& macroFlags,
+                                            FileDigestCache& fileDigests,
+                                            PreludePchCache* prelude,
+                                            beta::ApiSnapshotWriter* snapshot) {
+
+    ScopedDebugConfig debugScope(context.debug());
+    context.openDiagnosticsLog();
+
+    const std::string file1 = snapshotPath + "/" + header;
+    beta::APISession betaSession(context);
+    std::string error;
+    std::shared_ptr<beta::ASTNormalizedContext> baselineContext =
+        baseline.context(header, betaSession.stringPool(), error);
+    if (!baselineContext) {
+        USER_ERROR(error);
+        return FATAL_ERRORS;
+    }
+
+    std::vector<std::string> Flags2 = buildClangFlags(project2, file2, IncludePaths, macroFlags);
+    if (prelude) {
+        std::vector<std::string> pch2 = prelude->flagsFor(context, project2, file2, IncludePaths, macroFlags);
+        Flags2.insert(Flags2.end(), pch2.begin(), pch2.end());
+    }
+    logClangFlags(context.debug(), "Processing File2", file2, Flags2);
+    context.debug().log("Comparing against the tree of " + header + " in " + snapshotPath,
+                        DebugConfig::Level::INFO);
+
+    betaSession.addContext(file1, std::move(baselineContext));
+    PARSING_STATUS parsingStatus = betaSession.processFile(
+        file2, std::make_unique<clang::tooling::FixedCompilationDatabase>(project2, Flags2));
+    if (parsingStatus != NO_FATAL_ERRORS) {
+        context.debug().log("Processing Headers stopped: " + file2 + " has fatal errors", DebugConfig::Level::ERROR);
+        return parsingStatus;
+    }
+    if (snapshot) {
+        addToSnapshot(*snapshot, betaSession, project2, file2, fileDigests);
+    }
+    reportHeaderPairBeta(betaSession, snapshotPath, file1, file2, reportFormat);
+    return parsingStatus;
+}
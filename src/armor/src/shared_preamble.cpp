@@ -0,0 +1,347 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Basic/Diagnostic.h"
+#include "clang/Basic/FileManager.h"
+#include "clang/Basic/LangOptions.h"
+#include "clang/Basic/SourceManager.h"
+#include "clang/Frontend/CompilerInstance.h"
+#include "clang/Frontend/CompilerInvocation.h"
+#include "clang/Lex/HeaderSearchOptions.h"
+#include "clang/Lex/Lexer.h"
+#include "clang/Lex/PPCallbacks.h"
+#include "clang/Lex/Token.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Path.h"
+
+#include "debug_config.hpp"
+#include "shared_preamble.hpp"
+
+namespace {
+
+llvm::StringRef preambleText(llvm::StringRef contents) {
+    clang::LangOptions langOpts;
+    langOpts.CPlusPlus = true;
+    return contents.take_front(clang::Lexer::ComputePreamble(contents, langOpts).Size);
+}
+
+std::string mainFileOf(const clang::CompilerInvocation& invocation) {
+    const auto& inputs = invocation.getFrontendOpts().Inputs;
+    return inputs.empty() || !inputs.front().isFile() ? std::string() : inputs.front().getFile().str();
+}
+
+std::string joinedPath(llvm::StringRef dir, llvm::StringRef name) {
+    llvm::SmallString<256> path(dir);
+    llvm::sys::path::append(path, name);
+    llvm::sys::path::remove_dots(path, /*remove_dot_dot=*/true);
+    return path.str().str();
+}
+
+// Clang searches -iquote, then -I, then the system groups, then -idirafter
+int searchRank(clang::frontend::IncludeDirGroup group) {
+    switch (group) {
+    case clang::frontend::Quoted:
+        return 0;
+    case clang::frontend::Angled:
+    case clang::frontend::IndexHeaderMap:
+        return 1;
+    case clang::frontend::After:
+        return 3;
+    default:
+        return 2;
+    }
+}
+
+bool isFile(llvm::vfs::FileSystem& fileSystem, const std::string& path) {
+    llvm::ErrorOr<llvm::vfs::Status> status = fileSystem.status(path);
+    return status && status->isRegularFile();
+}
+
+}
+
+// Records the files the preamble was built from and where each of its includes was found
+class SharedPreamble::InputCollector : public clang::PreambleCallbacks {
+public:
+    void BeforeExecute(clang::CompilerInstance& ci) override { m_sourceManager = &ci.getSourceManager(); }
+
+    void AfterExecute(clang::CompilerInstance& ci) override {
+        clang::SourceManager& sourceManager = ci.getSourceManager();
+        for (auto it = sourceManager.fileinfo_begin(); it != sourceManager.fileinfo_end(); ++it) {
+            inputs.files.push_back(it->first->getName().str());
+        }
+    }
+
+    std::unique_ptr<clang::PPCallbacks> createPPCallbacks() override {
+        return std::make_unique<InclusionRecorder>(*this);
+    }
+
+    Inputs inputs;
+
+private:
+    class InclusionRecorder : public clang::PPCallbacks {
+    public:
+        explicit InclusionRecorder(InputCollector& collector) : m_collector(collector) {}
+
+        void InclusionDirective(clang::SourceLocation hashLoc, const clang::Token&, llvm::StringRef fileName,
+                                bool isAngled, clang::CharSourceRange, const clang::FileEntry* file,
+                                llvm::StringRef searchPath, llvm::StringRef relativePath, const clang::Module*,
+                                clang::SrcMgr::CharacteristicKind) override {
+            if (!file || !m_collector.m_sourceManager) {
+                return;
+            }
+            Inclusion inclusion;
+            const clang::SourceManager& sourceManager = *m_collector.m_sourceManager;
+            if (const clang::FileEntry* includer = sourceManager.getFileEntryForID(sourceManager.getFileID(hashLoc))) {
+                inclusion.includerDir = llvm::sys::path::parent_path(includer->getName()).str();
+            }
+            inclusion.name = fileName.str();
+            inclusion.angled = isAngled;
+            inclusion.found = joinedPath(searchPath, relativePath);
+            m_collector.inputs.inclusions.push_back(std::move(inclusion));
+        }
+
+    private:
+        InputCollector& m_collector;
+    };
+
+    const clang::SourceManager* m_sourceManager = nullptr;
+};
+
+// Builds the preamble of the older header, then parses it on top of the preamble.
+class SharedPreamble::BuildingFactory : public clang::tooling::FrontendActionFactory {
+public:
+    BuildingFactory(SharedPreamble& shared, clang::tooling::FrontendActionFactory& inner)
+        : m_shared(shared), m_inner(inner) {}
+
+    // The newer side must not wait for a parse that never got this far
+    ~BuildingFactory() override { m_shared.publish(nullptr, Inputs()); }
+
+    std::unique_ptr<clang::FrontendAction> create() override { return m_inner.create(); }
+
+    bool runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation, clang::FileManager* files,
+                       std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                       clang::DiagnosticConsumer* diagConsumer) override {
+        auto buffer = files->getBufferForFile(mainFileOf(*invocation));
+        if (!buffer) {
+            m_shared.publish(nullptr, Inputs());
+            return m_inner.runInvocation(std::move(invocation), files, std::move(pchContainerOps), diagConsumer);
+        }
+
+        clang::PreambleBounds bounds =
+            clang::ComputePreambleBounds(*invocation->getLangOpts(), (*buffer)->getMemBufferRef(), 0);
+        // The full parse reports any problem in the includes, so the preamble's own diagnostics are dropped
+        llvm::IntrusiveRefCntPtr<clang::DiagnosticsEngine> diagnostics = clang::CompilerInstance::createDiagnostics(
+            &invocation->getDiagnosticOpts(), new clang::IgnoringDiagConsumer(), /*ShouldOwnClient=*/true);
+        InputCollector collector;
+        collector.inputs.searchDirs = searchDirsOf(*invocation, files->getVirtualFileSystem());
+        llvm::ErrorOr<clang::PrecompiledPreamble> built = clang::PrecompiledPreamble::Build(
+            *invocation, buffer->get(), bounds, *diagnostics, files->getVirtualFileSystemPtr(), pchContainerOps,
+            /*StoreInMemory=*/false, collector);
+        if (!built || diagnostics->hasErrorOccurred()) {
+            m_shared.m_context.debug().log("Cannot precompile the preamble of " + m_shared.m_file1 +
+                                           "; parsing both versions in full", DebugConfig::Level::INFO);
+            m_shared.publish(nullptr, Inputs());
+            return m_inner.runInvocation(std::move(invocation), files, std::move(pchContainerOps), diagConsumer);
+        }
+
+        auto preamble = std::make_shared<clang::PrecompiledPreamble>(std::move(*built));
+        m_shared.publish(preamble, std::move(collector.inputs));
+        // The preamble is kept on disk, so the file system is left as it is
+        llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = files->getVirtualFileSystemPtr();
+        preamble->AddImplicitPreamble(*invocation, fileSystem, buffer->get());
+        return m_inner.runInvocation(std::move(invocation), files, std::move(pchContainerOps), diagConsumer);
+    }
+
+private:
+    // The user include directories in the order clang searches them
+    static std::vector<SearchDir> searchDirsOf(const clang::CompilerInvocation& invocation,
+                                               llvm::vfs::FileSystem& fileSystem) {
+        std::vector<std::pair<int, SearchDir>> ranked;
+        for (const auto& entry : invocation.getHeaderSearchOpts().UserEntries) {
+            llvm::SmallString<256> dir(entry.Path);
+            fileSystem.makeAbsolute(dir);
+            llvm::sys::path::remove_dots(dir, /*remove_dot_dot=*/true);
+            ranked.push_back({searchRank(entry.Group), SearchDir{dir.str().str(), entry.Group == clang::frontend::Quoted}});
+        }
+        std::stable_sort(ranked.begin(), ranked.end(),
+                         [](const auto& a, const auto& b) { return a.first < b.first; });
+        std::vector<SearchDir> dirs;
+        for (auto& rankedDir : ranked) {
+            dirs.push_back(std::move(rankedDir.second));
+        }
+        return dirs;
+    }
+
+    SharedPreamble& m_shared;
+    clang::tooling::FrontendActionFactory& m_inner;
+};
+
+// Parses the newer header on top of the older header's preamble when it fits.
+class SharedPreamble::ReusingFactory : public clang::tooling::FrontendActionFactory {
+public:
+    ReusingFactory(SharedPreamble& shared, clang::tooling::FrontendActionFactory& inner)
+        : m_shared(shared), m_inner(inner) {}
+
+    std::unique_ptr<clang::FrontendAction> create() override { return m_inner.create(); }
+
+    bool runInvocation(std::shared_ptr<clang::CompilerInvocation> invocation, clang::FileManager* files,
+                       std::shared_ptr<clang::PCHContainerOperations> pchContainerOps,
+                       clang::DiagnosticConsumer* diagConsumer) override {
+        std::shared_ptr<clang::PrecompiledPreamble> preamble = m_shared.m_preamble.get();
+        auto buffer = files->getBufferForFile(mainFileOf(*invocation));
+        if (preamble && buffer) {
+            clang::PreambleBounds bounds =
+                clang::ComputePreambleBounds(*invocation->getLangOpts(), (*buffer)->getMemBufferRef(), 0);
+            if (preamble->CanReuse(*invocation, (*buffer)->getMemBufferRef(), bounds, files->getVirtualFileSystem()) &&
+                m_shared.inputsMatch() && m_shared.includesResolveAlike(files->getVirtualFileSystem())) {
+                m_shared.m_context.debug().log("Sharing the preamble of " + m_shared.m_file1 + " with " +
+                                               m_shared.m_file2, DebugConfig::Level::INFO);
+                llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = files->getVirtualFileSystemPtr();
+                preamble->AddImplicitPreamble(*invocation, fileSystem, buffer->get());
+            } else {
+                m_shared.m_context.debug().log("Includes of " + m_shared.m_file2 + " differ from " + m_shared.m_file1 +
+                                               "; parsing it in full", DebugConfig::Level::INFO);
+            }
+        }
+        return m_inner.runInvocation(std::move(invocation), files, std::move(pchContainerOps), diagConsumer);
+    }
+
+private:
+    SharedPreamble& m_shared;
+    clang::tooling::FrontendActionFactory& m_inner;
+};
+
+std::unique_ptr<SharedPreamble> SharedPreamble::create(ArmorContext& context,
+                                                       const std::string& projectRoot1, const std::string& file1,
+                                                       const std::vector<std::string>& flags1,
+                                                       const std::string& projectRoot2, const std::string& file2,
+                                                       const std::vector<std::string>& flags2,
+                                                       FileDigestCache& fileDigests) {
+    // The newer command line is the older one with its project root swapped
+    auto rebased = [&](const std::string& flag) {
+        size_t at = flag.find(projectRoot1);
+        return at == std::string::npos ? flag : flag.substr(0, at) + projectRoot2 + flag.substr(at + projectRoot1.size());
+    };
+    if (flags1.size() != flags2.size()) {
+        return nullptr;
+    }
+    for (size_t i = 0; i < flags1.size(); ++i) {
+        if (rebased(flags1[i]) != flags2[i]) {
+            return nullptr;
+        }
+    }
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = context.sourceFileSystem();
+    if (!fileSystem) {
+        fileSystem = llvm::vfs::createPhysicalFileSystem();
+    }
+    auto buffer1 = fileSystem->getBufferForFile(file1);
+    auto buffer2 = fileSystem->getBufferForFile(file2);
+    if (!buffer1 || !buffer2) {
+        return nullptr;
+    }
+    llvm::StringRef preamble1 = preambleText((*buffer1)->getBuffer());
+    if (preamble1.empty() || preamble1 != preambleText((*buffer2)->getBuffer())) {
+        return nullptr;
+    }
+    return std::unique_ptr<SharedPreamble>(new SharedPreamble(context, projectRoot1, file1, projectRoot2, file2,
+                                                              fileDigests));
+}
+
+SharedPreamble::SharedPreamble(ArmorContext& context, std::string projectRoot1, std::string file1,
+                               std::string projectRoot2, std::string file2, FileDigestCache& fileDigests)
+    : m_context(context), m_projectRoot1(std::move(projectRoot1)), m_file1(std::move(file1)),
+      m_projectRoot2(std::move(projectRoot2)), m_file2(std::move(file2)), m_fileDigests(fileDigests),
+      m_preamble(m_promise.get_future().share()) {}
+
+SharedPreamble::~SharedPreamble() = default;
+
+std::unique_ptr<clang::tooling::FrontendActionFactory> SharedPreamble::wrap(
+    const std::string& fileName, clang::tooling::FrontendActionFactory& factory) {
+    if (fileName == m_file1) {
+        return std::make_unique<BuildingFactory>(*this, factory);
+    }
+    return std::make_unique<ReusingFactory>(*this, factory);
+}
+
+void SharedPreamble::publish(std::shared_ptr<clang::PrecompiledPreamble> preamble, Inputs inputs) {
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    if (m_published) {
+        return;
+    }
+    m_published = true;
+    m_inputs = std::move(inputs);
+    m_promise.set_value(std::move(preamble));
+}
+
+bool SharedPreamble::inputsMatch() const {
+    const std::string prefix = m_projectRoot1 + "/";
+    for (const auto& input : m_inputs.files) {
+        if (input == m_file1 || !llvm::StringRef(input).startswith(prefix)) {
+            continue;
+        }
+        std::string counterpart = m_projectRoot2 + "/" + input.substr(prefix.size());
+        if (m_fileDigests.filesDiffer(input, counterpart)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::string SharedPreamble::rebased(const std::string& path) const {
+    const std::string prefix = m_projectRoot1 + "/";
+    return llvm::StringRef(path).startswith(prefix) ? m_projectRoot2 + "/" + path.substr(prefix.size()) : path;
+}
+
+bool SharedPreamble::includesResolveAlike(llvm::vfs::FileSystem& fileSystem) const {
+    const std::string prefix = m_projectRoot1 + "/";
+    for (const auto& inclusion : m_inputs.inclusions) {
+        // The directories the older parse looked in, in order, up to the one it found the file in
+        std::vector<std::string> candidates;
+        if (llvm::sys::path::is_absolute(inclusion.name)) {
+            candidates.push_back(joinedPath(inclusion.name, llvm::StringRef()));
+        } else {
+            if (!inclusion.angled && !inclusion.includerDir.empty()) {
+                candidates.push_back(joinedPath(inclusion.includerDir, inclusion.name));
+            }
+            for (const auto& dir : m_inputs.searchDirs) {
+                if (!inclusion.angled || !dir.quotedOnly) {
+                    candidates.push_back(joinedPath(dir.path, inclusion.name));
+                }
+            }
+        }
+
+        bool alike = false;
+        bool reached = false;
+        for (const auto& older : candidates) {
+            if (older == inclusion.found) {
+                // Its content is compared by inputsMatch
+                reached = true;
+                alike = isFile(fileSystem, rebased(older));
+                break;
+            }
+            // Only a file the newer root adds earlier on the search path changes the result
+            if (llvm::StringRef(older).startswith(prefix) && isFile(fileSystem, rebased(older)) &&
+                !isFile(fileSystem, older)) {
+                m_context.debug().log(rebased(older) + " shadows " + inclusion.found + " in the newer tree",
+                                      DebugConfig::Level::INFO);
+                return false;
+            }
+        }
+        // Found in a directory clang adds itself, which both parses search alike unless it is in the project
+        if (!reached) {
+            alike = !llvm::StringRef(inclusion.found).startswith(prefix);
+        }
+        if (!alike) {
+            return false;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,129 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <map>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/MemoryBuffer.h"
+
+#include "ast_normalized_context.hpp"
+#include "file_digest.hpp"
+#include "string_pool.hpp"
+
+/**
+ * The API snapshot file format (version 1).
+ *
+ * A snapshot holds the normalized trees of the headers of one project root,
+ * each filed under its path relative to that root, with the size and hash of
+ * the header it was parsed from. Every integer is little-endian; every record
+ * has a fixed size and refers to other records by index and to strings by
+ * offset. The file is mapped and its table bounds checked once; a header's
+ * context is then rebuilt in one linear pass over its records, which creates
+ * and interns its nodes, links the children, and fills the lookup maps:
+ *
+ *   file header      magic "ARMORAPI", version, then the count of each table
+ *   headers[]        name, size, hash and the slices of the tables below
+ *   nodes[]          six strings, five enums, a children flag, a child slice
+ *   indices[]        node numbers: children, roots and bucket members
+ *   buckets[]        NSR multimap entry: key and a slice of indices
+ *   usrs[]           usrNodeMap entry: key and node number
+ *   strings          each distinct string once, as length, bytes and a NUL
+ *
+ * Node numbers and slices are global; a header's nodes are contiguous.
+ */
+namespace beta {
+
+/**
+ * @class ApiSnapshot
+ * @brief A snapshot file mapped into memory.
+ */
+class ApiSnapshot {
+public:
+    /**
+     * @brief Returns true if path names a file that starts like a snapshot.
+     */
+    static bool isSnapshot(const std::string& path);
+
+    /**
+     * @brief Maps a snapshot and checks that its tables fit in the file.
+     * @return nullptr, with the reason in error, if it cannot be used.
+     */
+    static std::unique_ptr<ApiSnapshot> open(const std::string& path, std::string& error);
+
+    // Paths of the headers, relative to the snapshot's project root, in sorted order
+    std::vector<llvm::StringRef> headers() const;
+
+    // Size and hash of a header when it was parsed; nullopt if it is not in the snapshot
+    std::optional<FileDigest> digest(llvm::StringRef header) const;
+
+    /**
+     * @brief Builds the normalized context of one header from its records.
+     * @param strings The pool of the session the context will be compared in.
+     * @return nullptr, with the reason in error, if the header is missing or its records are corrupt.
+     */
+    std::shared_ptr<ASTNormalizedContext> context(llvm::StringRef header, std::shared_ptr<StringPool> strings,
+                                                  std::string& error) const;
+
+private:
+    explicit ApiSnapshot(std::unique_ptr<llvm::MemoryBuffer> buffer) : m_buffer(std::move(buffer)) {}
+
+    bool readString(uint32_t offset, llvm::StringRef& string) const;
+
+    std::unique_ptr<llvm::MemoryBuffer> m_buffer;
+    // Start of each table in the buffer, and the number of records in it
+    const char* m_headers = nullptr;
+    const char* m_nodes = nullptr;
+    const char* m_indices = nullptr;
+    const char* m_buckets = nullptr;
+    const char* m_usrs = nullptr;
+    const char* m_strings = nullptr;
+    uint32_t m_nodeCount = 0;
+    uint32_t m_indexCount = 0;
+    uint32_t m_bucketCount = 0;
+    uint32_t m_usrCount = 0;
+    uint32_t m_stringBytes = 0;
+    llvm::StringMap<uint32_t> m_headerIndex;
+};
+
+/**
+ * @class ApiSnapshotWriter
+ * @brief Collects the normalized contexts of headers and writes them as one snapshot.
+ *
+ * Contexts are shared, not copied, and must not change once added. Thread-safe.
+ */
+class ApiSnapshotWriter {
+public:
+    /**
+     * @param header Path of the header relative to its project root; a later
+     *        context for the same header replaces the earlier one.
+     */
+    void add(const std::string& header, FileDigest digest, std::shared_ptr<const ASTNormalizedContext> context);
+
+    size_t size() const;
+
+    /**
+     * @brief Writes the snapshot through a temporary file and an atomic rename.
+     * @return false, with the reason in error, if it cannot be written.
+     */
+    bool write(const std::string& path, std::string& error) const;
+
+private:
+    struct Entry {
+        FileDigest digest;
+        std::shared_ptr<const ASTNormalizedContext> context;
+    };
+
+    mutable std::mutex m_mutex;
+    // Sorted, so equal inputs give byte-identical snapshots
+    std::map<std::string, Entry> m_entries;
+};
+
+}
@@ -5,12 +5,30 @@
 
 #include <string>
 #include <vector>
+#include "armor_context.hpp"
 #include "session.hpp"
 
-PARSING_STATUS processHeaderPairBeta(const std::string& projectRoot1,
+// Parses and diffs one header pair with the beta parser. Logging, diagnostics and
+// reports go to the given context, which may be shared by concurrent calls.
+PARSING_STATUS processHeaderPairBeta(ArmorContext& context,
+                       const std::string& projectRoot1,
                        const std::string& file1,
                        const std::string& projectRoot2,
                        const std::string& file2,
                        const std::string& reportFormat,
                        const std::vector<std::string>& IncludePaths,
                        const std::vector<std::string>& macroFlags);
+
+/**
+ * @brief Diffs two files already parsed into a session and writes the reports.
+ *
+ * Expects the session to hold a context for both file1 and file2. Reports are
+ * written under the output layout of the session's ArmorContext.
+ *
+ * @return false if the session has no results for one of the files.
+ */
+bool reportHeaderPairBeta(const beta::APISession& session,
+                       const std::string& projectRoot1,
+                       const std::string& file1,
+                       const std::string& file2,
+                       const std::string& reportFormat);
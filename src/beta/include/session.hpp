@@ -3,13 +3,19 @@
 
 #pragma once
 
+#include <memory>
+#include <mutex>
+#include <string>
+
+#include "armor_context.hpp"
 #include "ast_normalized_context.hpp"
 #include "comm_def.hpp"
+#include "string_pool.hpp"
 
 #include "clang/Tooling/CompilationDatabase.h"
 
 // Forward declarations to avoid including heavy Clang headers here
-namespace clang { namespace tooling { class CompilationDatabase; } }
+namespace clang { class ASTConsumer; namespace tooling { class CompilationDatabase; } }
 
 /**
  * @class APISession
@@ -20,6 +26,8 @@ namespace clang { namespace tooling { class CompilationDatabase; } }
  *
  * 1. A map from filenames to their corresponding `ASTNormalizedContext`.
  * 2. A central string pool to unify and reduce memory usage for common strings.
+ *    Every context the session creates interns into it, so the trees of both
+ *    versions of a header compare strings by pointer.
  * 3. A reference to the Clang Compilation Database used for parsing.
  */
 namespace beta{
@@ -28,9 +36,23 @@ class APISession {
 public:
     /**
      * @brief Constructs an APISession.
-     * @param compDB A unique_ptr to the compilation database to be used for all parsing.
-     *        The session takes ownership of the database.
+     * @param context The armor run the session belongs to; its diagnostics log and
+     *        log level are used for every file the session processes. It must
+     *        outlive the session.
      */
+    explicit APISession(ArmorContext& context);
+
+    /**
+     * @brief Constructs an APISession interning into an existing pool.
+     * @param strings The pool of contexts that will be added to the session
+     *        with addContext, e.g. those of an earlier run.
+     */
+    APISession(ArmorContext& context, std::shared_ptr<StringPool> strings);
+
+    ArmorContext& context() const { return m_context; }
+
+    const std::shared_ptr<StringPool>& stringPool() const { return m_strings; }
+
     /**
      * @brief Processes a source file, normalizing its AST and storing the context.
      *
@@ -41,6 +63,18 @@ public:
      */
     PARSING_STATUS processFile(std::string fileName, std::unique_ptr<clang::tooling::FixedCompilationDatabase> m_compDB);
 
+    /**
+     * @brief Returns a consumer that fills the context of a file.
+     *
+     * Lets a caller that already drives its own Clang run (for example one that
+     * feeds several sessions from a single parse) populate this session without
+     * going through processFile. The context must have been created first with
+     * createNormalizedASTContext.
+     *
+     * @param fileName The path of the file the consumer will see.
+     */
+    std::unique_ptr<clang::ASTConsumer> createConsumer(const std::string& fileName);
+
     /**
      * @brief Retrieves the normalized context for a previously processed file.
      * @param filename The path to the source file.
@@ -54,9 +88,30 @@ public:
 
     void createNormalizedASTContext(const std::string& key);
 
+    /**
+     * @brief Adds a context normalized outside this session, e.g. one kept from an earlier run.
+     *
+     * The context is shared, not copied; it must not be modified afterwards.
+     * It must intern into the session's pool or a parent of it, or
+     * std::invalid_argument is thrown.
+     */
+    void addContext(const std::string& key, std::shared_ptr<beta::ASTNormalizedContext> context);
+
+    /**
+     * @brief Returns shared ownership of a file's context so it can outlive the session.
+     */
+    std::shared_ptr<beta::ASTNormalizedContext> shareContext(const std::string& fileName) const;
+
 private:
+    ArmorContext& m_context;
+    std::shared_ptr<StringPool> m_strings;
+
+    // Guards m_contexts so both sides of a header pair can be processed concurrently.
+    // Entries are never erased, so returned context pointers stay valid.
+    mutable std::mutex m_contextsMutex;
+
     // A map from a filename to its fully normalized AST context
-    llvm::StringMap<std::unique_ptr<beta::ASTNormalizedContext>> m_contexts;
+    llvm::StringMap<std::shared_ptr<beta::ASTNormalizedContext>> m_contexts;
 };
 
 }
\ No newline at end of file
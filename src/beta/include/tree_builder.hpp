@@ -11,6 +11,7 @@
 #include "ast_normalized_context.hpp"
 #include "node.hpp"
 #include "qualified_name_builder.hpp"
+#include "tree_builder_utils.hpp"
 
 /**
  * @class TreeBuilder
@@ -27,18 +28,22 @@ class TreeBuilder {
 private:
     beta::ASTNormalizedContext* context;
     StringBuilder qualifiedName;
-    std::vector<std::shared_ptr<beta::APINode>> nodeStack;
+    std::vector<beta::APINode*> nodeStack;
+    TypeStringCache typeStrings;
 public:
     /**
      * @brief Constructs a TreeBuilder with the given context.
      * 
      * @param context The ASTNormalizedContext to store the resulting nodes.
+     * @param clangContext The AST the nodes are built from.
      */
-    explicit TreeBuilder(beta::ASTNormalizedContext* context);
+    TreeBuilder(beta::ASTNormalizedContext* context, const clang::ASTContext& clangContext);
+
+    const TypeStringCache& getTypeStrings() const { return typeStrings; }
     
     // Node management
-    void AddNode(const std::shared_ptr<beta::APINode>& node);
-    void PushNode(const std::shared_ptr<beta::APINode>& node);
+    void AddNode(beta::APINode* node);
+    void PushNode(beta::APINode* node);
     void PopNode();
     
     // Name management
@@ -0,0 +1,424 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileUtilities.h"
+
+#include "api_snapshot.hpp"
+#include "node.hpp"
+
+namespace {
+
+constexpr char kMagic[8] = {'A', 'R', 'M', 'O', 'R', 'A', 'P', 'I'};
+constexpr uint32_t kVersion = 1;
+
+// Record sizes in bytes; see the format description in api_snapshot.hpp
+constexpr uint64_t kFileHeaderSize = 40;
+constexpr uint64_t kHeaderRecordSize = 56;
+constexpr uint64_t kNodeRecordSize = 40;
+constexpr uint64_t kIndexSize = 4;
+constexpr uint64_t kBucketSize = 12;
+constexpr uint64_t kUsrSize = 8;
+
+void put32(std::string& out, uint32_t value) {
+    char bytes[4];
+    llvm::support::endian::write32le(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+void put64(std::string& out, uint64_t value) {
+    char bytes[8];
+    llvm::support::endian::write64le(bytes, value);
+    out.append(bytes, sizeof(bytes));
+}
+
+uint32_t get32(const char* record, unsigned field) {
+    return llvm::support::endian::read32le(record + 4 * field);
+}
+
+// Each distinct string once, padded so every length stays 4-byte aligned
+class StringTable {
+public:
+    StringTable() { intern(""); }
+
+    uint32_t intern(llvm::StringRef string) {
+        auto [it, inserted] = m_offsets.try_emplace(string, uint32_t(m_bytes.size()));
+        if (inserted) {
+            put32(m_bytes, uint32_t(string.size()));
+            m_bytes.append(string.data(), string.size());
+            m_bytes.append(4 - string.size() % 4, '\0');
+        }
+        return it->second;
+    }
+
+    const std::string& bytes() const { return m_bytes; }
+
+private:
+    llvm::StringMap<uint32_t> m_offsets;
+    std::string m_bytes;
+};
+
+template <typename Enum>
+bool readEnum(uint8_t value, Enum last, Enum& result) {
+    if (value > static_cast<uint8_t>(last)) {
+        return false;
+    }
+    result = static_cast<Enum>(value);
+    return true;
+}
+
+}
+
+namespace beta {
+
+bool ApiSnapshot::isSnapshot(const std::string& path) {
+    auto buffer = llvm::MemoryBuffer::getFileSlice(path, sizeof(kMagic), 0);
+    return buffer && (*buffer)->getBufferSize() == sizeof(kMagic) &&
+           std::memcmp((*buffer)->getBufferStart(), kMagic, sizeof(kMagic)) == 0;
+}
+
+std::unique_ptr<ApiSnapshot> ApiSnapshot::open(const std::string& path, std::string& error) {
+    // Large files are mapped rather than read
+    auto buffer = llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!buffer) {
+        error = "Cannot read API snapshot " + path + ": " + buffer.getError().message();
+        return nullptr;
+    }
+    std::unique_ptr<ApiSnapshot> snapshot(new ApiSnapshot(std::move(*buffer)));
+    const char* data = snapshot->m_buffer->getBufferStart();
+    const uint64_t size = snapshot->m_buffer->getBufferSize();
+    if (size < kFileHeaderSize || std::memcmp(data, kMagic, sizeof(kMagic)) != 0) {
+        error = path + " is not an API snapshot";
+        return nullptr;
+    }
+    const char* fields = data + sizeof(kMagic);
+    if (get32(fields, 0) != kVersion) {
+        error = "API snapshot " + path + " has version " + std::to_string(get32(fields, 0)) +
+                "; this armor reads version " + std::to_string(kVersion);
+        return nullptr;
+    }
+    uint32_t headerCount = get32(fields, 1);
+    snapshot->m_nodeCount = get32(fields, 2);
+    snapshot->m_indexCount = get32(fields, 3);
+    snapshot->m_bucketCount = get32(fields, 4);
+    snapshot->m_usrCount = get32(fields, 5);
+    snapshot->m_stringBytes = get32(fields, 6);
+
+    uint64_t offset = kFileHeaderSize;
+    auto table = [&](uint64_t count, uint64_t recordSize) {
+        const char* start = data + std::min(offset, size);
+        offset += count * recordSize;
+        return start;
+    };
+    snapshot->m_headers = table(headerCount, kHeaderRecordSize);
+    snapshot->m_nodes = table(snapshot->m_nodeCount, kNodeRecordSize);
+    snapshot->m_indices = table(snapshot->m_indexCount, kIndexSize);
+    snapshot->m_buckets = table(snapshot->m_bucketCount, kBucketSize);
+    snapshot->m_usrs = table(snapshot->m_usrCount, kUsrSize);
+    snapshot->m_strings = table(snapshot->m_stringBytes, 1);
+    if (offset != size) {
+        error = "API snapshot " + path + " is truncated or corrupt";
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < headerCount; ++i) {
+        llvm::StringRef name;
+        if (!snapshot->readString(get32(snapshot->m_headers + i * kHeaderRecordSize, 0), name)) {
+            error = "API snapshot " + path + " is truncated or corrupt";
+            return nullptr;
+        }
+        snapshot->m_headerIndex[name] = i;
+    }
+    return snapshot;
+}
+
+bool ApiSnapshot::readString(uint32_t offset, llvm::StringRef& string) const {
+    if (uint64_t(offset) + 4 > m_stringBytes) {
+        return false;
+    }
+    uint32_t length = llvm::support::endian::read32le(m_strings + offset);
+    if (uint64_t(offset) + 4 + length > m_stringBytes) {
+        return false;
+    }
+    string = llvm::StringRef(m_strings + offset + 4, length);
+    return true;
+}
+
+std::vector<llvm::StringRef> ApiSnapshot::headers() const {
+    std::vector<llvm::StringRef> names;
+    names.reserve(m_headerIndex.size());
+    for (const auto& entry : m_headerIndex) {
+        names.push_back(entry.getKey());
+    }
+    std::sort(names.begin(), names.end());
+    return names;
+}
+
+std::optional<FileDigest> ApiSnapshot::digest(llvm::StringRef header) const {
+    auto it = m_headerIndex.find(header);
+    if (it == m_headerIndex.end()) {
+        return std::nullopt;
+    }
+    const char* record = m_headers + it->second * kHeaderRecordSize;
+    FileDigest digest;
+    digest.size = llvm::support::endian::read64le(record + 8);
+    digest.hash = llvm::support::endian::read64le(record + 16);
+    return digest;
+}
+
+std::shared_ptr<ASTNormalizedContext> ApiSnapshot::context(llvm::StringRef header, std::shared_ptr<StringPool> strings,
+                                                            std::string& error) const {
+    auto it = m_headerIndex.find(header);
+    if (it == m_headerIndex.end()) {
+        error = "Header not in the API snapshot: " + header.str();
+        return nullptr;
+    }
+    const std::string corrupt = "Records of " + header.str() + " in the API snapshot are corrupt";
+    const char* record = m_headers + it->second * kHeaderRecordSize + 24;
+    const uint32_t firstNode = get32(record, 0), nodeCount = get32(record, 1);
+    const uint32_t firstRoot = get32(record, 2), rootCount = get32(record, 3);
+    const uint32_t firstBucket = get32(record, 4), bucketCount = get32(record, 5);
+    const uint32_t firstUsr = get32(record, 6), usrCount = get32(record, 7);
+    auto fits = [](uint32_t first, uint32_t count, uint32_t total) { return uint64_t(first) + count <= total; };
+    if (!fits(firstNode, nodeCount, m_nodeCount) || !fits(firstRoot, rootCount, m_indexCount) ||
+        !fits(firstBucket, bucketCount, m_bucketCount) || !fits(firstUsr, usrCount, m_usrCount)) {
+        error = corrupt;
+        return nullptr;
+    }
+
+    // A header's records only refer to its own nodes
+    auto context = std::make_shared<ASTNormalizedContext>(std::move(strings));
+    std::vector<APINode*> nodes(nodeCount);
+    auto node = [&](uint32_t number) -> APINode* {
+        return number >= firstNode && number - firstNode < nodeCount ? nodes[number - firstNode] : nullptr;
+    };
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        const char* fields = m_nodes + uint64_t(firstNode + i) * kNodeRecordSize;
+        APINode* built = context->createNode();
+        llvm::StringRef* values[] = {&built->qualifiedName, &built->typeName, &built->dataType,
+                                     &built->caonicalType, &built->USR, &built->NSR};
+        for (unsigned field = 0; field < 6; ++field) {
+            llvm::StringRef string;
+            if (!readString(get32(fields, field), string)) {
+                error = corrupt;
+                return nullptr;
+            }
+            *values[field] = context->intern(string);
+        }
+        const uint8_t* enums = reinterpret_cast<const uint8_t*>(fields + 24);
+        if (!readEnum(enums[0], NodeKind::Unknown, built->kind) ||
+            !readEnum(enums[1], AccessSpec::None, built->access) ||
+            !readEnum(enums[2], APINodeStorageClass::Auto, built->storage) ||
+            !readEnum(enums[3], ConstQualifier::ConstExpr, built->constQualifier) ||
+            !readEnum(enums[4], VirtualQualifier::Override, built->virtualQualifier)) {
+            error = corrupt;
+            return nullptr;
+        }
+        nodes[i] = built;
+    }
+
+    // Children are linked once every node exists. A node has one parent, and a
+    // cycle would send the diff round forever.
+    enum class Visit : uint8_t { None, Active, Done };
+    std::vector<Visit> visits(nodeCount, Visit::None);
+    std::vector<bool> linked(nodeCount, false);
+    std::vector<std::pair<uint32_t, uint32_t>> stack;
+    for (uint32_t start = 0; start < nodeCount; ++start) {
+        if (visits[start] != Visit::None) {
+            continue;
+        }
+        stack.push_back({start, 0});
+        visits[start] = Visit::Active;
+        while (!stack.empty()) {
+            auto& [current, next] = stack.back();
+            const char* fields = m_nodes + uint64_t(firstNode + current) * kNodeRecordSize;
+            const uint32_t firstChild = get32(fields, 8), childCount = get32(fields, 9);
+            const bool hasChildren = reinterpret_cast<const uint8_t*>(fields + 24)[5];
+            if (!fits(firstChild, childCount, m_indexCount) || bool(childCount) != hasChildren) {
+                error = corrupt;
+                return nullptr;
+            }
+            if (next == childCount) {
+                visits[current] = Visit::Done;
+                stack.pop_back();
+                continue;
+            }
+            uint32_t number = get32(m_indices, firstChild + next++);
+            APINode* child = node(number);
+            if (!child || visits[number - firstNode] == Visit::Active || linked[number - firstNode]) {
+                error = corrupt;
+                return nullptr;
+            }
+            linked[number - firstNode] = true;
+            nodes[current]->appendChild(child);
+            if (visits[number - firstNode] == Visit::None) {
+                visits[number - firstNode] = Visit::Active;
+                stack.push_back({number - firstNode, 0});
+            }
+        }
+    }
+
+    for (uint32_t i = 0; i < rootCount; ++i) {
+        const APINode* root = node(get32(m_indices, firstRoot + i));
+        if (!root) {
+            error = corrupt;
+            return nullptr;
+        }
+        context->addRootNode(root);
+    }
+    for (uint32_t i = 0; i < bucketCount; ++i) {
+        const char* bucket = m_buckets + uint64_t(firstBucket + i) * kBucketSize;
+        llvm::StringRef key;
+        const uint32_t first = get32(bucket, 1), count = get32(bucket, 2);
+        if (!readString(get32(bucket, 0), key) || !fits(first, count, m_indexCount)) {
+            error = corrupt;
+            return nullptr;
+        }
+        for (uint32_t j = 0; j < count; ++j) {
+            APINode* member = node(get32(m_indices, first + j));
+            if (!member) {
+                error = corrupt;
+                return nullptr;
+            }
+            context->addNode(key, member);
+        }
+    }
+    for (uint32_t i = 0; i < usrCount; ++i) {
+        const char* usr = m_usrs + uint64_t(firstUsr + i) * kUsrSize;
+        llvm::StringRef key;
+        APINode* target = node(get32(usr, 1));
+        if (!readString(get32(usr, 0), key) || !target) {
+            error = corrupt;
+            return nullptr;
+        }
+        context->usrNodeMap[key] = target;
+    }
+    return context;
+}
+
+void ApiSnapshotWriter::add(const std::string& header, FileDigest digest,
+                            std::shared_ptr<const ASTNormalizedContext> context) {
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_entries[header] = {digest, std::move(context)};
+}
+
+size_t ApiSnapshotWriter::size() const {
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    return m_entries.size();
+}
+
+bool ApiSnapshotWriter::write(const std::string& path, std::string& error) const {
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    StringTable strings;
+    std::string headers, nodes, indices, buckets, usrs;
+    uint32_t nodeCount = 0, indexCount = 0, bucketCount = 0, usrCount = 0;
+
+    for (const auto& [header, entry] : m_entries) {
+        const ASTNormalizedContext& context = *entry.context;
+        const uint32_t firstNode = nodeCount;
+        llvm::DenseMap<const APINode*, uint32_t> numbers;
+        std::vector<const APINode*> order;
+        auto number = [&](const APINode* node) {
+            auto [it, inserted] = numbers.try_emplace(node, firstNode + uint32_t(order.size()));
+            if (inserted) {
+                order.push_back(node);
+            }
+            return it->second;
+        };
+        auto addIndex = [&](uint32_t value) {
+            put32(indices, value);
+            return indexCount++;
+        };
+
+        const uint32_t firstRoot = indexCount;
+        for (const APINode* root : context.getRootNodes()) {
+            addIndex(number(root));
+        }
+        // Keys are sorted, so equal inputs give equal files
+        std::vector<llvm::StringRef> bucketKeys;
+        for (const auto& bucket : context.getTree()) {
+            bucketKeys.push_back(bucket.getKey());
+        }
+        std::sort(bucketKeys.begin(), bucketKeys.end());
+        const uint32_t firstBucket = bucketCount;
+        for (llvm::StringRef key : bucketKeys) {
+            const auto& members = context.getTree().find(key)->second;
+            put32(buckets, strings.intern(key));
+            put32(buckets, indexCount);
+            put32(buckets, uint32_t(members.size()));
+            for (const APINode* member : members) {
+                addIndex(number(member));
+            }
+            ++bucketCount;
+        }
+        std::vector<llvm::StringRef> usrKeys;
+        for (const auto& usr : context.usrNodeMap) {
+            usrKeys.push_back(usr.getKey());
+        }
+        std::sort(usrKeys.begin(), usrKeys.end());
+        const uint32_t firstUsr = usrCount;
+        for (llvm::StringRef key : usrKeys) {
+            put32(usrs, strings.intern(key));
+            put32(usrs, number(context.usrNodeMap.find(key)->second));
+            ++usrCount;
+        }
+
+        // Numbering a node's children may number further nodes, which the loop then reaches
+        for (size_t i = 0; i < order.size(); ++i) {
+            const APINode& node = *order[i];
+            for (const llvm::StringRef* string : {&node.qualifiedName, &node.typeName, &node.dataType,
+                                                  &node.caonicalType, &node.USR, &node.NSR}) {
+                put32(nodes, strings.intern(*string));
+            }
+            const uint8_t enums[8] = {static_cast<uint8_t>(node.kind), static_cast<uint8_t>(node.access),
+                                      static_cast<uint8_t>(node.storage), static_cast<uint8_t>(node.constQualifier),
+                                      static_cast<uint8_t>(node.virtualQualifier), node.hasChildren(), 0, 0};
+            nodes.append(reinterpret_cast<const char*>(enums), sizeof(enums));
+            std::vector<uint32_t> children;
+            for (const APINode* child : node.children()) {
+                children.push_back(number(child));
+            }
+            put32(nodes, indexCount);
+            put32(nodes, uint32_t(children.size()));
+            for (uint32_t child : children) {
+                addIndex(child);
+            }
+        }
+        nodeCount += uint32_t(order.size());
+
+        put32(headers, strings.intern(header));
+        put32(headers, 0);
+        put64(headers, entry.digest.size);
+        put64(headers, entry.digest.hash);
+        for (uint32_t value : {firstNode, nodeCount - firstNode, firstRoot, uint32_t(context.getRootNodes().size()),
+                               firstBucket, bucketCount - firstBucket, firstUsr, usrCount - firstUsr}) {
+            put32(headers, value);
+        }
+    }
+
+    std::string file(kMagic, sizeof(kMagic));
+    for (uint32_t value : {kVersion, uint32_t(m_entries.size()), nodeCount, indexCount, bucketCount, usrCount,
+                           uint32_t(strings.bytes().size()), 0u}) {
+        put32(file, value);
+    }
+    for (const std::string* table : {&headers, &nodes, &indices, &buckets, &usrs}) {
+        file += *table;
+    }
+    file += strings.bytes();
+    if (llvm::Error writeError = llvm::writeFileAtomically(path + ".tmp%%%%%%", path, file)) {
+        error = "Cannot write API snapshot " + path + ": " + llvm::toString(std::move(writeError));
+        return false;
+    }
+    return true;
+}
+
+}
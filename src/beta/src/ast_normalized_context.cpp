@@ -5,26 +5,33 @@
 #include "ast_normalized_context.hpp"
 #include <llvm-14/llvm/ADT/SmallVector.h>
 #include <llvm-14/llvm/ADT/StringRef.h>
-#include <memory>
+#include <new>
+#include <type_traits>
 #include <utility>
 
-beta::ASTNormalizedContext::ASTNormalizedContext() = default;
+static_assert(std::is_trivially_destructible_v<beta::APINode>, "nodes are freed without running destructors");
 
-void beta::ASTNormalizedContext::addNode(llvm::StringRef key, std::shared_ptr<beta::APINode> node) {
-    apiNodesMap[key].emplace_back(std::move(node));
+beta::ASTNormalizedContext::ASTNormalizedContext(std::shared_ptr<StringPool> strings) : strings(std::move(strings)) {}
+
+beta::APINode* beta::ASTNormalizedContext::createNode() {
+    return new (nodeArena.Allocate<beta::APINode>()) beta::APINode();
+}
+
+void beta::ASTNormalizedContext::addNode(llvm::StringRef key, beta::APINode* node) {
+    apiNodesMap[key].push_back(node);
 }
 
-void beta::ASTNormalizedContext::addRootNode(std::shared_ptr<const beta::APINode> rootNode) {
+void beta::ASTNormalizedContext::addRootNode(const beta::APINode* rootNode) {
     if (rootNode) {
-        apiNodes.push_back(std::move(rootNode));
+        apiNodes.push_back(rootNode);
     }
 }
 
-const llvm::StringMap<llvm::SmallVector<std::shared_ptr<beta::APINode>,16>>& beta::ASTNormalizedContext::getTree() const {
+const llvm::StringMap<llvm::TinyPtrVector<beta::APINode*>>& beta::ASTNormalizedContext::getTree() const {
     return apiNodesMap;
 }
 
-const llvm::SmallVector<std::shared_ptr<const beta::APINode>,64>& beta::ASTNormalizedContext::getRootNodes() const {
+const llvm::SmallVector<const beta::APINode*,64>& beta::ASTNormalizedContext::getRootNodes() const {
     return apiNodes;
 }
 
@@ -35,6 +42,8 @@ bool beta::ASTNormalizedContext::empty() const {
 void beta::ASTNormalizedContext::clear() {
     apiNodesMap.clear();
     apiNodes.clear();
+    usrNodeMap.clear();
+    nodeArena.Reset();
 }
 
 void beta::ASTNormalizedContext::addClangASTContext(clang::ASTContext *ASTContext){
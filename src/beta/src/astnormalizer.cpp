@@ -3,16 +3,19 @@
 
 #include<iostream>
 #include <llvm-14/llvm/Support/Casting.h>
+#include <string>
 
 #include "astnormalizer.hpp"
+#include "debug_config.hpp"
 #include "node.hpp"
 #include "session.hpp"
 #include "tree_builder.hpp"
+#include "tree_builder_utils.hpp"
 #include "clang/AST/RecursiveASTVisitor.h"
 
 // --- beta::ASTNormalize ---
 beta::ASTNormalize::ASTNormalize(beta::APISession* session, beta::ASTNormalizedContext* context, clang::ASTContext* clangContext)
-    : session(session), context(context), clangContext(clangContext), treeBuilder(beta::TreeBuilder(context)) {}
+    : session(session), context(context), clangContext(clangContext), treeBuilder(context, *clangContext) {}
 // (Implementation of visitor methods remains the same conceptually)
 
 
@@ -25,7 +28,15 @@ void beta::ASTNormalizeConsumer::HandleTranslationUnit(clang::ASTContext &clangC
     // Creates the visitor, passing along the pointers to the session and the pre-existing context.
     context->addClangASTContext(&clangContext);
     beta::ASTNormalize visitor(session, context, &clangContext);
+    // Descend only into the header's own top-level declarations; everything the
+    // include closure declares would be rejected by the tree builder anyway.
+    clangContext.setTraversalScope(getMainFileTopLevelDecls(clangContext));
     visitor.TraverseDecl(clangContext.getTranslationUnitDecl());
+    clangContext.setTraversalScope({clangContext.getTranslationUnitDecl()});
+
+    const TypeStringCache& typeStrings = visitor.treeBuilder.getTypeStrings();
+    DebugConfig::instance().log("Type strings: " + std::to_string(typeStrings.misses()) + " printed, " +
+                                std::to_string(typeStrings.hits()) + " reused", DebugConfig::Level::INFO);
 }
 
 
@@ -4,7 +4,9 @@
 #include <cassert>
 #include <cstddef>
 #include <llvm-14/llvm/ADT/StringRef.h>
+#include <llvm/ADT/DenseMap.h>
 #include <llvm/ADT/SmallVector.h>
+#include <llvm/ADT/TinyPtrVector.h>
 #include <utility>
 
 #include "diffengine.hpp"
@@ -14,31 +16,37 @@
 
 using json = nlohmann::json;
 
-const bool inline hasChildren(const std::shared_ptr<const beta::APINode>& node) {
-    return node->children == nullptr ? false : !node->children->empty();
+// Number of nodes filed under key, none if it is not in the tree
+size_t inline countOf(const llvm::StringMap<llvm::TinyPtrVector<beta::APINode*>>& tree, llvm::StringRef key) {
+    auto it = tree.find(key);
+    return it == tree.end() ? 0 : it->second.size();
 }
 
+// Map keyed by the data pointer of strings interned in one pool
+template <typename Value>
+using InternedMap = llvm::DenseMap<const char*, Value>;
+
 namespace{
-    const json toJson(const std::shared_ptr<const beta::APINode>& node) {
+    const json toJson(const beta::APINode* node) {
     
         json json_node;
 
-        if(!node->qualifiedName.empty()) json_node[QUALIFIED_NAME] = node->qualifiedName;
+        if(!node->qualifiedName.empty()) json_node[QUALIFIED_NAME] = node->qualifiedName.str();
         json_node[NODE_TYPE] = serialize(node->kind);
 
-        if(hasChildren(node)) {
+        if(node->hasChildren()) {
             json_node[CHILDREN] = json::array();
-            for (const auto& childNode : *node->children) {
+            for (const beta::APINode* childNode : node->children()) {
                 json_node[CHILDREN].emplace_back(toJson(childNode));
             }
         }
 
-        if(!node->dataType.empty()) json_node[DATA_TYPE] = node->dataType;
+        if(!node->dataType.empty()) json_node[DATA_TYPE] = node->dataType.str();
 
         return json_node;
     }
 
-    const json get_json_from_node(const std::shared_ptr<const beta::APINode> node, const std::string& tag) {
+    const json get_json_from_node(const beta::APINode* node, const std::string& tag) {
         json json_node = toJson(node);
         json_node[TAG] = tag;
         return json_node;
@@ -46,39 +54,40 @@ namespace{
 }
 
 json diffNodes(
-    const std::shared_ptr<const beta::APINode>& a, 
-    const std::shared_ptr<const beta::APINode>& b) // we are not using the map for now.
+    const beta::APINode* a, 
+    const beta::APINode* b) // we are not using the map for now.
 {
     
     // Any node can have children.
     assert(a->kind == b->kind);
 
-    if (hasChildren(a) && hasChildren(b)) {
+    if (a->hasChildren() && b->hasChildren()) {
         json childrenDiff = json::array();
 
-        // Create StringMaps for a->children and b->children
-        llvm::StringMap<llvm::SmallVector<std::shared_ptr<const beta::APINode>,16>> aNSRMap;
-        llvm::StringMap<llvm::SmallVector<std::shared_ptr<const beta::APINode>,16>> bNSRMap;
-        llvm::StringMap<std::shared_ptr<const beta::APINode>> aUSRMap;
-        llvm::StringMap<std::shared_ptr<const beta::APINode>> bUSRMap;
+        // Maps for a->children and b->children, keyed by the interned NSR and
+        // USR strings, so a lookup hashes and compares pointers only
+        InternedMap<llvm::TinyPtrVector<const beta::APINode*>> aNSRMap;
+        InternedMap<llvm::TinyPtrVector<const beta::APINode*>> bNSRMap;
+        InternedMap<const beta::APINode*> aUSRMap;
+        InternedMap<const beta::APINode*> bUSRMap;
         
         // Populate maps
-        for (const auto& childNode : *a->children) {
-            aNSRMap[childNode->NSR].emplace_back(std::move(childNode));
+        for (const beta::APINode* childNode : a->children()) {
+            aNSRMap[childNode->NSR.data()].push_back(childNode);
             if (!childNode->USR.empty()) {
-                aUSRMap.try_emplace(childNode->USR,std::move(childNode));
+                aUSRMap.try_emplace(childNode->USR.data(), childNode);
             }
         }
         
-        for (const auto& childNode : *b->children) {
-            bNSRMap[childNode->NSR].emplace_back(childNode);
+        for (const beta::APINode* childNode : b->children()) {
+            bNSRMap[childNode->NSR.data()].push_back(childNode);
             if (!childNode->USR.empty()) {
-                bUSRMap.try_emplace(childNode->USR,std::move(childNode));
+                bUSRMap.try_emplace(childNode->USR.data(), childNode);
             }
         }
         
-        for (const auto& childNodeA : *a->children) {
-            llvm::StringRef key = childNodeA->NSR;
+        for (const beta::APINode* childNodeA : a->children()) {
+            const char* key = childNodeA->NSR.data();
             auto it = bNSRMap.find(key);
             if (it == bNSRMap.end()) {
                 childrenDiff.emplace_back(get_json_from_node(childNodeA, REMOVED));
@@ -88,10 +97,10 @@ json diffNodes(
                 size_t countB = bNSRMap[key].size();
                 if (countA + countB > 2) {
                     assert(!childNodeA->USR.empty());
-                    key = childNodeA->USR;
+                    key = childNodeA->USR.data();
                     auto usrIt = bUSRMap.find(key);
                     if (usrIt != bUSRMap.end()) {
-                        const std::shared_ptr<const beta::APINode> childNodeB = usrIt->second;
+                        const beta::APINode* childNodeB = usrIt->second;
                         json sameScopeDiff = diffNodes(childNodeA, childNodeB);
                         if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()) {
                             if (sameScopeDiff.is_array()) {
@@ -108,7 +117,7 @@ json diffNodes(
                 } 
                 else {
                     assert(countA+countB == 2);
-                    const std::shared_ptr<const beta::APINode> childNodeB = it->second[0];
+                    const beta::APINode* childNodeB = it->second[0];
                     json sameScopeDiff = diffNodes(childNodeA, childNodeB);
                     if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()) {
                         if (sameScopeDiff.is_array()) {
@@ -122,12 +131,11 @@ json diffNodes(
             }
         }
     
-        for (const auto& childNodeB : *b->children) {
+        for (const beta::APINode* childNodeB : b->children()) {
 
-            llvm::StringRef key = childNodeB->NSR;
+            const char* key = childNodeB->NSR.data();
 
-            auto it = aNSRMap.find(key);
-            if (aNSRMap.find(childNodeB->NSR) == aNSRMap.end()) {
+            if (aNSRMap.find(key) == aNSRMap.end()) {
                 childrenDiff.emplace_back(get_json_from_node(childNodeB, ADDED));
             }
             else{
@@ -135,7 +143,7 @@ json diffNodes(
                 size_t count2 = bNSRMap[key].size();
                 if (count1 + count2 > 2) {
                     assert(!childNodeB->USR.empty());
-                    key = childNodeB->USR;
+                    key = childNodeB->USR.data();
                     auto usrIt = aUSRMap.find(key);
                     if (usrIt == aUSRMap.end()){
                         childrenDiff.emplace_back(get_json_from_node(childNodeB, ADDED));
@@ -155,24 +163,24 @@ json diffNodes(
         
         if (!childrenDiff.empty()) {
             json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
+            diff[QUALIFIED_NAME] = a->qualifiedName.str();
             diff[NODE_TYPE] = serialize(a->kind);
             if (!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
             diff[TAG] = MODIFIED;
             return json::array().emplace_back(diff);
         }
     }
-    else if(hasChildren(a)){
+    else if(a->hasChildren()){
 
         json childrenDiff = json::array();
 
-        for (const auto& removedNode : *a->children) {
+        for (const beta::APINode* removedNode : a->children()) {
             childrenDiff.emplace_back(get_json_from_node(removedNode, REMOVED));
         }
 
         if(!childrenDiff.empty()){
             json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
+            diff[QUALIFIED_NAME] = a->qualifiedName.str();
             diff[NODE_TYPE] = serialize(a->kind);
             if(!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
             diff[TAG] = MODIFIED;
@@ -180,17 +188,17 @@ json diffNodes(
         }
 
     }
-    else if(hasChildren(b)){
+    else if(b->hasChildren()){
 
         json childrenDiff = json::array();
 
-        for (const auto& addedNode : *b->children) {
+        for (const beta::APINode* addedNode : b->children()) {
             childrenDiff.emplace_back(get_json_from_node(addedNode, ADDED));
         }
 
         if(!childrenDiff.empty()){
             json diff;
-            diff[QUALIFIED_NAME] = a->qualifiedName;
+            diff[QUALIFIED_NAME] = a->qualifiedName.str();
             diff[NODE_TYPE] = serialize(a->kind);
             if(!childrenDiff.empty()) diff[CHILDREN] = childrenDiff;
             diff[TAG] = MODIFIED;
@@ -211,10 +219,12 @@ json diffTrees(
 ) {
     
     json diffs = json::array();
-    llvm::StringMap<llvm::SmallVector<std::shared_ptr<beta::APINode>,16>> tree1 = context1->getTree();
-    llvm::StringMap<llvm::SmallVector<std::shared_ptr<beta::APINode>,16>> tree2 = context2->getTree();
+    const llvm::StringMap<llvm::TinyPtrVector<beta::APINode*>>& tree1 = context1->getTree();
+    const llvm::StringMap<llvm::TinyPtrVector<beta::APINode*>>& tree2 = context2->getTree();
+    // Strings of the two trees are compared by pointer
+    assert(context1->stringPool()->sharesStringsWith(*context2->stringPool()));
 
-    for (auto const &rootNode1 : context1->getRootNodes()) {
+    for (const beta::APINode* rootNode1 : context1->getRootNodes()) {
 
         llvm::StringRef key = rootNode1->NSR;
         
@@ -223,14 +233,14 @@ json diffTrees(
             diffs.emplace_back(get_json_from_node(rootNode1, REMOVED));
         } 
         else {
-            size_t count1 = tree1[key].size();
-            size_t count2 = tree2[key].size();
+            size_t count1 = countOf(tree1, key);
+            size_t count2 = countOf(tree2, key);
             if (count1 + count2 > 2) {
                 assert(!rootNode1->USR.empty());
                 key = rootNode1->USR;
                 auto usrIt = context2->usrNodeMap.find(key);
                 if (usrIt != context2->usrNodeMap.end()) {
-                    const std::shared_ptr<const beta::APINode> rootNode2 = usrIt->second;
+                    const beta::APINode* rootNode2 = usrIt->second;
                     json sameScopeDiff = diffNodes(rootNode1, rootNode2);
                     if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()){
                         if (sameScopeDiff.is_array()){ 
@@ -243,7 +253,7 @@ json diffTrees(
             } 
             else {
                 assert(count1+count2 == 2);
-                const std::shared_ptr<const beta::APINode> rootNode2 = it->second[0];
+                const beta::APINode* rootNode2 = it->second[0];
                 json sameScopeDiff = diffNodes(rootNode1, rootNode2);
                 if (!sameScopeDiff.is_null() && !sameScopeDiff.empty()){
                     if (sameScopeDiff.is_array()){ 
@@ -255,7 +265,7 @@ json diffTrees(
         }
     }
 
-    for (const auto & rootNode2 : context2->getRootNodes()) {
+    for (const beta::APINode* rootNode2 : context2->getRootNodes()) {
         
         llvm::StringRef key = rootNode2->NSR;
 
@@ -264,8 +274,8 @@ json diffTrees(
             diffs.emplace_back(get_json_from_node(rootNode2, ADDED));
         }
         else{
-            size_t count1 = tree1[key].size();
-            size_t count2 = tree2[key].size();
+            size_t count1 = countOf(tree1, key);
+            size_t count2 = countOf(tree2, key);
             if (count1 + count2 > 2) {
                 assert(!rootNode2->USR.empty());
                 key = rootNode2->USR;
@@ -7,13 +7,13 @@
 #include <iostream>
 #include <string>
 
-nlohmann::json beta::APINode::diff(const std::shared_ptr<const beta::APINode>& other) const {
+nlohmann::json beta::APINode::diff(const beta::APINode* other) const {
     nlohmann::json result, removed, added;
 
     // Helper to add metadata to a diff JSON node
     auto appendNodeMetadata  = [&](nlohmann::json& node) {
         node[NODE_TYPE] = serialize(kind);
-        node[QUALIFIED_NAME] = qualifiedName;
+        node[QUALIFIED_NAME] = qualifiedName.str();
     };
     
     // Define a lambda function to compare fields
@@ -28,16 +28,29 @@ nlohmann::json beta::APINode::diff(const std::shared_ptr<const beta::APINode>& o
         }
     };
 
+    // Strings are interned, so equal ones are the same pointer
+    auto compareStrings = [&](const std::string& field, llvm::StringRef lhs, llvm::StringRef rhs) {
+        if (!sameInterned(lhs, rhs)) {
+            if (!lhs.empty()) {
+                removed[field] = lhs.str();
+            }
+            if (!rhs.empty()) {
+                added[field] = rhs.str();
+            }
+        }
+    };
+
     // Compare fields
-    if( dataType != other->dataType ){
+    if( !sameInterned(dataType, other->dataType) ){
 
         if(kind == NodeKind::FunctionPointer){
-            compare(DATA_TYPE, dataType, other->dataType, std::string{});
+            compareStrings(DATA_TYPE, dataType, other->dataType);
         }
-        else{
+        // Equal structural hashes are the same canonical type, whatever its spelling
+        else if(typeHash == 0 || typeHash != other->typeHash){
             assert(!caonicalType.empty());
             assert(!other->caonicalType.empty());
-            compare(DATA_TYPE, caonicalType, other->caonicalType, std::string{});
+            compareStrings(DATA_TYPE, caonicalType, other->caonicalType);
         }
     }
     
@@ -76,7 +89,7 @@ nlohmann::json beta::APINode::diff(const std::shared_ptr<const beta::APINode>& o
             }
         };
 
-        if (this->children == nullptr) {
+        if (!hasChildren()) {
             nlohmann::json children = nlohmann::json::array();
             processChanges(children);
 
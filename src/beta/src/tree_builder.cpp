@@ -27,29 +27,27 @@
 #include <string_view>
 #include <utility>
 
-beta::TreeBuilder::TreeBuilder(beta::ASTNormalizedContext* context): context(context) {}
+beta::TreeBuilder::TreeBuilder(beta::ASTNormalizedContext* context, const clang::ASTContext& clangContext)
+    : context(context), typeStrings(clangContext, *context->stringPool()) {}
 
 inline bool beta::TreeBuilder::IsFromMainFileAndNotLocal(const clang::Decl* Decl) {
     clang::ASTContext* clangContext = &Decl->getASTContext();
     return clangContext->getSourceManager().isInMainFile(Decl->getLocation()) && Decl->getParentFunctionOrMethod() == nullptr;
 }
 
-inline void beta::TreeBuilder::AddNode(const std::shared_ptr<APINode>& node) {
+inline void beta::TreeBuilder::AddNode(APINode* node) {
     
     assert(!node->NSR.empty());
     
     if (!nodeStack.empty()) {
-        if (nodeStack.back()->children == nullptr) {
-            nodeStack.back()->children = std::make_unique<llvm::SmallVector<std::shared_ptr<const APINode>, 16>>();
-        }
-        nodeStack.back()->children->push_back(node);
+        nodeStack.back()->appendChild(node);
     }
     else context->addRootNode(node);
     
     if (nodeStack.empty()) context->addNode(node->NSR, node);
 }
 
-inline void beta::TreeBuilder::PushNode(const std::shared_ptr<APINode>& node) {
+inline void beta::TreeBuilder::PushNode(APINode* node) {
     nodeStack.push_back(node);
 }
 
@@ -72,38 +70,40 @@ inline const std::string beta::TreeBuilder::GetCurrentQualifiedName() {
 }
 
 void beta::TreeBuilder::BuildReturnTypeNode(clang::QualType type) {
-    auto returnNode = std::make_shared<APINode>();
+    auto returnNode = context->createNode();
     returnNode->kind = NodeKind::ReturnType;
-    auto [dataType,canonicalType] = getTypesWithAndWithoutTypeResolution(type, *context->getClangASTContext());    
+    auto [dataType, canonicalType, typeHash] = typeStrings.getTypesWithAndWithoutTypeResolution(type);
     PushName("(ReturnType)");
     returnNode->dataType = dataType;
     returnNode->caonicalType = canonicalType;
-    returnNode->NSR = "(ReturnType)";
-    returnNode->qualifiedName = GetCurrentQualifiedName();
+    returnNode->typeHash = typeHash;
+    returnNode->NSR = context->intern("(ReturnType)");
+    returnNode->qualifiedName = context->intern(GetCurrentQualifiedName());
     AddNode(returnNode);
     PopName();
 
-    DebugConfig::instance().log("BuildReturnType V2: " + returnNode->dataType, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("BuildReturnType V2: " + returnNode->dataType.str(), DebugConfig::Level::DEBUG);
 }
 
 void beta::TreeBuilder::normalizeFunctionPointerType(std::string_view typeModifiers, const clang::FunctionProtoTypeLoc FTL, const clang::NamedDecl* Decl) {
-    auto functionPointerNode = std::make_shared<APINode>();
+    auto functionPointerNode = context->createNode();
     functionPointerNode->kind = NodeKind::FunctionPointer;
-    functionPointerNode->qualifiedName = GetCurrentQualifiedName();
-    functionPointerNode->dataType = typeModifiers;
+    functionPointerNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+    functionPointerNode->dataType = context->intern(typeModifiers);
     if(llvm::isa<clang::ParmVarDecl>(Decl)){
         // If ParamVarDecl is a functionPointer then the NSR is QualifiedName.
         functionPointerNode->NSR = functionPointerNode->qualifiedName;
     }
     else{
-        functionPointerNode->NSR = generateNSRForDecl(Decl);
-        functionPointerNode->USR = generateUSRForDecl(Decl);
+        const auto [USR, NSR] = generateIdentifiersForDecl(Decl);
+        functionPointerNode->NSR = context->intern(NSR);
+        functionPointerNode->USR = context->intern(USR);
     }
     
     AddNode(functionPointerNode);
     PushNode(functionPointerNode);
     
-    DebugConfig::instance().log("BuildFunctionPointerType V2: " + functionPointerNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("BuildFunctionPointerType V2: " + functionPointerNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     
     const size_t numParams = FTL.getNumParams();
     for (unsigned int pos=0 ; pos < numParams ; ++pos) {
@@ -116,10 +116,10 @@ void beta::TreeBuilder::normalizeFunctionPointerType(std::string_view typeModifi
 
 void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, unsigned int pos) {
     
-    const std::string USR = generateUSRForDecl(Decl);
+    const auto [USR, NSR] = generateIdentifiersForDecl(Decl);
     if( context->usrNodeMap.find(USR) != context->usrNodeMap.end() ) return;
 
-    auto ValueNode = std::make_shared<APINode>();
+    auto ValueNode = context->createNode();
     clang::QualType unDecayedDeclType = clang::QualType();
     clang::TypeSourceInfo *TSI = nullptr;
     llvm::SmallString<128> nameBuf;
@@ -150,27 +150,25 @@ void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, uns
     } 
     else return;
 
-    auto [dataType, canonicalType] = getTypesWithAndWithoutTypeResolution(unDecayedDeclType, Decl->getASTContext());
-
     if (llvm::isa<clang::ParmVarDecl>(Decl)) {
         // NSR for param Decl is the position as they should be identified by position.
-        ValueNode->NSR = std::to_string(pos);
-        ValueNode->qualifiedName = GetCurrentQualifiedName();
-        DebugConfig::instance().log("VisitParamDecl V2: " + ValueNode->qualifiedName, DebugConfig::Level::DEBUG);
+        ValueNode->NSR = context->intern(std::to_string(pos));
+        ValueNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+        DebugConfig::instance().log("VisitParamDecl V2: " + ValueNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     } 
     else if (llvm::isa<clang::FieldDecl>(Decl)) {
-        ValueNode->qualifiedName = GetCurrentQualifiedName();
-        ValueNode->NSR = generateNSRForDecl(Decl);
-        ValueNode->USR = USR;
+        ValueNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+        ValueNode->NSR = context->intern(NSR);
+        ValueNode->USR = context->intern(USR);
         context->usrNodeMap.insert_or_assign(std::move(USR),ValueNode);
-        DebugConfig::instance().log("VisitFeildDecl V2: " + ValueNode->qualifiedName, DebugConfig::Level::DEBUG);
+        DebugConfig::instance().log("VisitFeildDecl V2: " + ValueNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     } 
     else if (llvm::dyn_cast_or_null<clang::VarDecl>(Decl)) {
-        ValueNode->qualifiedName = GetCurrentQualifiedName();
-        ValueNode->NSR = generateNSRForDecl(Decl);
-        ValueNode->USR = USR;
+        ValueNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+        ValueNode->NSR = context->intern(NSR);
+        ValueNode->USR = context->intern(USR);
         context->usrNodeMap.insert_or_assign(std::move(USR),ValueNode);
-        DebugConfig::instance().log("VisitVarDecl V2: " + ValueNode->qualifiedName, DebugConfig::Level::DEBUG);
+        DebugConfig::instance().log("VisitVarDecl V2: " + ValueNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     } 
 
     AddNode(ValueNode);
@@ -183,8 +181,12 @@ void beta::TreeBuilder::normalizeValueDeclNode(const clang::ValueDecl *Decl, uns
             PopNode();
         }
         else{
+            // Function pointers describe their type through child nodes; only
+            // other types need printing
+            auto [dataType, canonicalType, typeHash] = typeStrings.getTypesWithAndWithoutTypeResolution(unDecayedDeclType);
             ValueNode->dataType = dataType;
             ValueNode->caonicalType = canonicalType;
+            ValueNode->typeHash = typeHash;
         }
     }
     
@@ -236,18 +238,17 @@ bool beta::TreeBuilder::BuildCXXRecordNode(clang::CXXRecordDecl* Decl) {
         }
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    const std::string NSR = generateNSRForDecl(Decl);
+    const auto [USR, NSR] = generateIdentifiersForDecl(Decl);
 
     const auto it = context->usrNodeMap.find(USR);
-    std::shared_ptr<APINode> cxxRecordNode = (it != context->usrNodeMap.end()) ? it->second : std::make_shared<APINode>();
-    cxxRecordNode->NSR = NSR;
-    cxxRecordNode->USR = USR;
+    APINode* cxxRecordNode = (it != context->usrNodeMap.end()) ? it->second : context->createNode();
+    cxxRecordNode->NSR = context->intern(NSR);
+    cxxRecordNode->USR = context->intern(USR);
     if(it == context->usrNodeMap.end()) AddNode(cxxRecordNode);
-    cxxRecordNode->qualifiedName = GetCurrentQualifiedName();
+    cxxRecordNode->qualifiedName = context->intern(GetCurrentQualifiedName());
     context->usrNodeMap.insert_or_assign(std::move(USR),cxxRecordNode);
 
-    DebugConfig::instance().log("VisitCxxRecordDecl V2: " + cxxRecordNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("VisitCxxRecordDecl V2: " + cxxRecordNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
 
     if( Decl->isStruct() ){
         cxxRecordNode->kind = NodeKind::Struct;
@@ -306,18 +307,17 @@ bool beta::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
         }
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
-    const std::string NSR = generateNSRForDecl(Decl);
+    const auto [USR, NSR] = generateIdentifiersForDecl(Decl);
 
     const auto it = context->usrNodeMap.find(USR);
-    std::shared_ptr<APINode> enumNode = (it != context->usrNodeMap.end()) ? it->second : std::make_shared<APINode>();
-    enumNode->NSR = NSR;
-    enumNode->USR = USR;
+    APINode* enumNode = (it != context->usrNodeMap.end()) ? it->second : context->createNode();
+    enumNode->NSR = context->intern(NSR);
+    enumNode->USR = context->intern(USR);
     if(it == context->usrNodeMap.end()) AddNode(enumNode);
-    enumNode->qualifiedName = GetCurrentQualifiedName();
+    enumNode->qualifiedName = context->intern(GetCurrentQualifiedName());
     context->usrNodeMap.insert_or_assign(std::move(USR),enumNode);
     
-    DebugConfig::instance().log("VisitEnumDecl V2: " + enumNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("VisitEnumDecl V2: " + enumNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
     
     enumNode->kind = NodeKind::Enum;
     PushNode(enumNode);
@@ -326,12 +326,13 @@ bool beta::TreeBuilder::BuildEnumNode(clang::EnumDecl* Decl){
     std::string enumaratorDataType = enumType.getAsString();
      
     for (const auto* EnumConstDecl : Decl->enumerators()) {
-        auto enumValNode = std::make_shared<APINode>();
+        auto enumValNode = context->createNode();
         PushName(EnumConstDecl->getName());
-        enumValNode->qualifiedName = GetCurrentQualifiedName();
-        enumValNode->dataType = enumaratorDataType;
-        enumValNode->NSR = generateNSRForDecl(EnumConstDecl);
-        enumValNode->USR = generateUSRForDecl(EnumConstDecl);
+        enumValNode->qualifiedName = context->intern(GetCurrentQualifiedName());
+        enumValNode->dataType = context->intern(enumaratorDataType);
+        const auto [USR, NSR] = generateIdentifiersForDecl(EnumConstDecl);
+        enumValNode->NSR = context->intern(NSR);
+        enumValNode->USR = context->intern(USR);
         PopName();
         enumValNode->kind = NodeKind::Enumerator;
         AddNode(enumValNode);
@@ -353,23 +354,23 @@ bool beta::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
         return false;
     }
 
-    const std::string USR = generateUSRForDecl(Decl);
+    const auto [USR, NSR] = generateIdentifiersForDecl(Decl);
     if( context->usrNodeMap.find(USR) != context->usrNodeMap.end() ) return true;
 
     llvm::SmallString<128> nameBuf;
     llvm::raw_svector_ostream OS(nameBuf);
 
-    auto functionNode = std::make_shared<APINode>();
+    auto functionNode = context->createNode();
     Decl->printName(OS);
     PushName(nameBuf);
-    functionNode->qualifiedName = GetCurrentQualifiedName();
+    functionNode->qualifiedName = context->intern(GetCurrentQualifiedName());
     functionNode->kind = NodeKind::Function;
     functionNode->storage = getStorageClass(Decl->getStorageClass());
-    functionNode->NSR = generateNSRForDecl(Decl);
-    functionNode->USR = USR;
+    functionNode->NSR = context->intern(NSR);
+    functionNode->USR = context->intern(USR);
     context->usrNodeMap.insert_or_assign(std::move(USR),functionNode);
 
-    DebugConfig::instance().log("VisitFunctionDecl V2: " + functionNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("VisitFunctionDecl V2: " + functionNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
 
     AddNode(functionNode);
     PushNode(functionNode);
@@ -391,7 +392,7 @@ bool beta::TreeBuilder::BuildFunctionNode(clang::FunctionDecl* Decl){
 bool beta::TreeBuilder::BuildTypedefDecl(clang::TypedefDecl *Decl) {
     if(!IsFromMainFileAndNotLocal(Decl) || Decl->isTemplated()) return false;
 
-    const std::string USR = generateUSRForDecl(Decl);
+    const auto [USR, NSR] = generateIdentifiersForDecl(Decl);
     if( context->usrNodeMap.find(USR) != context->usrNodeMap.end() ) return true;
 
     llvm::SmallString<128> nameBuf;
@@ -399,25 +400,26 @@ bool beta::TreeBuilder::BuildTypedefDecl(clang::TypedefDecl *Decl) {
 
     const clang::QualType underlyingType = Decl->getUnderlyingType();
 
-    auto typeDefNode = std::make_shared<APINode>();
+    auto typeDefNode = context->createNode();
     Decl->printName(OS);
     PushName(nameBuf);
-    typeDefNode->qualifiedName = GetCurrentQualifiedName();
+    typeDefNode->qualifiedName = context->intern(GetCurrentQualifiedName());
     typeDefNode->kind = NodeKind::Typedef;
-    auto [dataType, canonicalType] = getTypesWithAndWithoutTypeResolution(underlyingType, Decl->getASTContext());
+    auto [dataType, canonicalType, typeHash] = typeStrings.getTypesWithAndWithoutTypeResolution(underlyingType);
     typeDefNode->dataType = dataType;
     typeDefNode->caonicalType = canonicalType;
-    typeDefNode->USR = USR;
-    typeDefNode->NSR = generateNSRForDecl(Decl);
+    typeDefNode->typeHash = typeHash;
+    typeDefNode->USR = context->intern(USR);
+    typeDefNode->NSR = context->intern(NSR);
     context->usrNodeMap.insert_or_assign(std::move(USR), typeDefNode);
     
-    DebugConfig::instance().log("VisitTypeDefDecl V2: " + typeDefNode->qualifiedName, DebugConfig::Level::DEBUG);
+    DebugConfig::instance().log("VisitTypeDefDecl V2: " + typeDefNode->qualifiedName.str(), DebugConfig::Level::DEBUG);
 
     if (!llvm::isa<clang::TypedefType>(underlyingType)) {
         if (const clang::TypeSourceInfo *TSI = Decl->getTypeSourceInfo()) {
             auto [typeModifiers,unwrappedTL] = unwrapTypeLoc(TSI->getTypeLoc());
             if (const clang::FunctionProtoTypeLoc FTL = unwrappedTL.getAs<clang::FunctionProtoTypeLoc>()) {
-                typeDefNode->dataType = std::string{};
+                typeDefNode->dataType = llvm::StringRef();
                 PushNode(typeDefNode);
                 normalizeFunctionPointerType(typeModifiers, FTL, Decl);
                 PopNode();
@@ -0,0 +1,70 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <utility>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "debug_config.hpp"
+#include "output_layout.hpp"
+#include "stat_cache.hpp"
+
+/**
+ * @class ArmorContext
+ * @brief Everything one armor run owns: where it writes, its log level, its diagnostics log
+ *        and the stat cache its parses share.
+ *
+ * Nothing in the parse path keeps process-wide state, so several contexts (and
+ * the sessions created from them) can run concurrently in one process. Entry
+ * points install the context's DebugConfig on their thread with a
+ * ScopedDebugConfig so USER_PRINT/USER_ERROR and deep logging reach it.
+ */
+class ArmorContext {
+public:
+    explicit ArmorContext(OutputLayout output = OutputLayout());
+    ~ArmorContext();
+
+    ArmorContext(const ArmorContext&) = delete;
+    ArmorContext& operator=(const ArmorContext&) = delete;
+
+    const OutputLayout& output() const { return m_output; }
+    DebugConfig& debug() { return m_debug; }
+
+    /**
+     * @brief Opens the diagnostics log and makes it this context's log sink.
+     *
+     * Uses $CLANG_DIAG_LOG when set, otherwise the layout's
+     * debug_output/logs/diagnostics.log. Only the first call does any work.
+     */
+    void openDiagnosticsLog();
+
+    /**
+     * @brief Where the project sources are read from when they are not on disk.
+     *
+     * Null (the default) means the real file system. Otherwise the file system
+     * is laid over the real one for every parse and consulted for existence
+     * checks and digests; it must serve absolute paths only and be thread-safe.
+     */
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> sourceFileSystem() const { return m_sources; }
+    void setSourceFileSystem(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> sources) {
+        m_sources = std::move(sources);
+    }
+
+    // Stat results shared by every parse of this run
+    StatCache& statCache() { return m_statCache; }
+
+private:
+    OutputLayout m_output;
+    DebugConfig m_debug;
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> m_sources;
+    StatCache m_statCache;
+
+    std::once_flag m_logOnce;
+    std::unique_ptr<llvm::raw_fd_ostream> m_log;
+};
@@ -9,7 +9,6 @@
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "clang/Basic/LLVM.h"
-#include "llvm/ADT/StringRef.h"
 
 namespace armor {
 
@@ -17,9 +16,12 @@ static inline llvm::StringRef getUSRSpacePrefix() {
   return "c:";
 }
 
-/// Generate a USR for a Decl, including the USR prefix.
+/// Generate the USR and the NSR of a Decl in one traversal, each including the
+/// USR prefix. The NSR leaves out template parameters and arguments and
+/// function signatures, so that overloads and specializations share it.
 /// \returns true if the results should be ignored, false otherwise.
-bool generateUSRForDecl(const clang::Decl *D, llvm::SmallVectorImpl<char> &Buf);
+bool generateUSRAndNSRForDecl(const clang::Decl *D, llvm::SmallVectorImpl<char> &USRBuf,
+                              llvm::SmallVectorImpl<char> &NSRBuf);
 
 /// Generate USR fragment for a global (non-nested) enum.
 void generateUSRForGlobalEnum(llvm::StringRef EnumName, llvm::raw_ostream &OS,
@@ -2,12 +2,15 @@
 // SPDX-License-Identifier: BSD-3-Clause
 
 #pragma once
+#include <atomic>
 #include <string>
 #include <filesystem>
 #include <fstream>
 #include <mutex>
 #include <llvm/Support/raw_ostream.h>
 
+// Log level and sink of one armor run. Every ArmorContext owns one; code deep in
+// the parse path reaches the one of the run it works for through instance().
 class DebugConfig {
 public:
     enum class Level {
@@ -17,13 +20,20 @@ public:
         DEBUG = 3
     };
 
+    DebugConfig() : logLevel(Level::LOG), sink_(nullptr) {}
+
+    // The config installed on this thread by a ScopedDebugConfig, or a
+    // process-wide fallback for code running outside of any armor run.
     static DebugConfig& instance() {
+        if (current_) {
+            return *current_;
+        }
         static DebugConfig inst;
         return inst;
     }
 
-    void setLevel(Level lvl) { logLevel = lvl; }
-    Level getLevel() const { return logLevel; }
+    void setLevel(Level lvl) { logLevel.store(lvl); }
+    Level getLevel() const { return logLevel.load(); }
 
     //allow injecting a shared sink (not owned). Thread-safe.
     void setSink(llvm::raw_ostream* sink) {
@@ -37,8 +47,17 @@ public:
         return sink_;
     }
 
+    //append pre-formatted text (e.g. buffered clang diagnostics) to the sink as one block
+    void write(llvm::StringRef text) const {
+        if (text.empty()) return;
+        std::scoped_lock<std::mutex> lock(mu_);
+        llvm::raw_ostream& out = sink_ ? *sink_ : llvm::errs();
+        out << text;
+        out.flush();
+    }
+
     void log(const std::string& msg, Level lvl = Level::DEBUG) const {
-        if (static_cast<int>(lvl) <= static_cast<int>(logLevel)) {
+        if (static_cast<int>(lvl) <= static_cast<int>(getLevel())) {
             std::scoped_lock<std::mutex> lock(mu_);
             if (sink_) {
                 // Preferred: single shared stream (no cross-buffering)
@@ -62,8 +81,10 @@ public:
     }
 
 private:
-    DebugConfig() : logLevel(Level::LOG), sink_(nullptr) {}
-    Level logLevel;
+    friend class ScopedDebugConfig;
+    inline static thread_local DebugConfig* current_ = nullptr;
+
+    std::atomic<Level> logLevel;
 
     //shared sink pointer (not owned)
     mutable std::mutex mu_;
@@ -82,3 +103,19 @@ private:
     DebugConfig(const DebugConfig&) = delete;
     DebugConfig& operator=(const DebugConfig&) = delete;
 };
+
+// Makes a config the one DebugConfig::instance() returns on the current thread
+// for the lifetime of the guard.
+class ScopedDebugConfig {
+public:
+    explicit ScopedDebugConfig(DebugConfig& config) : previous(DebugConfig::current_) {
+        DebugConfig::current_ = &config;
+    }
+    ~ScopedDebugConfig() { DebugConfig::current_ = previous; }
+
+    ScopedDebugConfig(const ScopedDebugConfig&) = delete;
+    ScopedDebugConfig& operator=(const ScopedDebugConfig&) = delete;
+
+private:
+    DebugConfig* previous;
+};
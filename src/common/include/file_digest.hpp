@@ -0,0 +1,69 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+// Size and 64-bit xxHash of a file's contents.
+struct FileDigest {
+    uint64_t size = 0;
+    uint64_t hash = 0;
+};
+
+/**
+ * @class FileDigestCache
+ * @brief Compares files in-process and remembers the digest of every file it reads.
+ *
+ * Files are memory-mapped by llvm::MemoryBuffer; sizes are compared before any
+ * contents are read. The digests stay available for later stages (caching,
+ * snapshot keys) so a file is only ever hashed once per run. Thread-safe.
+ */
+class FileDigestCache {
+public:
+    /**
+     * @param fileSystem Where files are read from; null means the real file
+     *        system. Must be thread-safe.
+     */
+    explicit FileDigestCache(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = nullptr)
+        : m_fileSystem(std::move(fileSystem)) {}
+
+    /**
+     * @brief Returns true if the two files differ or either cannot be read.
+     */
+    bool filesDiffer(const std::string& file1, const std::string& file2);
+
+    /**
+     * @brief Returns the digest of a file, hashing it on first use.
+     * @return std::nullopt if the file cannot be read.
+     */
+    std::optional<FileDigest> digest(const std::string& path);
+
+    /**
+     * @brief Returns the digest of a file if it has already been computed.
+     */
+    std::optional<FileDigest> lookup(llvm::StringRef path) const;
+
+private:
+    FileDigest remember(llvm::StringRef path, llvm::StringRef contents);
+    llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> mapFile(const std::string& path) const;
+    std::error_code fileSize(const std::string& path, uint64_t& size) const;
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> m_fileSystem;
+
+    mutable std::mutex m_mutex;
+    llvm::StringMap<FileDigest> m_digests;
+};
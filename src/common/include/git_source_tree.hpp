@@ -0,0 +1,70 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+class GitBlobReader;
+class GitRevisionFileSystem;
+
+/**
+ * @class GitSourceTrees
+ * @brief Serves two revisions of a local git repository as project roots, without a checkout.
+ *
+ * Each revision is mounted at an empty directory named after its commit id
+ * (<tmp>/armor-git/<commit>); the mount directory exists on disk only so it can
+ * serve as a compile directory. The file system returned by fileSystem() lists
+ * the tree of each revision from `git ls-tree` and reads a blob through one
+ * persistent `git cat-file --batch` process the first time the file is opened
+ * or stat'ed; blobs read are kept in an llvm::vfs::InMemoryFileSystem.
+ * Paths outside both mounts are not found, so the result is meant to be laid
+ * over the real file system. Thread-safe, and usable from forked workers.
+ */
+class GitSourceTrees {
+public:
+    /**
+     * @brief Resolves both revisions and lists their trees.
+     * @return nullptr and an error message if git cannot be run or a revision is unknown.
+     */
+    static std::unique_ptr<GitSourceTrees> open(const std::string& repoPath,
+                                                const std::string& oldRev,
+                                                const std::string& newRev,
+                                                std::string& error);
+
+    ~GitSourceTrees();
+
+    GitSourceTrees(const GitSourceTrees&) = delete;
+    GitSourceTrees& operator=(const GitSourceTrees&) = delete;
+
+    // Mount points of the older and newer revision, used as project roots
+    const std::string& oldRoot() const { return m_oldRoot; }
+    const std::string& newRoot() const { return m_newRoot; }
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem() const { return m_fileSystem; }
+
+    /**
+     * @brief Makes path, below one of the mounts, an empty file of that revision.
+     *
+     * Used for a header that was added or removed between the revisions, so
+     * it is compared against an empty file. Does nothing if the file exists.
+     */
+    void addEmptyFile(const std::string& path);
+
+    // Number of blobs read from the repository so far
+    unsigned blobsRead() const;
+
+private:
+    GitSourceTrees() = default;
+
+    std::string m_oldRoot;
+    std::string m_newRoot;
+    std::shared_ptr<GitBlobReader> m_reader;
+    llvm::IntrusiveRefCntPtr<GitRevisionFileSystem> m_oldTree;
+    llvm::IntrusiveRefCntPtr<GitRevisionFileSystem> m_newTree;
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> m_fileSystem;
+};
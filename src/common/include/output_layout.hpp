@@ -0,0 +1,51 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <string>
+
+/**
+ * @class OutputLayout
+ * @brief Where one armor run writes its reports, AST diff dumps and logs.
+ *
+ * Every path lives under a root directory (--output-dir); an empty root keeps
+ * the historical paths relative to the working directory.
+ */
+class OutputLayout {
+public:
+    explicit OutputLayout(std::string root = "");
+
+    const std::string& root() const { return m_root; }
+
+    // Resolves a path relative to the output root
+    std::string path(const std::string& relative) const;
+
+    std::string diagnosticsLogPath() const;
+    std::string astDiffDir() const;
+    std::string astDiffPath(const std::string& reportName) const;
+    std::string htmlReportPath(const std::string& reportName) const;
+    std::string jsonReportPath(const std::string& reportName) const;
+
+private:
+    std::string m_root;
+};
+
+/**
+ * @brief Returns the name reports for a header are filed under.
+ *
+ * Derived from the header's path relative to its project root, with '%' and
+ * '/' percent-encoded, so headers sharing a basename in different directories
+ * never collide. A header directly under the root keeps its plain basename.
+ */
+std::string reportNameForHeader(const std::string& projectRoot, const std::string& headerPath);
+
+/**
+ * @brief Writes a file through a uniquely named temporary and an atomic rename.
+ *
+ * Readers and concurrent writers of the same output tree never observe a
+ * partially written file. Missing parent directories are created.
+ *
+ * @throws std::runtime_error if the file cannot be written.
+ */
+void writeFileAtomically(const std::string& path, const std::string& contents);
@@ -0,0 +1,62 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "clang/Tooling/CompilationDatabase.h"
+#include "clang/Tooling/Tooling.h"
+
+#include "armor_context.hpp"
+#include "comm_def.hpp"
+
+// Stands for the project root in a macro flag, so that a flag naming a file of
+// the project (e.g. the value of -include) finds it below each root
+inline constexpr const char kProjectRootVariable[] = "${ARMOR_PROJECT_ROOT}";
+
+/**
+ * @brief Builds the clang command line used to parse one header of a project.
+ *
+ * The result holds the built-in CLANG_FLAGS, the user include paths resolved
+ * against projectPath, the macro flags with kProjectRootVariable replaced by
+ * projectPath, and finally a -I for every directory from the header's own
+ * directory up to projectPath. A directory is searched once, where it first
+ * appears; later -I flags for it are dropped.
+ */
+std::vector<std::string> buildClangFlags(const std::string& projectPath,
+                                         const std::string& headerPath,
+                                         const std::vector<std::string>& includePaths,
+                                         const std::vector<std::string>& macroFlags);
+
+/**
+ * @brief Runs a ClangTool over a single file with armor's diagnostics setup.
+ *
+ * Diagnostics go to the context's log sink; the tool uses its own physical
+ * filesystem so concurrent runs do not fight over the process working directory,
+ * with the context's source file system, if any, laid over it, and stat calls
+ * answered from the context's stat cache. The action is usually a
+ * FrontendActionFactory; a plain ToolAction gets the compiler invocation itself.
+ *
+ * @return FATAL_ERRORS if clang reported a fatal failure, NO_FATAL_ERRORS otherwise.
+ */
+PARSING_STATUS runNormalizeTool(ArmorContext& context,
+                                const std::string& fileName,
+                                const clang::tooling::CompilationDatabase& compDB,
+                                clang::tooling::ToolAction& action);
+
+/**
+ * @brief Runs the parses of the older and newer header of a pair concurrently.
+ *
+ * The newer side runs on a second thread with the caller's DebugConfig; its
+ * console output is replayed after the older side's, so the terminal reads as
+ * if they ran one after the other.
+ *
+ * @return The parsing status of the older and the newer side.
+ */
+std::pair<PARSING_STATUS, PARSING_STATUS> parseHeaderPairConcurrently(
+    const std::function<PARSING_STATUS()>& parseOld,
+    const std::function<PARSING_STATUS()>& parseNew);
@@ -0,0 +1,111 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/VirtualFileSystem.h"
+
+/**
+ * @class StatCache
+ * @brief Results of stat calls shared by every Clang parse of one run.
+ *
+ * Each ClangTool gets its own FileManager, which is not thread-safe, so the
+ * run-wide cache sits one level lower: cachedView() wraps a tool's file
+ * system so its status() calls are answered from here once any parse has
+ * asked for the same absolute path. Headers that are found and include path
+ * probes that are not both count, which is what repeats across headers
+ * including the same prelude. Only files that exist and paths that do not
+ * are cached; other errors are retried. Contents are not cached, and the
+ * run's files are assumed not to change while it lasts. Thread-safe.
+ *
+ * Below the listed roots (the project roots) the cache also resolves
+ * includes from directory listings: the first probe into a directory reads
+ * its entries once, and every later probe there for a name it does not hold
+ * fails without a stat, whichever header it comes from. This is what makes an
+ * include that misses in most of a deep search path cheap.
+ */
+class StatCache {
+public:
+    /**
+     * @brief Returns fileSystem with its status() calls going through this cache.
+     *
+     * The view forwards everything else, including the working directory, to
+     * fileSystem, so one view per tool keeps tools from sharing a working directory.
+     */
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> cachedView(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem);
+
+    // The cached result for an absolute path, if any
+    llvm::Optional<llvm::ErrorOr<llvm::vfs::Status>> lookup(llvm::StringRef path);
+    void insert(llvm::StringRef path, const llvm::ErrorOr<llvm::vfs::Status>& result);
+
+    /**
+     * @brief Lets probes below root be answered from directory listings.
+     *
+     * Must only name trees that do not change during the run.
+     */
+    void addListedRoot(llvm::StringRef root);
+
+    /**
+     * @brief Returns true if path is below a listed root and its directory,
+     *        listed through fileSystem if not yet, has no such entry.
+     */
+    bool knownMissing(llvm::vfs::FileSystem& fileSystem, llvm::StringRef path);
+
+    // Probes that failed from a directory listing instead of a stat
+    uint64_t probesSaved() const { return m_probesSaved.load(std::memory_order_relaxed); }
+
+    // Stat and open calls answered from the cache, and those that reached the file system
+    void noteHit() { m_hits.fetch_add(1, std::memory_order_relaxed); }
+    void noteMiss() { m_misses.fetch_add(1, std::memory_order_relaxed); }
+    uint64_t hits() const { return m_hits.load(std::memory_order_relaxed); }
+    uint64_t misses() const { return m_misses.load(std::memory_order_relaxed); }
+
+private:
+    struct Entry {
+        std::error_code error;
+        llvm::vfs::Status status;
+    };
+
+    // Paths are spread over shards so parallel parses rarely wait for each other
+    struct Shard {
+        std::mutex mutex;
+        llvm::StringMap<Entry> entries;
+    };
+    static constexpr size_t kShards = 16;
+
+    // Entries of a directory below a listed root. An incomplete listing (the
+    // directory could not be read) answers nothing.
+    struct Listing {
+        bool complete = false;
+        bool exists = false;
+        llvm::StringSet<> names;
+    };
+
+    Shard& shardFor(llvm::StringRef path);
+    bool belowListedRoot(llvm::StringRef path) const;
+    const Listing& listing(llvm::vfs::FileSystem& fileSystem, llvm::StringRef dir);
+
+    std::array<Shard, kShards> m_shards;
+    mutable std::mutex m_listingMutex;
+    std::vector<std::string> m_listedRoots;
+    // Listings are never removed, so references to them stay valid
+    llvm::StringMap<std::unique_ptr<Listing>> m_listings;
+    std::atomic<uint64_t> m_probesSaved{0};
+    std::atomic<uint64_t> m_hits{0};
+    std::atomic<uint64_t> m_misses{0};
+};
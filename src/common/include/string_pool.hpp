@@ -0,0 +1,76 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+
+/**
+ * @class StringPool
+ * @brief One copy of every distinct string the API trees of a session hold.
+ *
+ * Names, USRs, NSRs and type strings repeat across nodes and across the two
+ * versions of a header, so nodes keep StringRefs into this pool instead of
+ * their own copies. Equal strings interned in the same pool share their
+ * storage, which makes equality a pointer comparison (see sameInterned).
+ * Strings are never removed; they live as long as the pool. A pool can be
+ * layered over a parent whose strings it reuses without adding to it, so
+ * short-lived trees compared against long-lived ones do not grow the
+ * long-lived pool. Thread-safe.
+ */
+class StringPool {
+public:
+    StringPool() = default;
+
+    /**
+     * @brief Constructs a pool layered over parent.
+     *
+     * Strings the parent holds are returned from it and all others are kept
+     * here, so strings of this pool and of its parents compare with sameInterned.
+     */
+    explicit StringPool(std::shared_ptr<const StringPool> parent);
+
+    /**
+     * @brief Returns the pool's copy of str, the same one for equal strings.
+     *
+     * The empty string is always StringRef(), like a field never assigned.
+     */
+    llvm::StringRef intern(llvm::StringRef str);
+
+    // Number of distinct strings held by this pool, not counting its parents'
+    size_t size() const;
+
+    // Whether strings of the two pools compare with sameInterned: one is the other or one of its parents
+    bool sharesStringsWith(const StringPool& other) const;
+
+private:
+    // Strings are spread over shards so both versions of a header intern without waiting for each other
+    struct Shard {
+        mutable std::mutex mutex;
+        llvm::StringSet<> strings;
+    };
+    static constexpr size_t kShards = 16;
+
+    // The copy of str held by this pool or a parent, StringRef() if none
+    llvm::StringRef find(llvm::StringRef str, uint32_t hash) const;
+    bool isOrLayersOver(const StringPool& other) const;
+
+    std::array<Shard, kShards> m_shards;
+    std::shared_ptr<const StringPool> m_parent;
+};
+
+/**
+ * @brief Equality of two strings interned in the same pool, or in pools sharing strings.
+ */
+inline bool sameInterned(llvm::StringRef a, llvm::StringRef b) {
+    assert((a.data() == b.data()) == (a == b) && "strings from different pools compared");
+    return a.data() == b.data();
+}
@@ -3,15 +3,21 @@
 
 #pragma once
 
+#include <cstdint>
 #include <string>
+#include <utility>
+#include <vector>
 
 #include "clang/AST/ASTContext.h"
 #include "clang/AST/Decl.h"
 #include "clang/AST/Type.h"
 #include "clang/AST/TypeLoc.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringRef.h"
 
 #include "custom_usr_generator.hpp"
 #include "comm_def.hpp"
+#include "string_pool.hpp"
 
 APINodeStorageClass getStorageClass(const clang::StorageClass storage);
 
@@ -19,10 +25,75 @@ clang::QualType unwrapType(clang::QualType type);
 
 std::pair<std::string, clang::TypeLoc> unwrapTypeLoc(clang::TypeLoc TL);
 
-const std::string generateUSRForDecl(const clang::NamedDecl * Decl);
+struct DeclIdentifiers {
+    std::string USR;
+    std::string NSR;
+};
 
-const std::string generateNSRForDecl(const clang::NamedDecl * Decl);
+// USR and NSR of a declaration, generated in one traversal. Both are empty for
+// parameters and template parameters.
+DeclIdentifiers generateIdentifiersForDecl(const clang::NamedDecl * Decl);
 
-const std::pair<const std::string,const std::string> getTypesWithAndWithoutTypeResolution(const clang::QualType T, const clang::ASTContext &Ctx);
+/**
+ * @brief Strings and structural hash of one type.
+ *
+ * The strings are interned in a StringPool. canonicalHash is the hash of the
+ * canonical type (see armor::hashCanonicalType), or of its printed form for types
+ * the hash does not walk; two types with the same nonzero hash are the same type.
+ */
+struct TypeStrings {
+    llvm::StringRef asWritten;
+    llvm::StringRef canonical;
+    uint64_t canonicalHash = 0;
+};
 
-const std::string generateHash( llvm::StringRef qualifiedName , const NodeKind& node );
\ No newline at end of file
+/**
+ * @class TypeStringCache
+ * @brief Prints each distinct type of one ASTContext once, as written and canonical.
+ *
+ * Large headers repeat the same parameter, field and return types over and
+ * over. Results are keyed by the QualType itself (its opaque pointer), which
+ * is unique within the ASTContext, and interned in a StringPool. The canonical
+ * string and hash are kept per canonical type, so every typedef and alias of
+ * a type shares one; a type that is already canonical and names no template
+ * specialization prints the same either way and is printed only once.
+ * The cache must not outlive the ASTContext. Not thread-safe; one per parse.
+ */
+class TypeStringCache {
+public:
+    TypeStringCache(const clang::ASTContext &Ctx, StringPool &strings);
+
+    /**
+     * @brief Returns the type as written and after resolving typedefs and aliases.
+     *
+     * A null type gives two empty strings and a zero hash.
+     */
+    TypeStrings getTypesWithAndWithoutTypeResolution(const clang::QualType T);
+
+    // Lookups answered from the cache, and those that printed the type
+    uint64_t hits() const { return m_hits; }
+    uint64_t misses() const { return m_misses; }
+
+private:
+    struct Canonical {
+        llvm::StringRef str;
+        uint64_t hash = 0;
+    };
+
+    const Canonical& getCanonical(const clang::QualType T, llvm::StringRef asWritten);
+
+    clang::PrintingPolicy m_asWritten;
+    clang::PrintingPolicy m_canonical;
+    StringPool &m_strings;
+    llvm::DenseMap<void*, TypeStrings> m_types;
+    llvm::DenseMap<void*, Canonical> m_canonicalTypes;
+    uint64_t m_hits = 0;
+    uint64_t m_misses = 0;
+};
+
+const std::string generateHash( llvm::StringRef qualifiedName , const NodeKind& node );
+
+// Top-level declarations written in the main file, in source order. Declarations
+// loaded from a PCH or preamble are not looked at, so they are never deserialized,
+// unless the main file itself was loaded from an AST file.
+std::vector<clang::Decl*> getMainFileTopLevelDecls(clang::ASTContext &Ctx);
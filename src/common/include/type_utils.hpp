@@ -3,6 +3,8 @@
 
 #pragma once
 
+#include <cstdint>
+
 #include "clang/AST/Type.h"
 
 namespace armor {
@@ -13,4 +15,14 @@ namespace armor {
  */
 clang::QualType unwrapTypeModifiers(clang::QualType OriginalType);
 
+/**
+ * Hashes the structure of a type's canonical form, in the spirit of clang's ODR hash:
+ * builtins, qualifiers, pointers, references, arrays, vectors, function prototypes,
+ * and tags by their scope chain and template arguments. The hash depends on names
+ * only, never on addresses, so it matches between two parses and across runs.
+ * Returns 0 for types it does not walk (dependent, variable length, ...).
+ * Sets UsesTemplates when a class template specialization is reached.
+ */
+uint64_t hashCanonicalType(clang::QualType T, bool &UsesTemplates);
+
 } // namespace armor
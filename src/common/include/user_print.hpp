@@ -3,18 +3,65 @@
 
 #pragma once
 #include <iostream>
+#include <sstream>
+#include <string>
 #include "llvm/Support/raw_ostream.h"
 #include "debug_config.hpp"
 
+// Per-thread console capture. Worker threads that process headers in parallel
+// install one of these so their terminal output can be replayed in the same
+// order a serial run would have produced it.
+struct ConsoleCapture {
+    std::ostringstream out;
+    std::string err;
+    llvm::raw_string_ostream errStream{err};
+
+    // Writes the captured text to the calling thread's output: its own capture
+    // if one is installed, otherwise the terminal.
+    void replay();
+};
+
+inline thread_local ConsoleCapture* tlsConsoleCapture = nullptr;
+
+// Routes USER_PRINT/USER_ERROR on the current thread into a capture for the
+// lifetime of the guard.
+class ScopedConsoleCapture {
+public:
+    explicit ScopedConsoleCapture(ConsoleCapture& capture) : previous(tlsConsoleCapture) {
+        tlsConsoleCapture = &capture;
+    }
+    ~ScopedConsoleCapture() { tlsConsoleCapture = previous; }
+
+    ScopedConsoleCapture(const ScopedConsoleCapture&) = delete;
+    ScopedConsoleCapture& operator=(const ScopedConsoleCapture&) = delete;
+
+private:
+    ConsoleCapture* previous;
+};
+
+inline std::ostream& userOut() {
+    return tlsConsoleCapture ? tlsConsoleCapture->out : std::cout;
+}
+
+inline llvm::raw_ostream& userErr() {
+    return tlsConsoleCapture ? static_cast<llvm::raw_ostream&>(tlsConsoleCapture->errStream) : llvm::errs();
+}
+
+inline void ConsoleCapture::replay() {
+    userOut() << out.str() << std::flush;
+    userErr() << errStream.str();
+    userErr().flush();
+}
+
 // Prints to terminal AND logs to file
 #define USER_PRINT(msg) \
     do { \
-        std::cout << msg << std::endl; \
+        userOut() << msg << std::endl; \
         DebugConfig::instance().log(msg, DebugConfig::Level::INFO); \
     } while(0)
 
 #define USER_ERROR(msg) \
     do { \
-        llvm::errs() << msg << "\n"; \
+        userErr() << msg << "\n"; \
         DebugConfig::instance().log(msg, DebugConfig::Level::ERROR); \
     } while(0)
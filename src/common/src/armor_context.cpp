@@ -0,0 +1,51 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cstdlib>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "armor_context.hpp"
+#include "user_print.hpp"
+
+ArmorContext::ArmorContext(OutputLayout output) : m_output(std::move(output)) {}
+
+ArmorContext::~ArmorContext() {
+    // The sink must not outlive the stream it points to
+    m_debug.setSink(nullptr);
+}
+
+void ArmorContext::openDiagnosticsLog() {
+    std::call_once(m_logOnce, [this] {
+        const char* envLog = std::getenv("CLANG_DIAG_LOG");
+        const std::string logPath = (envLog && *envLog)
+            ? std::string(envLog)
+            : m_output.diagnosticsLogPath();
+
+        llvm::SmallString<256> p(logPath);
+        llvm::StringRef dir = llvm::sys::path::parent_path(p);
+        if (!dir.empty()) {
+            (void)llvm::sys::fs::create_directories(dir);
+        }
+
+        std::error_code ec;
+        auto stream = std::make_unique<llvm::raw_fd_ostream>(
+            logPath, ec, llvm::sys::fs::OF_Text | llvm::sys::fs::OF_Append);
+
+        if (ec) {
+            // Fallback to stderr so nothing is lost
+            m_debug.setSink(&llvm::errs());
+            ScopedDebugConfig scope(m_debug);
+            USER_ERROR(std::string("[WARN] Failed to open diagnostics log '") +
+                       logPath + "': " + ec.message());
+        } else {
+            m_log = std::move(stream);
+            m_debug.setSink(m_log.get());
+        }
+    });
+}
@@ -13,6 +13,7 @@
 #include "clang/Basic/FileManager.h"
 #include "clang/Basic/SourceManager.h"
 #include "clang/Lex/PreprocessingRecord.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/raw_ostream.h"
 #include "clang/Index/USRGeneration.h"
@@ -65,28 +66,111 @@ static StringRef GetExternalSourceContainer(const NamedDecl *D) {
 }
 
 namespace {
+
+/// Which of the two identifiers a part is written to.
+enum Target : unsigned { USR = 1, NSR = 2, Both = USR | NSR };
+
+/// An unbuffered stream appending to the USR and the NSR buffer together, or
+/// to one of them only.
+class IdentifierStream : public llvm::raw_ostream {
+  SmallVectorImpl<char> &USRBuf;
+  SmallVectorImpl<char> &NSRBuf;
+  unsigned Targets = Both;
+
+  void write_impl(const char *Ptr, size_t Size) override {
+    if (Targets & USR)
+      USRBuf.append(Ptr, Ptr + Size);
+    if (Targets & NSR)
+      NSRBuf.append(Ptr, Ptr + Size);
+  }
+
+  uint64_t current_pos() const override {
+    return (Targets & USR) ? USRBuf.size() : NSRBuf.size();
+  }
+
+public:
+  IdentifierStream(SmallVectorImpl<char> &USRBuf, SmallVectorImpl<char> &NSRBuf)
+  : raw_ostream(/*unbuffered=*/true), USRBuf(USRBuf), NSRBuf(NSRBuf) {}
+
+  unsigned targets() const { return Targets; }
+  void setTargets(unsigned T) { Targets = T; }
+
+  /// Positions of the last character written to each buffer.
+  std::pair<size_t, size_t> lastPos() const {
+    return {USRBuf.size() - 1, NSRBuf.size() - 1};
+  }
+
+  void replace(std::pair<size_t, size_t> Pos, char C) {
+    if (Targets & USR)
+      USRBuf[Pos.first] = C;
+    if (Targets & NSR)
+      NSRBuf[Pos.second] = C;
+  }
+};
+
+/// Generates the USR and the NSR of a declaration in one traversal. The NSR
+/// is the USR without what tells overloads and template specializations
+/// apart: template parameters and arguments, and function parameter and
+/// return types. Parts only one of them has are generated inside OnlyFor.
 class USRGenerator : public ConstDeclVisitor<USRGenerator> {
-  SmallVectorImpl<char> &Buf;
-  llvm::raw_svector_ostream Out;
+  IdentifierStream Out;
   bool IgnoreResults;
   ASTContext *Context;
   bool generatedLoc;
+  // Set when a part of only one identifier asked for the results to be ignored
+  bool USRIgnored = false;
+  bool NSRIgnored = false;
 
   llvm::DenseMap<const Type *, unsigned> TypeSubstitutions;
 
+  /// Narrows generation to the given identifiers while in scope; converts to
+  /// false when none of them is being generated. The generation state is
+  /// restored on exit, so a part one identifier has does not change how the
+  /// rest of the other one is generated.
+  class OnlyFor {
+    USRGenerator &G;
+    const unsigned Saved;
+    const bool SavedIgnoreResults;
+    const bool SavedGeneratedLoc;
+
+  public:
+    OnlyFor(USRGenerator &G, unsigned T)
+    : G(G), Saved(G.Out.targets()), SavedIgnoreResults(G.IgnoreResults),
+      SavedGeneratedLoc(G.generatedLoc) {
+      G.Out.setTargets(Saved & T);
+    }
+
+    ~OnlyFor() {
+      const unsigned Narrowed = G.Out.targets();
+      if (Narrowed != Saved) {
+        if (Narrowed & USR)
+          G.USRIgnored |= G.IgnoreResults;
+        if (Narrowed & NSR)
+          G.NSRIgnored |= G.IgnoreResults;
+        G.IgnoreResults = SavedIgnoreResults;
+        G.generatedLoc = SavedGeneratedLoc;
+      }
+      G.Out.setTargets(Saved);
+    }
+
+    explicit operator bool() const { return G.Out.targets() != 0; }
+  };
+
 public:
-  explicit USRGenerator(ASTContext *Ctx, SmallVectorImpl<char> &Buf)
-  : Buf(Buf),
-    Out(Buf),
+  USRGenerator(ASTContext *Ctx, SmallVectorImpl<char> &USRBuf,
+               SmallVectorImpl<char> &NSRBuf)
+  : Out(USRBuf, NSRBuf),
     IgnoreResults(false),
     Context(Ctx),
     generatedLoc(false)
   {
-    // Add the USR space prefix.
+    // Add the USR space prefix, which NSRs share.
     Out << getUSRSpacePrefix();
   }
 
-  bool ignoreResults() const { return IgnoreResults; }
+  bool ignoreResults() const {
+    return IgnoreResults || USRIgnored || NSRIgnored;
+  }
 
   // Visitation methods from generating USRs from AST elements.
   void VisitDeclContext(const DeclContext *D);
@@ -99,11 +183,17 @@ public:
   void VisitClassTemplateDecl(const ClassTemplateDecl *D);
   void VisitTagDecl(const TagDecl *D);
   void VisitTypedefDecl(const TypedefDecl *D);
-  void VisitTemplateTypeParmDecl(const TemplateTypeParmDecl *D);
+  void VisitTemplateTypeParmDecl(const TemplateTypeParmDecl *D) {
+    VisitTemplateParmDecl(D);
+  }
   void VisitVarDecl(const VarDecl *D);
   void VisitBindingDecl(const BindingDecl *D);
-  void VisitNonTypeTemplateParmDecl(const NonTypeTemplateParmDecl *D);
-  void VisitTemplateTemplateParmDecl(const TemplateTemplateParmDecl *D);
+  void VisitNonTypeTemplateParmDecl(const NonTypeTemplateParmDecl *D) {
+    VisitTemplateParmDecl(D);
+  }
+  void VisitTemplateTemplateParmDecl(const TemplateTemplateParmDecl *D) {
+    VisitTemplateParmDecl(D);
+  }
   void VisitUnresolvedUsingValueDecl(const UnresolvedUsingValueDecl *D);
   void VisitUnresolvedUsingTypenameDecl(const UnresolvedUsingTypenameDecl *D);
 
@@ -126,6 +216,9 @@ public:
 
   bool ShouldGenerateLocation(const NamedDecl *D);
 
+  /// Template parameters are located in USRs and named in NSRs.
+  void VisitTemplateParmDecl(const NamedDecl *D);
+
   bool isLocal(const NamedDecl *D) {
     return D->getParentFunctionOrMethod() != nullptr;
   }
@@ -140,7 +233,7 @@ public:
   /// and from other clients that want to directly generate USRs.  These
   /// methods do not construct complete USRs (which incorporate the parents
   /// of an AST element), but only the fragments concerning the AST element
-  /// itself.
+  /// itself. They are USR-only; callers wrap them in OnlyFor(USR).
   void VisitType(QualType T);
   void VisitTemplateParameterList(const TemplateParameterList *Params);
   void VisitTemplateName(TemplateName Name);
@@ -157,9 +250,9 @@ public:
 //===----------------------------------------------------------------------===//
 
 bool USRGenerator::EmitDeclName(const NamedDecl *D) {
-  const unsigned startSize = Buf.size();
+  const uint64_t startSize = Out.tell();
   D->printName(Out);
-  const unsigned endSize = Buf.size();
+  const uint64_t endSize = Out.tell();
   return startSize == endSize;
 }
 
@@ -204,16 +297,21 @@ void USRGenerator::VisitFunctionDecl(const FunctionDecl *D) {
   if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
     return;
 
-  const unsigned StartSize = Buf.size();
+  const uint64_t StartSize = Out.tell();
   VisitDeclContext(D->getDeclContext());
-  if (Buf.size() == StartSize)
+  if (Out.tell() == StartSize)
     GenExtSymbolContainer(D);
 
   bool IsTemplate = false;
   if (FunctionTemplateDecl *FunTmpl = D->getDescribedFunctionTemplate()) {
     IsTemplate = true;
-    Out << "@FT@";
-    VisitTemplateParameterList(FunTmpl->getTemplateParameters());
+    Out << "@F";
+    if (OnlyFor Only{*this, USR}) {
+      Out << "T@";
+      VisitTemplateParameterList(FunTmpl->getTemplateParameters());
+    }
+    if (OnlyFor Only{*this, NSR})
+      Out << '@';
   } else
     Out << "@F@";
 
@@ -228,39 +326,46 @@ void USRGenerator::VisitFunctionDecl(const FunctionDecl *D) {
       !D->hasAttr<OverloadableAttr>())
     return;
 
-  if (const TemplateArgumentList *
-        SpecArgs = D->getTemplateSpecializationArgs()) {
-    Out << '<';
-    for (unsigned I = 0, N = SpecArgs->size(); I != N; ++I) {
-      Out << '#';
-      VisitTemplateArgument(SpecArgs->get(I));
+  // Overloads share one NSR
+  if (OnlyFor Only{*this, USR}) {
+    if (const TemplateArgumentList *
+          SpecArgs = D->getTemplateSpecializationArgs()) {
+      Out << '<';
+      for (unsigned I = 0, N = SpecArgs->size(); I != N; ++I) {
+        Out << '#';
+        VisitTemplateArgument(SpecArgs->get(I));
+      }
+      Out << '>';
     }
-    Out << '>';
-  }
 
-  // Mangle in type information for the arguments.
-  for (auto PD : D->parameters()) {
-    Out << '#';
-    VisitType(PD->getType());
+    // Mangle in type information for the arguments.
+    for (auto PD : D->parameters()) {
+      Out << '#';
+      VisitType(PD->getType());
+    }
   }
   if (D->isVariadic())
     Out << '.';
   if (IsTemplate) {
-    // Function templates can be overloaded by return type, for example:
-    // \code
-    //   template <class T> typename T::A foo() {}
-    //   template <class T> typename T::B foo() {}
-    // \endcode
-    Out << '#';
-    VisitType(D->getReturnType());
+    if (OnlyFor Only{*this, USR}) {
+      // Function templates can be overloaded by return type, for example:
+      // \code
+      //   template <class T> typename T::A foo() {}
+      //   template <class T> typename T::B foo() {}
+      // \endcode
+      Out << '#';
+      VisitType(D->getReturnType());
+    }
   }
   Out << '#';
   if (const CXXMethodDecl *MD = dyn_cast<CXXMethodDecl>(D)) {
-    if (MD->isStatic())
-      Out << 'S';
-    // FIXME: OpenCL: Need to consider address spaces
-    if (unsigned quals = MD->getMethodQualifiers().getCVRUQualifiers())
-      Out << (char)('0' + quals);
+    if (OnlyFor Only{*this, USR}) {
+      if (MD->isStatic())
+        Out << 'S';
+      // FIXME: OpenCL: Need to consider address spaces
+      if (unsigned quals = MD->getMethodQualifiers().getCVRUQualifiers())
+        Out << (char)('0' + quals);
+    }
     switch (MD->getRefQualifier()) {
     case RQ_None: break;
     case RQ_LValue: Out << '&'; break;
@@ -291,13 +396,15 @@ void USRGenerator::VisitVarDecl(const VarDecl *D) {
 
   VisitDeclContext(D->getDeclContext());
 
-  if (VarTemplateDecl *VarTmpl = D->getDescribedVarTemplate()) {
-    Out << "@VT";
-    VisitTemplateParameterList(VarTmpl->getTemplateParameters());
-  } else if (const VarTemplatePartialSpecializationDecl *PartialSpec
-             = dyn_cast<VarTemplatePartialSpecializationDecl>(D)) {
-    Out << "@VP";
-    VisitTemplateParameterList(PartialSpec->getTemplateParameters());
+  if (OnlyFor Only{*this, USR}) {
+    if (VarTemplateDecl *VarTmpl = D->getDescribedVarTemplate()) {
+      Out << "@VT";
+      VisitTemplateParameterList(VarTmpl->getTemplateParameters());
+    } else if (const VarTemplatePartialSpecializationDecl *PartialSpec
+               = dyn_cast<VarTemplatePartialSpecializationDecl>(D)) {
+      Out << "@VP";
+      VisitTemplateParameterList(PartialSpec->getTemplateParameters());
+    }
   }
 
   // Variables always have simple names.
@@ -315,11 +422,13 @@ void USRGenerator::VisitVarDecl(const VarDecl *D) {
   // For a template specialization, mangle the template arguments.
   if (const VarTemplateSpecializationDecl *Spec
                               = dyn_cast<VarTemplateSpecializationDecl>(D)) {
-    const TemplateArgumentList &Args = Spec->getTemplateArgs();
-    Out << '>';
-    for (unsigned I = 0, N = Args.size(); I != N; ++I) {
-      Out << '#';
-      VisitTemplateArgument(Args.get(I));
+    if (OnlyFor Only{*this, USR}) {
+      const TemplateArgumentList &Args = Spec->getTemplateArgs();
+      Out << '>';
+      for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+        Out << '#';
+        VisitTemplateArgument(Args.get(I));
+      }
     }
   }
 }
@@ -330,14 +439,11 @@ void USRGenerator::VisitBindingDecl(const BindingDecl *D) {
   VisitNamedDecl(D);
 }
 
-void USRGenerator::VisitNonTypeTemplateParmDecl(
-                                        const NonTypeTemplateParmDecl *D) {
-  GenLoc(D, /*IncludeOffset=*/true);
-}
-
-void USRGenerator::VisitTemplateTemplateParmDecl(
-                                        const TemplateTemplateParmDecl *D) {
-  GenLoc(D, /*IncludeOffset=*/true);
+void USRGenerator::VisitTemplateParmDecl(const NamedDecl *D) {
+  if (OnlyFor Only{*this, USR})
+    GenLoc(D, /*IncludeOffset=*/true);
+  if (OnlyFor Only{*this, NSR})
+    VisitNamedDecl(D);
 }
 
 void USRGenerator::VisitNamespaceDecl(const NamespaceDecl *D) {
@@ -377,35 +483,41 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
   D = D->getCanonicalDecl();
   VisitDeclContext(D->getDeclContext());
 
+  // The USR tells templates and partial specializations apart; the NSR names
+  // them like any other tag
   bool AlreadyStarted = false;
   if (const CXXRecordDecl *CXXRecord = dyn_cast<CXXRecordDecl>(D)) {
     if (ClassTemplateDecl *ClassTmpl = CXXRecord->getDescribedClassTemplate()) {
       AlreadyStarted = true;
 
-      switch (D->getTagKind()) {
-      case TTK_Interface:
-      case TTK_Class:
-      case TTK_Struct: Out << "@ST"; break;
-      case TTK_Union:  Out << "@UT"; break;
-      case TTK_Enum: llvm_unreachable("enum template");
+      if (OnlyFor Only{*this, USR}) {
+        switch (D->getTagKind()) {
+        case TTK_Interface:
+        case TTK_Class:
+        case TTK_Struct: Out << "@ST"; break;
+        case TTK_Union:  Out << "@UT"; break;
+        case TTK_Enum: llvm_unreachable("enum template");
+        }
+        VisitTemplateParameterList(ClassTmpl->getTemplateParameters());
       }
-      VisitTemplateParameterList(ClassTmpl->getTemplateParameters());
     } else if (const ClassTemplatePartialSpecializationDecl *PartialSpec
                 = dyn_cast<ClassTemplatePartialSpecializationDecl>(CXXRecord)) {
       AlreadyStarted = true;
 
-      switch (D->getTagKind()) {
-      case TTK_Interface:
-      case TTK_Class:
-      case TTK_Struct: Out << "@SP"; break;
-      case TTK_Union:  Out << "@UP"; break;
-      case TTK_Enum: llvm_unreachable("enum partial specialization");
+      if (OnlyFor Only{*this, USR}) {
+        switch (D->getTagKind()) {
+        case TTK_Interface:
+        case TTK_Class:
+        case TTK_Struct: Out << "@SP"; break;
+        case TTK_Union:  Out << "@UP"; break;
+        case TTK_Enum: llvm_unreachable("enum partial specialization");
+        }
+        VisitTemplateParameterList(PartialSpec->getTemplateParameters());
       }
-      VisitTemplateParameterList(PartialSpec->getTemplateParameters());
     }
   }
 
-  if (!AlreadyStarted) {
+  if (OnlyFor Only{*this, AlreadyStarted ? NSR : Both}) {
     switch (D->getTagKind()) {
       case TTK_Interface:
       case TTK_Class:
@@ -416,12 +528,11 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
   }
 
   Out << '@';
-  assert(Buf.size() > 0);
-  const unsigned off = Buf.size() - 1;
+  const std::pair<size_t, size_t> off = Out.lastPos();
 
   if (EmitDeclName(D)) {
     if (const TypedefNameDecl *TD = D->getTypedefNameForAnonDecl()) {
-      Buf[off] = 'A';
+      Out.replace(off, 'A');
       Out << '@' << *TD;
     }
     else {
@@ -443,7 +554,7 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
           else if(const TypedefDecl * TD = dyn_cast_or_null<clang::TypedefDecl>(D->getNextDeclInContext())){
             const QualType QT = unwrapTypeModifiers(TD->getUnderlyingType());
             if(QT->getAsTagDecl()->Equals(D)){
-              Buf[off] = 'A';
+              Out.replace(off, 'A');
               Out << '@';
               TD->printName(Out);
             }
@@ -454,7 +565,7 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
         } 
         else {
           // Completely anonymous tag decl.
-          Buf[off] = 'a';
+          Out.replace(off, 'a');
       }
     }
   }
@@ -462,11 +573,13 @@ void USRGenerator::VisitTagDecl(const TagDecl *D) {
   // For a class template specialization, mangle the template arguments.
   if (const ClassTemplateSpecializationDecl *Spec
                               = dyn_cast<ClassTemplateSpecializationDecl>(D)) {
-    const TemplateArgumentList &Args = Spec->getTemplateArgs();
-    Out << '>';
-    for (unsigned I = 0, N = Args.size(); I != N; ++I) {
-      Out << '#';
-      VisitTemplateArgument(Args.get(I));
+    if (OnlyFor Only{*this, USR}) {
+      const TemplateArgumentList &Args = Spec->getTemplateArgs();
+      Out << '>';
+      for (unsigned I = 0, N = Args.size(); I != N; ++I) {
+        Out << '#';
+        VisitTemplateArgument(Args.get(I));
+      }
     }
   }
 }
@@ -481,10 +594,6 @@ void USRGenerator::VisitTypedefDecl(const TypedefDecl *D) {
   Out << D->getName();
 }
 
-void USRGenerator::VisitTemplateTypeParmDecl(const TemplateTypeParmDecl *D) {
-  GenLoc(D, /*IncludeOffset=*/true);
-}
-
 void USRGenerator::GenExtSymbolContainer(const NamedDecl *D) {
   StringRef Container = GetExternalSourceContainer(D);
   if (!Container.empty())
@@ -492,21 +601,13 @@ void USRGenerator::GenExtSymbolContainer(const NamedDecl *D) {
 }
 
 bool USRGenerator::GenLoc(const Decl *D, bool IncludeOffset) {
-  llvm::outs() << "[DEBUG] GenLoc called for: " 
-               << (D ? D->getDeclKindName() : "null") 
-               << ", IncludeOffset: " << (IncludeOffset ? "true" : "false") 
-               << ", generatedLoc: " << (generatedLoc ? "true" : "false") 
-               << ", IgnoreResults: " << (IgnoreResults ? "true" : "false") << "\n";
-  
   if (generatedLoc) {
-    llvm::outs() << "[DEBUG] GenLoc returning early because generatedLoc is true\n";
     return IgnoreResults;
   }
   generatedLoc = true;
 
   // Guard against null declarations in invalid code.
   if (!D) {
-    llvm::outs() << "[DEBUG] GenLoc received null declaration\n";
     IgnoreResults = true;
     return true;
   }
@@ -514,21 +615,9 @@ bool USRGenerator::GenLoc(const Decl *D, bool IncludeOffset) {
   // Use the location of canonical decl.
   D = D->getCanonicalDecl();
 
-  if (const NamedDecl *ND = dyn_cast<NamedDecl>(D)) {
-    llvm::outs() << "[DEBUG] GenLoc for named decl: " << ND->getNameAsString() << "\n";
-  }
-  
-  llvm::outs() << "[DEBUG] GenLoc calling printLoc with BeginLoc: " 
-               << (D->getBeginLoc().isValid() ? "valid" : "invalid") << "\n";
-  
-  bool PrevIgnoreResults = IgnoreResults;
   IgnoreResults =
       IgnoreResults || printLoc(Out, D->getBeginLoc(),
                                 Context->getSourceManager(), IncludeOffset);
-  
-  llvm::outs() << "[DEBUG] GenLoc after printLoc, IgnoreResults changed from " 
-               << (PrevIgnoreResults ? "true" : "false") 
-               << " to " << (IgnoreResults ? "true" : "false") << "\n";
 
   return IgnoreResults;
 }
@@ -893,6 +982,12 @@ void USRGenerator::VisitUnresolvedUsingValueDecl(const UnresolvedUsingValueDecl
 }
 
 void USRGenerator::VisitUnresolvedUsingTypenameDecl(const UnresolvedUsingTypenameDecl *D) {
+  if (OnlyFor Only{*this, NSR})
+    VisitNamedDecl(D);
+
+  OnlyFor Only{*this, USR};
+  if (!Only)
+    return;
   if (ShouldGenerateLocation(D) && GenLoc(D, /*IncludeOffset=*/isLocal(D)))
     return;
   VisitDeclContext(D->getDeclContext());
@@ -917,15 +1012,15 @@ void generateUSRForEnumConstant(StringRef EnumConstantName,
   OS << '@' << EnumConstantName;
 }
 
-bool generateUSRForDecl(const Decl *D,
-                                      SmallVectorImpl<char> &Buf) {
+bool generateUSRAndNSRForDecl(const Decl *D, SmallVectorImpl<char> &USRBuf,
+                              SmallVectorImpl<char> &NSRBuf) {
   if (!D)
     return true;
   // We don't ignore decls with invalid source locations. Implicit decls, like
   // C++'s operator new function, can have invalid locations but it is fine to
   // create USRs that can identify them.
 
-  USRGenerator UG(&D->getASTContext(), Buf);
+  USRGenerator UG(&D->getASTContext(), USRBuf, NSRBuf);
   UG.Visit(D);
   return UG.ignoreResults();
 }
@@ -966,7 +1061,9 @@ bool generateUSRForType(QualType T, ASTContext &Ctx,
     return true;
   T = T.getCanonicalType();
 
-  USRGenerator UG(&Ctx, Buf);
+  // Types only appear in USRs; the NSR buffer is discarded
+  SmallString<64> Unused;
+  USRGenerator UG(&Ctx, Buf, Unused);
   UG.VisitType(T);
   return UG.ignoreResults();
 }
@@ -0,0 +1,89 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <memory>
+
+#include "llvm/Support/ErrorOr.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/xxhash.h"
+
+#include "file_digest.hpp"
+
+llvm::ErrorOr<std::unique_ptr<llvm::MemoryBuffer>> FileDigestCache::mapFile(const std::string& path) const {
+    // No null terminator needed, which lets large files be mmap'ed rather than copied
+    if (m_fileSystem) {
+        return m_fileSystem->getBufferForFile(path, /*FileSize=*/-1, /*RequiresNullTerminator=*/false);
+    }
+    return llvm::MemoryBuffer::getFile(path, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+}
+
+std::error_code FileDigestCache::fileSize(const std::string& path, uint64_t& size) const {
+    if (m_fileSystem) {
+        llvm::ErrorOr<llvm::vfs::Status> status = m_fileSystem->status(path);
+        if (!status) {
+            return status.getError();
+        }
+        size = status->getSize();
+        return {};
+    }
+    return llvm::sys::fs::file_size(path, size);
+}
+
+FileDigest FileDigestCache::remember(llvm::StringRef path, llvm::StringRef contents) {
+    FileDigest digest{contents.size(), llvm::xxHash64(contents)};
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    m_digests[path] = digest;
+    return digest;
+}
+
+std::optional<FileDigest> FileDigestCache::lookup(llvm::StringRef path) const {
+    std::scoped_lock<std::mutex> lock(m_mutex);
+    auto it = m_digests.find(path);
+    if (it == m_digests.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::optional<FileDigest> FileDigestCache::digest(const std::string& path) {
+    if (std::optional<FileDigest> known = lookup(path)) {
+        return known;
+    }
+    auto buffer = mapFile(path);
+    if (!buffer) {
+        return std::nullopt;
+    }
+    return remember(path, (*buffer)->getBuffer());
+}
+
+bool FileDigestCache::filesDiffer(const std::string& file1, const std::string& file2) {
+    std::optional<FileDigest> known1 = lookup(file1);
+    std::optional<FileDigest> known2 = lookup(file2);
+    if (known1 && known2 && (known1->size != known2->size || known1->hash != known2->hash)) {
+        return true;
+    }
+
+    uint64_t size1 = 0;
+    uint64_t size2 = 0;
+    if (fileSize(file1, size1) || fileSize(file2, size2)) {
+        return true;
+    }
+    if (size1 != size2) {
+        return true;
+    }
+
+    auto buffer1 = mapFile(file1);
+    auto buffer2 = mapFile(file2);
+    if (!buffer1 || !buffer2) {
+        return true;
+    }
+
+    llvm::StringRef contents1 = (*buffer1)->getBuffer();
+    llvm::StringRef contents2 = (*buffer2)->getBuffer();
+    FileDigest digest1 = remember(file1, contents1);
+    FileDigest digest2 = remember(file2, contents2);
+
+    // Equal hashes are confirmed byte by byte while both files are mapped
+    return digest1.hash != digest2.hash || contents1 != contents2;
+}
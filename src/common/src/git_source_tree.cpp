@@ -0,0 +1,502 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/FileUtilities.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/Program.h"
+#include "llvm/Support/xxhash.h"
+
+#include "debug_config.hpp"
+#include "git_source_tree.hpp"
+
+extern char** environ;
+
+namespace {
+
+// Device number of the directories synthesized from tree listings
+constexpr uint64_t kGitDirectoryDevice = 0x61726d6f72676974ULL;
+
+struct BlobEntry {
+    std::string objectId;
+    uint64_t size = 0;
+};
+
+struct ListedChild {
+    std::string name;
+    bool isDirectory;
+};
+
+// Runs `git -C repo args...` to completion and returns what it wrote to stdout.
+bool runGit(const std::string& git, const std::string& repo, const std::vector<std::string>& args,
+            std::string& output, std::string& error) {
+    llvm::SmallString<128> outPath;
+    llvm::SmallString<128> errPath;
+    if (llvm::sys::fs::createTemporaryFile("armor-git", "out", outPath) ||
+        llvm::sys::fs::createTemporaryFile("armor-git", "err", errPath)) {
+        error = "Cannot create a temporary file for git output";
+        return false;
+    }
+    llvm::FileRemover removeOut(outPath);
+    llvm::FileRemover removeErr(errPath);
+
+    std::vector<llvm::StringRef> argv = {git, "-C", repo};
+    argv.insert(argv.end(), args.begin(), args.end());
+    llvm::Optional<llvm::StringRef> redirects[] = {llvm::StringRef(""), llvm::StringRef(outPath),
+                                                   llvm::StringRef(errPath)};
+    std::string execError;
+    int rc = llvm::sys::ExecuteAndWait(git, argv, llvm::None, redirects, 0, 0, &execError);
+    if (rc != 0) {
+        auto stderrText = llvm::MemoryBuffer::getFile(errPath);
+        llvm::StringRef message = stderrText ? (*stderrText)->getBuffer().trim() : llvm::StringRef();
+        error = "git " + args.front() + " failed in " + repo + ": " +
+                (!message.empty() ? message.str() : !execError.empty() ? execError : "exit status " + std::to_string(rc));
+        return false;
+    }
+    auto stdoutText = llvm::MemoryBuffer::getFile(outPath, /*IsText=*/false, /*RequiresNullTerminator=*/false);
+    if (!stdoutText) {
+        error = "Cannot read the output of git " + args.front();
+        return false;
+    }
+    output = (*stdoutText)->getBuffer().str();
+    return true;
+}
+
+// Iterates over a directory listing computed up front.
+class ListedDirIterImpl : public llvm::vfs::detail::DirIterImpl {
+public:
+    explicit ListedDirIterImpl(std::vector<llvm::vfs::directory_entry> entries) : m_entries(std::move(entries)) {
+        if (!m_entries.empty()) {
+            CurrentEntry = m_entries.front();
+        }
+    }
+
+    std::error_code increment() override {
+        ++m_next;
+        CurrentEntry = m_next < m_entries.size() ? m_entries[m_next] : llvm::vfs::directory_entry();
+        return {};
+    }
+
+private:
+    std::vector<llvm::vfs::directory_entry> m_entries;
+    size_t m_next = 0;
+};
+
+}
+
+/**
+ * A `git cat-file --batch` process kept open for the whole run. Objects are
+ * requested by id one at a time under a lock. A forked worker process does not
+ * share its parent's pipe: it starts a process of its own on first use.
+ */
+class GitBlobReader {
+public:
+    GitBlobReader(std::string git, std::string repo) : m_git(std::move(git)), m_repo(std::move(repo)) {}
+    ~GitBlobReader() { stop(); }
+
+    GitBlobReader(const GitBlobReader&) = delete;
+    GitBlobReader& operator=(const GitBlobReader&) = delete;
+
+    bool read(const std::string& objectId, std::string& contents, std::string& error) {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if (m_owner != ::getpid()) {
+            // The process is the parent's; only drop this process's handles on it
+            abandon();
+        }
+        if (!m_requests && !start(error)) {
+            return false;
+        }
+        if (std::fprintf(m_requests, "%s\n", objectId.c_str()) < 0 || std::fflush(m_requests) != 0) {
+            error = "git cat-file stopped accepting requests";
+            stop();
+            return false;
+        }
+
+        // "<id> <type> <size>\n<contents>\n", or "<id> missing\n"
+        std::string header;
+        int c;
+        while ((c = std::fgetc(m_replies)) != EOF && c != '\n') {
+            header.push_back(static_cast<char>(c));
+        }
+        llvm::SmallVector<llvm::StringRef, 3> fields;
+        llvm::StringRef(header).split(fields, ' ');
+        uint64_t size = 0;
+        if (c == EOF || fields.size() != 3 || fields[1] != "blob" || fields[2].getAsInteger(10, size)) {
+            error = "git cat-file cannot read " + objectId + (header.empty() ? std::string() : ": " + header);
+            if (c == EOF) {
+                stop();
+            }
+            return false;
+        }
+        contents.resize(size);
+        if (std::fread(contents.data(), 1, size, m_replies) != size || std::fgetc(m_replies) != '\n') {
+            error = "git cat-file ended in the middle of " + objectId;
+            stop();
+            return false;
+        }
+        ++m_blobsRead;
+        return true;
+    }
+
+    unsigned blobsRead() const {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        return m_blobsRead;
+    }
+
+private:
+    bool start(std::string& error) {
+        int requestPipe[2];
+        int replyPipe[2];
+        if (::pipe2(requestPipe, O_CLOEXEC) != 0) {
+            error = std::string("Cannot start git cat-file: ") + std::strerror(errno);
+            return false;
+        }
+        if (::pipe2(replyPipe, O_CLOEXEC) != 0) {
+            error = std::string("Cannot start git cat-file: ") + std::strerror(errno);
+            ::close(requestPipe[0]);
+            ::close(requestPipe[1]);
+            return false;
+        }
+
+        posix_spawn_file_actions_t actions;
+        posix_spawn_file_actions_init(&actions);
+        posix_spawn_file_actions_adddup2(&actions, requestPipe[0], STDIN_FILENO);
+        posix_spawn_file_actions_adddup2(&actions, replyPipe[1], STDOUT_FILENO);
+        std::vector<char*> argv;
+        std::string args[] = {m_git, "-C", m_repo, "cat-file", "--batch"};
+        for (std::string& arg : args) {
+            argv.push_back(arg.data());
+        }
+        argv.push_back(nullptr);
+        pid_t pid = -1;
+        int rc = ::posix_spawn(&pid, m_git.c_str(), &actions, nullptr, argv.data(), environ);
+        posix_spawn_file_actions_destroy(&actions);
+        ::close(requestPipe[0]);
+        ::close(replyPipe[1]);
+        if (rc != 0) {
+            error = std::string("Cannot start git cat-file: ") + std::strerror(rc);
+            ::close(requestPipe[1]);
+            ::close(replyPipe[0]);
+            return false;
+        }
+
+        m_pid = pid;
+        m_owner = ::getpid();
+        m_requests = ::fdopen(requestPipe[1], "w");
+        m_replies = ::fdopen(replyPipe[0], "r");
+        return true;
+    }
+
+    // Closing the request pipe makes cat-file exit
+    void stop() {
+        if (m_owner != ::getpid()) {
+            abandon();
+            return;
+        }
+        if (m_requests) {
+            std::fclose(m_requests);
+        }
+        if (m_replies) {
+            std::fclose(m_replies);
+        }
+        if (m_pid > 0) {
+            ::waitpid(m_pid, nullptr, 0);
+        }
+        m_requests = nullptr;
+        m_replies = nullptr;
+        m_pid = -1;
+    }
+
+    void abandon() {
+        // Nothing is ever left buffered for writing, so closing cannot send a request
+        if (m_requests) {
+            std::fclose(m_requests);
+        }
+        if (m_replies) {
+            std::fclose(m_replies);
+        }
+        m_requests = nullptr;
+        m_replies = nullptr;
+        m_pid = -1;
+        m_owner = ::getpid();
+    }
+
+    const std::string m_git;
+    const std::string m_repo;
+    mutable std::mutex m_mutex;
+    pid_t m_pid = -1;
+    pid_t m_owner = ::getpid();
+    FILE* m_requests = nullptr;
+    FILE* m_replies = nullptr;
+    unsigned m_blobsRead = 0;
+};
+
+/**
+ * One revision of the repository mounted at a directory. Files and directories
+ * are known from the tree listing; a file's contents are read into the
+ * in-memory file system the first time it is stat'ed or opened, so statuses
+ * (and the unique ids Clang keys files by) never change once handed out.
+ * Only absolute paths are served and the working directory cannot be changed,
+ * so one instance can be shared by concurrent ClangTool runs.
+ */
+class GitRevisionFileSystem : public llvm::vfs::FileSystem {
+public:
+    GitRevisionFileSystem(std::string root, std::shared_ptr<GitBlobReader> reader)
+        : m_root(std::move(root)), m_reader(std::move(reader)),
+          m_blobs(new llvm::vfs::InMemoryFileSystem()) {
+        m_directories[m_root];
+    }
+
+    // Parses `git ls-tree -r -l -z` output. Submodules and symlinks are left out.
+    void addListing(llvm::StringRef listing) {
+        while (!listing.empty()) {
+            llvm::StringRef record;
+            std::tie(record, listing) = listing.split('\0');
+            llvm::StringRef info;
+            llvm::StringRef relativePath;
+            std::tie(info, relativePath) = record.split('\t');
+            llvm::SmallVector<llvm::StringRef, 4> fields;
+            info.split(fields, ' ', -1, /*KeepEmpty=*/false);
+            uint64_t size = 0;
+            if (fields.size() != 4 || fields[1] != "blob" || fields[0] == "120000" ||
+                fields[3].getAsInteger(10, size) || relativePath.empty()) {
+                continue;
+            }
+            addFile(relativePath, {fields[2].str(), size});
+        }
+    }
+
+    void addEmptyFile(llvm::StringRef path) {
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        llvm::StringRef relativePath = path.drop_front(m_root.size() + 1);
+        if (m_files.count(path)) {
+            return;
+        }
+        addFile(relativePath, {});
+        m_blobs->addFile(path, 0, llvm::MemoryBuffer::getMemBuffer("", path));
+        m_read.insert(path);
+    }
+
+    bool owns(llvm::StringRef path) const {
+        return path.startswith(m_root) && path.size() > m_root.size() && path[m_root.size()] == '/';
+    }
+
+    llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override {
+        llvm::SmallString<256> normalized;
+        if (!normalize(path, normalized)) {
+            return std::make_error_code(std::errc::no_such_file_or_directory);
+        }
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if (m_directories.count(normalized)) {
+            return directoryStatus(normalized);
+        }
+        if (std::error_code ec = readBlob(normalized)) {
+            return ec;
+        }
+        return m_blobs->status(normalized);
+    }
+
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override {
+        llvm::SmallString<256> normalized;
+        if (!normalize(path, normalized)) {
+            return std::make_error_code(std::errc::no_such_file_or_directory);
+        }
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        if (m_directories.count(normalized)) {
+            return std::make_error_code(std::errc::is_a_directory);
+        }
+        if (std::error_code ec = readBlob(normalized)) {
+            return ec;
+        }
+        // The file refers to the blob's buffer, which lives as long as the in-memory file system
+        return m_blobs->openFileForRead(normalized);
+    }
+
+    llvm::vfs::directory_iterator dir_begin(const llvm::Twine& dir, std::error_code& ec) override {
+        llvm::SmallString<256> normalized;
+        std::scoped_lock<std::mutex> lock(m_mutex);
+        auto it = normalize(dir, normalized) ? m_directories.find(normalized) : m_directories.end();
+        if (it == m_directories.end()) {
+            ec = std::make_error_code(std::errc::no_such_file_or_directory);
+            return llvm::vfs::directory_iterator();
+        }
+        std::vector<llvm::vfs::directory_entry> entries;
+        for (const ListedChild& child : it->second) {
+            entries.emplace_back((normalized + "/" + child.name).str(),
+                                 child.isDirectory ? llvm::sys::fs::file_type::directory_file
+                                                   : llvm::sys::fs::file_type::regular_file);
+        }
+        ec = {};
+        return llvm::vfs::directory_iterator(std::make_shared<ListedDirIterImpl>(std::move(entries)));
+    }
+
+    std::error_code getRealPath(const llvm::Twine& path, llvm::SmallVectorImpl<char>& output) const override {
+        if (!normalize(path, output)) {
+            return std::make_error_code(std::errc::no_such_file_or_directory);
+        }
+        return {};
+    }
+
+    llvm::ErrorOr<std::string> getCurrentWorkingDirectory() const override { return m_root; }
+
+    // Relative paths are never served, so the working directory does not matter;
+    // accepting any keeps OverlayFileSystem::setCurrentWorkingDirectory working.
+    std::error_code setCurrentWorkingDirectory(const llvm::Twine&) override { return {}; }
+
+private:
+    // Must be called with m_mutex held, or before the file system is shared
+    void addFile(llvm::StringRef relativePath, BlobEntry blob) {
+        std::string path = m_root + "/" + relativePath.str();
+        llvm::StringRef child = relativePath;
+        llvm::StringRef parent = llvm::sys::path::parent_path(relativePath, llvm::sys::path::Style::posix);
+        bool isDirectory = false;
+        while (true) {
+            std::string parentPath = parent.empty() ? m_root : m_root + "/" + parent.str();
+            auto inserted = m_directories.try_emplace(parentPath);
+            inserted.first->second.push_back({llvm::sys::path::filename(child, llvm::sys::path::Style::posix).str(),
+                                              isDirectory});
+            // A directory seen before already has its parents listed
+            if (!inserted.second || parent.empty()) {
+                break;
+            }
+            child = parent;
+            parent = llvm::sys::path::parent_path(parent, llvm::sys::path::Style::posix);
+            isDirectory = true;
+        }
+        m_files[path] = std::move(blob);
+    }
+
+    bool normalize(const llvm::Twine& path, llvm::SmallVectorImpl<char>& normalized) const {
+        path.toVector(normalized);
+        if (!llvm::sys::path::is_absolute(normalized, llvm::sys::path::Style::posix)) {
+            return false;
+        }
+        llvm::sys::path::remove_dots(normalized, /*remove_dot_dot=*/true, llvm::sys::path::Style::posix);
+        llvm::StringRef p(normalized.data(), normalized.size());
+        return p == m_root || owns(p);
+    }
+
+    llvm::vfs::Status directoryStatus(llvm::StringRef path) const {
+        return llvm::vfs::Status(path, llvm::sys::fs::UniqueID(kGitDirectoryDevice, llvm::xxHash64(path)),
+                                 llvm::sys::TimePoint<>(), 0, 0, 0, llvm::sys::fs::file_type::directory_file,
+                                 llvm::sys::fs::perms::all_read | llvm::sys::fs::perms::all_exe);
+    }
+
+    // Must be called with m_mutex held
+    std::error_code readBlob(llvm::StringRef path) {
+        if (m_read.count(path)) {
+            return {};
+        }
+        auto it = m_files.find(path);
+        if (it == m_files.end()) {
+            return std::make_error_code(std::errc::no_such_file_or_directory);
+        }
+        std::string contents;
+        std::string error;
+        if (!m_reader->read(it->second.objectId, contents, error)) {
+            DebugConfig::instance().log(error, DebugConfig::Level::ERROR);
+            return std::make_error_code(std::errc::io_error);
+        }
+        m_blobs->addFile(path, 0, llvm::MemoryBuffer::getMemBufferCopy(contents, path));
+        m_read.insert(path);
+        return {};
+    }
+
+    const std::string m_root;
+    std::shared_ptr<GitBlobReader> m_reader;
+    std::mutex m_mutex;
+    llvm::StringMap<BlobEntry> m_files;
+    llvm::StringMap<std::vector<ListedChild>> m_directories;
+    llvm::StringSet<> m_read;
+    llvm::IntrusiveRefCntPtr<llvm::vfs::InMemoryFileSystem> m_blobs;
+};
+
+std::unique_ptr<GitSourceTrees> GitSourceTrees::open(const std::string& repoPath,
+                                                     const std::string& oldRev,
+                                                     const std::string& newRev,
+                                                     std::string& error) {
+    llvm::ErrorOr<std::string> git = llvm::sys::findProgramByName("git");
+    if (!git) {
+        error = "git was not found in PATH";
+        return nullptr;
+    }
+    llvm::SmallString<256> repo(repoPath);
+    if (std::error_code ec = llvm::sys::fs::make_absolute(repo)) {
+        error = "Cannot resolve repository path " + repoPath + ": " + ec.message();
+        return nullptr;
+    }
+
+    auto reader = std::make_shared<GitBlobReader>(*git, repo.str().str());
+    std::unique_ptr<GitSourceTrees> trees(new GitSourceTrees());
+    trees->m_reader = reader;
+    auto mount = [&](const std::string& rev, std::string& root,
+                     llvm::IntrusiveRefCntPtr<GitRevisionFileSystem>& tree) {
+        std::string commit;
+        if (!runGit(*git, repo.str().str(), {"rev-parse", "--verify", "--quiet", rev + "^{commit}"}, commit, error)) {
+            error = "Unknown revision '" + rev + "' in " + repo.str().str();
+            return false;
+        }
+        commit = llvm::StringRef(commit).trim().str();
+        std::string listing;
+        if (!runGit(*git, repo.str().str(), {"ls-tree", "-r", "-l", "-z", commit}, listing, error)) {
+            return false;
+        }
+
+        llvm::SmallString<256> mountPoint;
+        llvm::sys::path::system_temp_directory(/*ErasedOnReboot=*/true, mountPoint);
+        llvm::sys::path::append(mountPoint, "armor-git", commit);
+        if (std::error_code ec = llvm::sys::fs::create_directories(mountPoint)) {
+            error = "Cannot create mount point " + mountPoint.str().str() + ": " + ec.message();
+            return false;
+        }
+        root = mountPoint.str().str();
+        tree = new GitRevisionFileSystem(root, reader);
+        tree->addListing(listing);
+        return true;
+    };
+    if (!mount(oldRev, trees->m_oldRoot, trees->m_oldTree) || !mount(newRev, trees->m_newRoot, trees->m_newTree)) {
+        return nullptr;
+    }
+
+    llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> overlay(
+        new llvm::vfs::OverlayFileSystem(trees->m_oldTree));
+    overlay->pushOverlay(trees->m_newTree);
+    trees->m_fileSystem = overlay;
+    return trees;
+}
+
+GitSourceTrees::~GitSourceTrees() = default;
+
+void GitSourceTrees::addEmptyFile(const std::string& path) {
+    for (GitRevisionFileSystem* tree : {m_oldTree.get(), m_newTree.get()}) {
+        if (tree->owns(path)) {
+            tree->addEmptyFile(path);
+            return;
+        }
+    }
+}
+
+unsigned GitSourceTrees::blobsRead() const {
+    return m_reader ? m_reader->blobsRead() : 0;
+}
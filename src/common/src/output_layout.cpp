@@ -0,0 +1,94 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <utility>
+
+#include "llvm/ADT/SmallString.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "output_layout.hpp"
+
+namespace fs = std::filesystem;
+
+OutputLayout::OutputLayout(std::string root) : m_root(std::move(root)) {}
+
+std::string OutputLayout::path(const std::string& relative) const {
+    return m_root.empty() ? relative : m_root + "/" + relative;
+}
+
+std::string OutputLayout::diagnosticsLogPath() const {
+    return path("debug_output/logs/diagnostics.log");
+}
+
+std::string OutputLayout::astDiffDir() const {
+    return path("debug_output/ast_diffs");
+}
+
+std::string OutputLayout::astDiffPath(const std::string& reportName) const {
+    return astDiffDir() + "/ast_diff_output_" + reportName + ".json";
+}
+
+std::string OutputLayout::htmlReportPath(const std::string& reportName) const {
+    return path("armor_reports/html_reports/api_diff_report_" + reportName + ".html");
+}
+
+std::string OutputLayout::jsonReportPath(const std::string& reportName) const {
+    return path("armor_reports/json_reports/api_diff_report_" + reportName + ".json");
+}
+
+std::string reportNameForHeader(const std::string& projectRoot, const std::string& headerPath) {
+    fs::path relative = fs::path(headerPath).lexically_normal().lexically_relative(fs::path(projectRoot).lexically_normal());
+    // Headers outside the root (or an empty root) are named by their full path
+    if (relative.empty() || *relative.begin() == "..") {
+        relative = fs::path(headerPath).lexically_normal().relative_path();
+    }
+
+    std::string name;
+    for (char c : relative.generic_string()) {
+        switch (c) {
+            case '%': name += "%25"; break;
+            case '/': name += "%2F"; break;
+            default:  name += c;     break;
+        }
+    }
+    return name;
+}
+
+void writeFileAtomically(const std::string& path, const std::string& contents) {
+    llvm::SmallString<256> dir(path);
+    llvm::sys::path::remove_filename(dir);
+    if (!dir.empty()) {
+        if (std::error_code ec = llvm::sys::fs::create_directories(dir)) {
+            throw std::runtime_error("Failed to create directory " + std::string(dir) + ": " + ec.message());
+        }
+    }
+
+    int fd = -1;
+    llvm::SmallString<256> tempPath;
+    if (std::error_code ec = llvm::sys::fs::createUniqueFile(path + ".%%%%%%%%.tmp", fd, tempPath)) {
+        throw std::runtime_error("Failed to create temporary file for " + path + ": " + ec.message());
+    }
+
+    {
+        llvm::raw_fd_ostream out(fd, /*shouldClose=*/true);
+        out << contents;
+        out.close();
+        if (out.has_error()) {
+            std::error_code ec = out.error();
+            out.clear_error();
+            llvm::sys::fs::remove(tempPath);
+            throw std::runtime_error("Failed to write " + path + ": " + ec.message());
+        }
+    }
+
+    if (std::error_code ec = llvm::sys::fs::rename(tempPath, path)) {
+        llvm::sys::fs::remove(tempPath);
+        throw std::runtime_error("Failed to move " + std::string(tempPath) + " to " + path + ": " + ec.message());
+    }
+}
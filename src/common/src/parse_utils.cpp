@@ -0,0 +1,240 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "clang/Basic/DiagnosticOptions.h"
+#include "clang/Frontend/TextDiagnosticPrinter.h"
+#include "clang/Tooling/ArgumentsAdjusters.h"
+#include "clang/Tooling/Tooling.h"
+#include "llvm/ADT/IntrusiveRefCntPtr.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/StringSet.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/raw_ostream.h"
+
+#include "armor_context.hpp"
+#include "debug_config.hpp"
+#include "parse_utils.hpp"
+#include "user_print.hpp"
+
+#ifndef CLANG_FLAGS
+#define CLANG_FLAGS ""
+#endif
+
+namespace {
+
+    std::vector<std::string> getClangFlags(const std::vector<std::string>& includePaths,
+                                           const std::vector<std::string>& macroFlags) {
+        std::vector<std::string> flags;
+
+        std::istringstream iss(CLANG_FLAGS);
+        std::string flag;
+        while (iss >> flag) {
+            flags.emplace_back(std::move(flag));
+        }
+
+        // Add runtime include paths
+        for (const auto& path : includePaths) {
+            flags.emplace_back("-I" + path);
+        }
+
+        // Add full macro flags directly
+        for (const auto& macro : macroFlags) {
+            flags.emplace_back(macro);
+        }
+
+        return flags;
+    }
+
+    std::vector<std::string> resolveProjectRootVariable(const std::vector<std::string>& macroFlags,
+                                                        const std::string& projectPath) {
+        const llvm::StringRef variable(kProjectRootVariable);
+        std::vector<std::string> resolved;
+        resolved.reserve(macroFlags.size());
+        for (const auto& flag : macroFlags) {
+            std::string value = flag;
+            for (size_t at = value.find(variable.data()); at != std::string::npos;
+                 at = value.find(variable.data(), at + projectPath.size())) {
+                value.replace(at, variable.size(), projectPath);
+            }
+            resolved.push_back(std::move(value));
+        }
+        return resolved;
+    }
+
+
+    std::vector<std::string> resolveInternalIncludePaths(const std::vector<std::string>& internalPaths,
+                                                         const std::string& workspacePath) {
+
+        std::vector<std::string> resolvedPaths;
+        for (const auto& path : internalPaths) {
+            resolvedPaths.push_back(workspacePath + "/" + path);
+        }
+        return resolvedPaths;
+    }
+
+    std::vector<std::string> generateIncludePaths(const std::string& projectPath, const std::string& headerPath) {
+        std::vector<std::string> includePaths;
+
+        // Ensure the header path starts with the project path
+        if (headerPath.find(projectPath) != 0) {
+            USER_ERROR("Warning: Header file " + headerPath + " is not within project path " + projectPath );
+            return includePaths;
+        }
+
+        // Get the directory of the header file
+        llvm::SmallString<256> headerDir(headerPath);
+        llvm::sys::path::remove_filename(headerDir);
+
+        // Start with the directory containing the header file
+        llvm::SmallString<256> currentPath = headerDir;
+
+        // Add all parent directories up to and including the project path
+        while (llvm::StringRef(currentPath).str().length() >= projectPath.length()) {
+            includePaths.push_back("-I" + llvm::StringRef(currentPath).str());
+
+            // Move up one directory
+            llvm::sys::path::remove_filename(currentPath);
+
+            // If we've reached the root directory, break
+            if (currentPath.empty()) {
+                break;
+            }
+        }
+
+        // Make sure the project path itself is included
+        if (std::find(includePaths.begin(), includePaths.end(), "-I" + projectPath) == includePaths.end()) {
+            includePaths.push_back("-I" + projectPath);
+        }
+
+        return includePaths;
+    }
+
+    // Spells "-I<dir>" the same however the directory was written
+    std::string normalizedIncludeFlag(llvm::StringRef flag) {
+        llvm::SmallString<256> dir(flag.drop_front(2));
+        // ".." is left alone: it means something else below a symlink
+        llvm::sys::path::remove_dots(dir, /*remove_dot_dot=*/false);
+        while (dir.size() > 1 && llvm::sys::path::is_separator(dir.back())) {
+            dir.pop_back();
+        }
+        return "-I" + dir.str().str();
+    }
+
+    // Drops every -I naming a directory already searched. Clang searches the
+    // first occurrence and would skip the others anyway, so this only saves
+    // the probes of an include that misses and keeps the logged flags short.
+    std::vector<std::string> dedupeIncludePaths(const std::vector<std::string>& flags) {
+        std::vector<std::string> result;
+        result.reserve(flags.size());
+        llvm::StringSet<> seen;
+        for (const auto& flag : flags) {
+            if (!llvm::StringRef(flag).startswith("-I") || flag.size() == 2) {
+                result.push_back(flag);
+                continue;
+            }
+            std::string normalized = normalizedIncludeFlag(flag);
+            if (seen.insert(normalized).second) {
+                result.push_back(std::move(normalized));
+            } else {
+                DebugConfig::instance().log("Dropped duplicate include path " + flag, DebugConfig::Level::DEBUG);
+            }
+        }
+        return result;
+    }
+}
+
+std::vector<std::string> buildClangFlags(const std::string& projectPath,
+                                         const std::string& headerPath,
+                                         const std::vector<std::string>& includePaths,
+                                         const std::vector<std::string>& macroFlags) {
+    std::vector<std::string> flags = getClangFlags(resolveInternalIncludePaths(includePaths, projectPath),
+                                                   resolveProjectRootVariable(macroFlags, projectPath));
+    std::vector<std::string> headerPaths = generateIncludePaths(projectPath, headerPath);
+    flags.insert(flags.end(), headerPaths.begin(), headerPaths.end());
+    return dedupeIncludePaths(flags);
+}
+
+PARSING_STATUS runNormalizeTool(ArmorContext& context,
+                                const std::string& fileName,
+                                const clang::tooling::CompilationDatabase& compDB,
+                                clang::tooling::ToolAction& action) {
+    // Diagnostic options (per run: DiagnosticOptions is not thread-safe refcounted)
+    llvm::IntrusiveRefCntPtr<clang::DiagnosticOptions> diagOpts(new clang::DiagnosticOptions());
+    diagOpts->ShowColors = 0; // cleaner logs
+
+    // Give the tool its own physical filesystem so changing into the compile
+    // directory does not move the process-wide working directory under other
+    // threads. Sources not on disk (e.g. git revisions) are laid over it.
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem = llvm::vfs::createPhysicalFileSystem();
+    if (llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> sources = context.sourceFileSystem()) {
+        llvm::IntrusiveRefCntPtr<llvm::vfs::OverlayFileSystem> overlay(
+            new llvm::vfs::OverlayFileSystem(fileSystem));
+        overlay->pushOverlay(sources);
+        fileSystem = overlay;
+    }
+    // Stats and failed include probes seen by any earlier parse of the run are not repeated
+    clang::tooling::ClangTool tool(compDB, {fileName},
+                                   std::make_shared<clang::PCHContainerOperations>(),
+                                   context.statCache().cachedView(fileSystem));
+
+    // Diagnostics are buffered per run and handed to the context's sink in one
+    // locked write, so parallel parses never interleave inside the stream.
+    std::string diagBuffer;
+    llvm::raw_string_ostream diagStream(diagBuffer);
+    std::unique_ptr<clang::DiagnosticConsumer> diagPrinter =
+        std::make_unique<clang::TextDiagnosticPrinter>(diagStream, &*diagOpts);
+
+    // The tool does not take ownership of the consumer
+    tool.setDiagnosticConsumer(diagPrinter.get());
+
+    // Make logged diagnostics clean and informative
+    tool.appendArgumentsAdjuster(
+        clang::tooling::getInsertArgumentAdjuster("-fno-color-diagnostics"));
+    tool.appendArgumentsAdjuster(
+        clang::tooling::getInsertArgumentAdjuster("-fno-caret-diagnostics"));
+    tool.appendArgumentsAdjuster(
+        clang::tooling::getInsertArgumentAdjuster("-fdiagnostics-show-note-include-stack"));
+    tool.appendArgumentsAdjuster(
+        clang::tooling::getInsertArgumentAdjuster("-fdiagnostics-absolute-paths"));
+
+    //suppress ClangTool'son stderr
+    tool.setPrintErrorMessage(false);
+    int rc = tool.run(&action);
+    context.debug().write(diagStream.str());
+    if (rc != 0) {
+        context.debug().log(
+            std::string("Error while processing ") + fileName + ".",
+            DebugConfig::Level::ERROR
+        );
+        return rc == 1 ? FATAL_ERRORS : NO_FATAL_ERRORS;
+    }
+
+    return NO_FATAL_ERRORS;
+}
+
+std::pair<PARSING_STATUS, PARSING_STATUS> parseHeaderPairConcurrently(
+    const std::function<PARSING_STATUS()>& parseOld,
+    const std::function<PARSING_STATUS()>& parseNew) {
+    ConsoleCapture newOutput;
+    DebugConfig& debug = DebugConfig::instance();
+    std::future<PARSING_STATUS> newParse = std::async(std::launch::async,
+        [&parseNew, &newOutput, &debug]() {
+            ScopedConsoleCapture capture(newOutput);
+            ScopedDebugConfig debugScope(debug);
+            return parseNew();
+        });
+
+    PARSING_STATUS oldStatus = parseOld();
+    PARSING_STATUS newStatus = newParse.get();
+    newOutput.replay();
+    return {oldStatus, newStatus};
+}
@@ -41,12 +41,8 @@ void report_generator(const std::string& diff_json_path,
 
     if (generate_json) {
         try {
-            std::string header_name = std::filesystem::path(header_file_path).filename().string();
-            std::string json_report_dir = "armor_reports/json_reports";
-            std::filesystem::create_directories(json_report_dir);
-            std::string json_output_path = json_report_dir + "/api_diff_report_" + header_name + ".json";
-            generate_json_report(processed, json_output_path);
-            USER_PRINT(std::string("JSON report generated at: ") + json_output_path);
+            generate_json_report(processed, output_json_path);
+            USER_PRINT(std::string("JSON report generated at: ") + output_json_path);
         } catch (const std::exception& e) {
             USER_ERROR(std::string("Failed to generate JSON report: ") + e.what());
         }
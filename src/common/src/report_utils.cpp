@@ -15,6 +15,7 @@
 #include "comm_def.hpp"
 #include "report_utils.hpp"
 #include "html_template.hpp"
+#include "output_layout.hpp"
 #include <nlohmann/json.hpp>
 
 using json = nlohmann::json;
@@ -1134,7 +1135,7 @@ void generate_html_report(const std::vector<json>& processed_data,
                           const std::string& output_html_path,
                           PARSER parser
                         ) {
-    std::ofstream html(output_html_path);
+    std::ostringstream html;
 
     if (processed_data.empty()) {
         html << "<h2 style=\"margin-bottom: 10px;\">ARMOR Report</h2>\n";
@@ -1172,15 +1173,13 @@ void generate_html_report(const std::vector<json>& processed_data,
     }
 
     html << HTML_FOOTER;
-    html.close();
+    writeFileAtomically(output_html_path, html.str());
 }
 
 void generate_json_report(const std::vector<json>& processed_data,
                           const std::string& output_json_path)
 {
     if (output_json_path.empty()) return;
-    std::ofstream jf(output_json_path);
     auto grouped = group_records_by_function(processed_data);
-    jf << json(grouped).dump(4);
-    jf.close();
+    writeFileAtomically(output_json_path, json(grouped).dump(4));
 }
@@ -0,0 +1,178 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <algorithm>
+#include <memory>
+#include <utility>
+
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/FileSystem.h"
+#include "llvm/Support/Path.h"
+
+#include "stat_cache.hpp"
+
+namespace {
+
+// Answers status() from a StatCache and passes everything else through.
+class CachedStatFileSystem : public llvm::vfs::ProxyFileSystem {
+public:
+    CachedStatFileSystem(llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem, StatCache& cache)
+        : ProxyFileSystem(std::move(fileSystem)), m_cache(cache) {}
+
+    llvm::ErrorOr<llvm::vfs::Status> status(const llvm::Twine& path) override {
+        llvm::SmallString<256> storage;
+        llvm::StringRef p = path.toStringRef(storage);
+        // A relative path means something else after the next change of directory
+        if (!llvm::sys::path::is_absolute(p)) {
+            return ProxyFileSystem::status(path);
+        }
+        if (m_cache.knownMissing(getUnderlyingFS(), p)) {
+            return std::make_error_code(std::errc::no_such_file_or_directory);
+        }
+        if (llvm::Optional<llvm::ErrorOr<llvm::vfs::Status>> cached = m_cache.lookup(p)) {
+            m_cache.noteHit();
+            return std::move(*cached);
+        }
+        m_cache.noteMiss();
+        llvm::ErrorOr<llvm::vfs::Status> result = ProxyFileSystem::status(p);
+        m_cache.insert(p, result);
+        return result;
+    }
+
+    // Clang opens rather than stats candidates in user include directories, so
+    // paths known not to exist are answered here too
+    llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> openFileForRead(const llvm::Twine& path) override {
+        llvm::SmallString<256> storage;
+        llvm::StringRef p = path.toStringRef(storage);
+        if (!llvm::sys::path::is_absolute(p)) {
+            return ProxyFileSystem::openFileForRead(path);
+        }
+        if (m_cache.knownMissing(getUnderlyingFS(), p)) {
+            return std::make_error_code(std::errc::no_such_file_or_directory);
+        }
+        llvm::Optional<llvm::ErrorOr<llvm::vfs::Status>> cached = m_cache.lookup(p);
+        if (cached && !*cached) {
+            m_cache.noteHit();
+            return cached->getError();
+        }
+        llvm::ErrorOr<std::unique_ptr<llvm::vfs::File>> file = ProxyFileSystem::openFileForRead(p);
+        if (!file) {
+            m_cache.noteMiss();
+            m_cache.insert(p, file.getError());
+        }
+        return file;
+    }
+
+private:
+    StatCache& m_cache;
+};
+
+}
+
+llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> StatCache::cachedView(
+    llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem> fileSystem) {
+    return llvm::IntrusiveRefCntPtr<llvm::vfs::FileSystem>(new CachedStatFileSystem(std::move(fileSystem), *this));
+}
+
+StatCache::Shard& StatCache::shardFor(llvm::StringRef path) {
+    return m_shards[llvm::djbHash(path) % kShards];
+}
+
+llvm::Optional<llvm::ErrorOr<llvm::vfs::Status>> StatCache::lookup(llvm::StringRef path) {
+    Shard& shard = shardFor(path);
+    std::scoped_lock<std::mutex> lock(shard.mutex);
+    auto it = shard.entries.find(path);
+    if (it == shard.entries.end()) {
+        return llvm::None;
+    }
+    if (it->second.error) {
+        return llvm::ErrorOr<llvm::vfs::Status>(it->second.error);
+    }
+    return llvm::ErrorOr<llvm::vfs::Status>(llvm::vfs::Status::copyWithNewName(it->second.status, path));
+}
+
+void StatCache::insert(llvm::StringRef path, const llvm::ErrorOr<llvm::vfs::Status>& result) {
+    Entry entry;
+    if (result) {
+        entry.status = *result;
+    } else if (result.getError() == llvm::errc::no_such_file_or_directory ||
+               result.getError() == llvm::errc::not_a_directory) {
+        entry.error = result.getError();
+    } else {
+        return;
+    }
+    Shard& shard = shardFor(path);
+    std::scoped_lock<std::mutex> lock(shard.mutex);
+    shard.entries.try_emplace(path, std::move(entry));
+}
+
+void StatCache::addListedRoot(llvm::StringRef root) {
+    llvm::SmallString<256> absolute(root);
+    if (llvm::sys::fs::make_absolute(absolute)) {
+        return;
+    }
+    llvm::sys::path::remove_dots(absolute, /*remove_dot_dot=*/false);
+    while (absolute.size() > 1 && llvm::sys::path::is_separator(absolute.back())) {
+        absolute.pop_back();
+    }
+    std::scoped_lock<std::mutex> lock(m_listingMutex);
+    if (std::find(m_listedRoots.begin(), m_listedRoots.end(), absolute.str()) == m_listedRoots.end()) {
+        m_listedRoots.push_back(absolute.str().str());
+    }
+}
+
+bool StatCache::belowListedRoot(llvm::StringRef path) const {
+    // "." and ".." make the parent directory ambiguous; such paths take the slow way
+    for (auto it = llvm::sys::path::begin(path), end = llvm::sys::path::end(path); it != end; ++it) {
+        if (*it == "." || *it == "..") {
+            return false;
+        }
+    }
+    std::scoped_lock<std::mutex> lock(m_listingMutex);
+    return std::any_of(m_listedRoots.begin(), m_listedRoots.end(), [&](const std::string& root) {
+        return path.size() > root.size() + 1 && path.startswith(root) && path[root.size()] == '/';
+    });
+}
+
+const StatCache::Listing& StatCache::listing(llvm::vfs::FileSystem& fileSystem, llvm::StringRef dir) {
+    {
+        std::scoped_lock<std::mutex> lock(m_listingMutex);
+        auto it = m_listings.find(dir);
+        if (it != m_listings.end()) {
+            return *it->second;
+        }
+    }
+    // Listed without the lock; a directory listed twice by racing parses keeps the first listing
+    auto listing = std::make_unique<Listing>();
+    std::error_code ec;
+    llvm::vfs::directory_iterator it = fileSystem.dir_begin(dir, ec);
+    if (ec) {
+        // Nothing exists below a directory that does not; other errors tell nothing
+        listing->complete = ec == std::errc::no_such_file_or_directory || ec == std::errc::not_a_directory;
+    } else {
+        listing->exists = true;
+        for (llvm::vfs::directory_iterator end; it != end; it.increment(ec)) {
+            if (ec) {
+                break;
+            }
+            listing->names.insert(llvm::sys::path::filename(it->path()));
+        }
+        listing->complete = !ec;
+    }
+    std::scoped_lock<std::mutex> lock(m_listingMutex);
+    return *m_listings.try_emplace(dir, std::move(listing)).first->second;
+}
+
+bool StatCache::knownMissing(llvm::vfs::FileSystem& fileSystem, llvm::StringRef path) {
+    if (!belowListedRoot(path)) {
+        return false;
+    }
+    const Listing& entries = listing(fileSystem, llvm::sys::path::parent_path(path));
+    bool missing = entries.complete &&
+                   (!entries.exists || !entries.names.count(llvm::sys::path::filename(path)));
+    if (missing) {
+        m_probesSaved.fetch_add(1, std::memory_order_relaxed);
+    }
+    return missing;
+}
@@ -0,0 +1,58 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "llvm/Support/DJB.h"
+
+#include "string_pool.hpp"
+
+StringPool::StringPool(std::shared_ptr<const StringPool> parent) : m_parent(std::move(parent)) {}
+
+llvm::StringRef StringPool::find(llvm::StringRef str, uint32_t hash) const {
+    const Shard& shard = m_shards[hash % kShards];
+    {
+        std::scoped_lock<std::mutex> lock(shard.mutex);
+        auto it = shard.strings.find(str);
+        if (it != shard.strings.end()) {
+            return it->getKey();
+        }
+    }
+    return m_parent ? m_parent->find(str, hash) : llvm::StringRef();
+}
+
+llvm::StringRef StringPool::intern(llvm::StringRef str) {
+    if (str.empty()) {
+        return llvm::StringRef();
+    }
+    const uint32_t hash = llvm::djbHash(str);
+    // This pool is looked at before the parents, so a string it already holds
+    // keeps its copy even if a parent picks up the same string later
+    if (llvm::StringRef found = find(str, hash); found.data()) {
+        return found;
+    }
+    Shard& shard = m_shards[hash % kShards];
+    std::scoped_lock<std::mutex> lock(shard.mutex);
+    // StringSet entries never move, so the key stays valid as the set grows
+    return shard.strings.insert(str).first->getKey();
+}
+
+size_t StringPool::size() const {
+    size_t total = 0;
+    for (const Shard& shard : m_shards) {
+        std::scoped_lock<std::mutex> lock(shard.mutex);
+        total += shard.strings.size();
+    }
+    return total;
+}
+
+bool StringPool::isOrLayersOver(const StringPool& other) const {
+    for (const StringPool* pool = this; pool; pool = pool->m_parent.get()) {
+        if (pool == &other) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool StringPool::sharesStringsWith(const StringPool& other) const {
+    return isOrLayersOver(other) || other.isOrLayersOver(*this);
+}
@@ -3,7 +3,6 @@
 
 #include "tree_builder_utils.hpp"
 #include "custom_usr_generator.hpp"
-#include "nsr_generator.hpp"
 
 #include "clang/AST/Decl.h"
 #include "clang/Lex/Lexer.h"
@@ -11,7 +10,10 @@
 #include <llvm-14/llvm/ADT/SmallString.h>
 #include <llvm-14/llvm/Support/raw_ostream.h>
 #include <string>
+#include <vector>
 #include "diff_utils.hpp"
+#include "type_utils.hpp"
+#include "llvm/Support/xxhash.h"
 
 clang::QualType unwrapType(clang::QualType type) {
     if (type.isNull()) return type;
@@ -121,79 +123,98 @@ APINodeStorageClass getStorageClass(const clang::StorageClass storage) {
     }
 };
 
-const std::string generateUSRForDecl(const clang::NamedDecl * Decl){
+DeclIdentifiers generateIdentifiersForDecl(const clang::NamedDecl * Decl){
     
     if (llvm::isa<clang::ParmVarDecl>(Decl)|| llvm::isa<clang::TemplateTypeParmDecl>(Decl) 
     || llvm::isa<clang::NonTypeTemplateParmDecl>(Decl) || llvm::isa<clang::TemplateTemplateParmDecl>(Decl)) {
-        DebugConfig::instance().log("No USR for Param type declerations", DebugConfig::Level::INFO);
-        return std::string{};
+        DebugConfig::instance().log("No USR/NSR for Param type declerations", DebugConfig::Level::INFO);
+        return DeclIdentifiers{};
     }
     
-    llvm::SmallString<256> Buf;
-    armor::generateUSRForDecl(Decl, Buf);
+    llvm::SmallString<256> USRBuf;
+    llvm::SmallString<256> NSRBuf;
+    armor::generateUSRAndNSRForDecl(Decl, USRBuf, NSRBuf);
 
-    return Buf.c_str();
+    return DeclIdentifiers{USRBuf.str().str(), NSRBuf.str().str()};
 
 }
 
-const std::string generateNSRForDecl(const clang::NamedDecl * Decl){
-
-    if (llvm::isa<clang::ParmVarDecl>(Decl)|| llvm::isa<clang::TemplateTypeParmDecl>(Decl) 
-    || llvm::isa<clang::NonTypeTemplateParmDecl>(Decl) || llvm::isa<clang::TemplateTemplateParmDecl>(Decl)) {
-        DebugConfig::instance().log("No NSR for Param type declerations", DebugConfig::Level::INFO);
-        return std::string{};
-    }
 
-    llvm::SmallString<256> Buf;
-    armor::generateNSRForDecl(Decl, Buf);
-
-    return Buf.c_str();
+namespace {
 
+clang::PrintingPolicy typePolicy(const clang::ASTContext &Ctx, bool canonical) {
+    clang::PrintingPolicy Policy(Ctx.getLangOpts());
+    Policy.SuppressTagKeyword = false;
+    Policy.SuppressScope = false;
+    Policy.FullyQualifiedName = true;
+    Policy.AnonymousTagLocations = false;
+    Policy.PrintCanonicalTypes = canonical;
+    return Policy;
 }
 
-
-const std::pair<const std::string,const std::string> getTypesWithAndWithoutTypeResolution(const clang::QualType T, const clang::ASTContext &Ctx) {
-    
-    if (T.isNull()) {
-        return {std::string{}, std::string{}};
-    }
-    
-    clang::PrintingPolicy Policy1(Ctx.getLangOpts());
-    Policy1.SuppressTagKeyword = false;
-    Policy1.SuppressScope = false;
-    Policy1.FullyQualifiedName = true;
-    Policy1.AnonymousTagLocations = false;
-    Policy1.PrintCanonicalTypes = false;
-    
+std::string printType(const clang::QualType T, const clang::PrintingPolicy &Policy) {
     std::string TypeStr;
     llvm::raw_string_ostream OS(TypeStr);
-    
+
     try {
-        T.print(OS, Policy1);
+        T.print(OS, Policy);
     } 
     catch (...) {
-        TypeStr = std::string{};
+        return std::string{};
     }
+    return OS.str();
+}
 
-    clang::PrintingPolicy Policy2(Ctx.getLangOpts());
-    Policy2.SuppressTagKeyword = false;
-    Policy2.SuppressScope = false;
-    Policy2.FullyQualifiedName = true;
-    Policy2.AnonymousTagLocations = false;
-    Policy2.PrintCanonicalTypes = false;
-    Policy2.PrintCanonicalTypes = true;
+}
 
-    std::string CanonicalTypeStr;
-    llvm::raw_string_ostream COS(CanonicalTypeStr);
+TypeStringCache::TypeStringCache(const clang::ASTContext &Ctx, StringPool &strings)
+    : m_asWritten(typePolicy(Ctx, false)), m_canonical(typePolicy(Ctx, true)), m_strings(strings) {}
 
-    try {
-        T.getCanonicalType().print(COS, Policy2);
-    } 
-    catch (...) {
-        CanonicalTypeStr = std::string{};
+const TypeStringCache::Canonical& TypeStringCache::getCanonical(const clang::QualType T, llvm::StringRef asWritten) {
+
+    const clang::QualType CanonicalT = T.getCanonicalType();
+    auto [it, inserted] = m_canonicalTypes.try_emplace(CanonicalT.getAsOpaquePtr());
+    if (!inserted) {
+        return it->second;
     }
+
+    bool usesTemplates = false;
+    it->second.hash = armor::hashCanonicalType(CanonicalT, usesTemplates);
+
+    // Canonical printing only differs from the plain one in how it spells
+    // template specializations, so a canonical type without any prints the same
+    if (T.isCanonical() && !usesTemplates && it->second.hash != 0) {
+        it->second.str = asWritten;
+    }
+    else {
+        it->second.str = m_strings.intern(printType(CanonicalT, m_canonical));
+    }
+
+    if (it->second.hash == 0) {
+        it->second.hash = llvm::xxHash64(it->second.str);
+    }
+    return it->second;
+}
+
+TypeStrings TypeStringCache::getTypesWithAndWithoutTypeResolution(const clang::QualType T) {
     
-    return {TypeStr,CanonicalTypeStr};
+    if (T.isNull()) {
+        return TypeStrings{};
+    }
+
+    auto it = m_types.find(T.getAsOpaquePtr());
+    if (it != m_types.end()) {
+        ++m_hits;
+        return it->second;
+    }
+    ++m_misses;
+
+    TypeStrings types;
+    types.asWritten = m_strings.intern(printType(T, m_asWritten));
+    const Canonical &canonical = getCanonical(T, types.asWritten);
+    types.canonical = canonical.str;
+    types.canonicalHash = canonical.hash;
+    return m_types[T.getAsOpaquePtr()] = types;
     
 }
 
@@ -206,4 +227,28 @@ const std::string generateHash( llvm::StringRef qualifiedName , const NodeKind&
     
     return hashBuf.c_str();
 
-}
\ No newline at end of file
+}
+
+std::vector<clang::Decl*> getMainFileTopLevelDecls(clang::ASTContext &Ctx){
+
+    const clang::SourceManager &SM = Ctx.getSourceManager();
+    std::vector<clang::Decl*> decls;
+
+    // An AST loaded from a file keeps the main file's own declarations there too
+    const clang::TranslationUnitDecl *TU = Ctx.getTranslationUnitDecl();
+    auto collect = [&](auto range) {
+        for (clang::Decl *D : range) {
+            if (SM.isInMainFile(D->getLocation())) {
+                decls.push_back(D);
+            }
+        }
+    };
+    if (SM.isLoadedFileID(SM.getMainFileID())) {
+        collect(TU->decls());
+    } else {
+        collect(TU->noload_decls());
+    }
+
+    return decls;
+
+}
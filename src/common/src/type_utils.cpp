@@ -3,6 +3,14 @@
 
 #include "type_utils.hpp"
 
+#include "clang/AST/Decl.h"
+#include "clang/AST/DeclTemplate.h"
+#include "clang/AST/TemplateBase.h"
+#include "llvm/ADT/SmallString.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+
 using namespace clang;
 
 namespace armor {
@@ -46,4 +54,237 @@ QualType unwrapTypeModifiers(QualType OriginalType) {
     return QT;
 }
 
-} // namespace armor
\ No newline at end of file
+namespace {
+
+// Serializes the parts of a canonical type that tell it apart into a byte
+// buffer; the hash of the buffer is the hash of the type.
+class TypeHasher {
+public:
+    bool addType(QualType T);
+    uint64_t finish() const { return llvm::xxHash64(llvm::ArrayRef<uint8_t>(m_bytes)); }
+    bool usesTemplates() const { return m_usesTemplates; }
+
+private:
+    bool addScope(const DeclContext *DC);
+    bool addTemplateArgument(const TemplateArgument &Arg);
+    void addExtInfo(const FunctionType::ExtInfo &Info);
+    void addQualifiedName(const NamedDecl *D);
+    void addName(llvm::StringRef Name);
+    void addInteger(uint64_t Value);
+
+    llvm::SmallVector<uint8_t, 256> m_bytes;
+    bool m_usesTemplates = false;
+};
+
+void TypeHasher::addInteger(uint64_t Value) {
+    for (unsigned I = 0; I < sizeof(Value); ++I) {
+        m_bytes.push_back(static_cast<uint8_t>(Value >> (8 * I)));
+    }
+}
+
+// Length-prefixed, so that adjacent names cannot run into each other
+void TypeHasher::addName(llvm::StringRef Name) {
+    addInteger(Name.size());
+    m_bytes.append(Name.bytes_begin(), Name.bytes_end());
+}
+
+void TypeHasher::addQualifiedName(const NamedDecl *D) {
+    llvm::SmallString<128> Name;
+    llvm::raw_svector_ostream OS(Name);
+    D->printQualifiedName(OS);
+    addName(Name);
+}
+
+void TypeHasher::addExtInfo(const FunctionType::ExtInfo &Info) {
+    addInteger(Info.getCC());
+    addInteger(Info.getNoReturn());
+    addInteger(Info.getProducesResult());
+}
+
+bool TypeHasher::addType(QualType T) {
+    if (T.isNull())
+        return false;
+
+    const SplitQualType Split = T.getCanonicalType().split();
+    const Type *Ty = Split.Ty;
+    if (Ty->isDependentType())
+        return false;
+
+    addInteger(Split.Quals.getAsOpaqueValue());
+    addInteger(Ty->getTypeClass());
+
+    switch (Ty->getTypeClass()) {
+    case Type::Builtin:
+        addInteger(cast<BuiltinType>(Ty)->getKind());
+        return true;
+
+    case Type::Pointer:
+    case Type::BlockPointer:
+    case Type::LValueReference:
+    case Type::RValueReference:
+        return addType(Ty->getPointeeType());
+
+    case Type::MemberPointer: {
+        const auto *MPT = cast<MemberPointerType>(Ty);
+        return addType(QualType(MPT->getClass(), 0)) && addType(MPT->getPointeeType());
+    }
+
+    case Type::ConstantArray: {
+        const auto *CAT = cast<ConstantArrayType>(Ty);
+        addInteger(CAT->getSize().getLimitedValue());
+        addInteger(CAT->getSizeModifier());
+        addInteger(CAT->getIndexTypeCVRQualifiers());
+        return addType(CAT->getElementType());
+    }
+
+    case Type::IncompleteArray: {
+        const auto *IAT = cast<IncompleteArrayType>(Ty);
+        addInteger(IAT->getSizeModifier());
+        addInteger(IAT->getIndexTypeCVRQualifiers());
+        return addType(IAT->getElementType());
+    }
+
+    case Type::Vector:
+    case Type::ExtVector: {
+        const auto *VT = cast<VectorType>(Ty);
+        addInteger(VT->getNumElements());
+        addInteger(VT->getVectorKind());
+        return addType(VT->getElementType());
+    }
+
+    case Type::Complex:
+        return addType(cast<ComplexType>(Ty)->getElementType());
+
+    case Type::Atomic:
+        return addType(cast<AtomicType>(Ty)->getValueType());
+
+    case Type::FunctionNoProto: {
+        const auto *FT = cast<FunctionNoProtoType>(Ty);
+        addExtInfo(FT->getExtInfo());
+        return addType(FT->getReturnType());
+    }
+
+    case Type::FunctionProto: {
+        const auto *FPT = cast<FunctionProtoType>(Ty);
+        addExtInfo(FPT->getExtInfo());
+        addInteger(FPT->isVariadic());
+        addInteger(FPT->getMethodQuals().getAsOpaqueValue());
+        addInteger(FPT->getRefQualifier());
+        addInteger(FPT->getExceptionSpecType());
+        if (!addType(FPT->getReturnType()))
+            return false;
+        addInteger(FPT->getNumParams());
+        for (QualType Param : FPT->param_types()) {
+            if (!addType(Param))
+                return false;
+        }
+        addInteger(FPT->getNumExceptions());
+        for (QualType Exception : FPT->exceptions()) {
+            if (!addType(Exception))
+                return false;
+        }
+        return true;
+    }
+
+    case Type::Record:
+    case Type::Enum: {
+        const TagDecl *Tag = cast<TagType>(Ty)->getDecl();
+        addInteger(Tag->getTagKind());
+        return addScope(Tag);
+    }
+
+    default:
+        return false;
+    }
+}
+
+// A tag is told apart by the names of the scopes enclosing it, as the
+// fully qualified printed name would be
+bool TypeHasher::addScope(const DeclContext *DC) {
+    for (; DC && !DC->isTranslationUnit(); DC = DC->getParent()) {
+        const auto *ND = dyn_cast<NamedDecl>(DC);
+        if (!ND)
+            continue;
+
+        addInteger(ND->getKind());
+        const NamedDecl *Named = ND;
+        if (const auto *Tag = dyn_cast<TagDecl>(ND); Tag && !Tag->getIdentifier()) {
+            if (const TypedefNameDecl *Typedef = Tag->getTypedefNameForAnonDecl())
+                Named = Typedef;
+        }
+        llvm::SmallString<64> Name;
+        if (Named->getDeclName()) {
+            llvm::raw_svector_ostream OS(Name);
+            Named->printName(OS);
+        }
+        addName(Name);
+
+        if (const auto *Spec = dyn_cast<ClassTemplateSpecializationDecl>(ND)) {
+            m_usesTemplates = true;
+            llvm::ArrayRef<TemplateArgument> Args = Spec->getTemplateArgs().asArray();
+            addInteger(Args.size());
+            for (const TemplateArgument &Arg : Args) {
+                if (!addTemplateArgument(Arg))
+                    return false;
+            }
+        }
+    }
+    return true;
+}
+
+bool TypeHasher::addTemplateArgument(const TemplateArgument &Arg) {
+    addInteger(Arg.getKind());
+
+    switch (Arg.getKind()) {
+    case TemplateArgument::Type:
+        return addType(Arg.getAsType());
+
+    case TemplateArgument::Integral: {
+        llvm::SmallString<32> Value;
+        Arg.getAsIntegral().toString(Value);
+        addName(Value);
+        return addType(Arg.getIntegralType());
+    }
+
+    case TemplateArgument::NullPtr:
+        return addType(Arg.getNullPtrType());
+
+    case TemplateArgument::Declaration:
+        addQualifiedName(Arg.getAsDecl());
+        return addType(Arg.getParamTypeForDecl());
+
+    case TemplateArgument::Template:
+        if (const TemplateDecl *Template = Arg.getAsTemplate().getAsTemplateDecl()) {
+            addQualifiedName(Template);
+            return true;
+        }
+        return false;
+
+    case TemplateArgument::Pack:
+        addInteger(Arg.pack_size());
+        for (const TemplateArgument &Element : Arg.pack_elements()) {
+            if (!addTemplateArgument(Element))
+                return false;
+        }
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+} // namespace
+
+uint64_t hashCanonicalType(QualType T, bool &UsesTemplates) {
+    TypeHasher Hasher;
+    const bool Walked = Hasher.addType(T);
+    UsesTemplates = Hasher.usesTemplates();
+    if (!Walked)
+        return 0;
+
+    // 0 is kept for "not walked"
+    const uint64_t Hash = Hasher.finish();
+    return Hash ? Hash : 1;
+}
+
+} // namespace armor
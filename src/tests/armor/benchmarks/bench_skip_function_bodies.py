@@ -0,0 +1,88 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+"""Times armor on an inline-heavy C++ header with and without --skip-function-bodies.
+
+Generates a header pair whose classes are mostly inline member functions and
+function templates, compares it a few times in each mode and prints the median
+wall time. The reports of both modes must be identical.
+
+    python3 src/tests/armor/benchmarks/bench_skip_function_bodies.py --binary build/src/armor/armor
+"""
+
+import argparse
+import filecmp
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+import time
+
+
+def write_header(path, classes, methods, extra_field):
+    lines = ["#pragma once", "#include <algorithm>", "#include <map>", "#include <string>", "#include <vector>", ""]
+    for c in range(classes):
+        lines.append(f"class Widget{c} {{")
+        lines.append("public:")
+        for m in range(methods):
+            lines.append(f"    int method{m}(const std::vector<int>& values) const {{")
+            lines.append("        std::map<std::string, int> counts;")
+            lines.append("        for (int v : values) { counts[std::to_string(v % 7)] += v; }")
+            lines.append(f"        return std::count_if(values.begin(), values.end(), [](int v) {{ return v > {m}; }})")
+            lines.append("               + static_cast<int>(counts.size());")
+            lines.append("    }")
+            lines.append(f"    template <typename T> T scaled{m}(T value) const {{ return value * T({m} + 1); }}")
+        lines.append("private:")
+        lines.append("    int m_state = 0;")
+        if extra_field:
+            lines.append("    int m_extra = 0;")
+        lines.append("};")
+        lines.append("")
+    with open(path, "w") as f:
+        f.write("\n".join(lines))
+
+
+def run(binary, root, output_dir, skip):
+    args = [binary, os.path.join(root, "v1"), os.path.join(root, "v2"), "widgets.h", "-r", "json",
+            "--output-dir", output_dir]
+    if skip:
+        args.append("--skip-function-bodies")
+    start = time.perf_counter()
+    subprocess.run(args, check=True, capture_output=True)
+    return time.perf_counter() - start
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--binary", default="build/src/armor/armor")
+    parser.add_argument("--classes", type=int, default=40)
+    parser.add_argument("--methods", type=int, default=25)
+    parser.add_argument("--runs", type=int, default=5)
+    options = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as root:
+        for version in ["v1", "v2"]:
+            os.makedirs(os.path.join(root, version))
+            write_header(os.path.join(root, version, "widgets.h"), options.classes, options.methods,
+                         extra_field=version == "v2")
+
+        times = {}
+        for skip in [False, True]:
+            output_dir = os.path.join(root, "skip" if skip else "full")
+            times[skip] = [run(options.binary, root, output_dir, skip) for _ in range(options.runs)]
+
+        report = os.path.join("armor_reports", "json_reports", "api_diff_report_widgets.h.json")
+        same = filecmp.cmp(os.path.join(root, "full", report), os.path.join(root, "skip", report), shallow=False)
+
+    full = statistics.median(times[False])
+    skip = statistics.median(times[True])
+    print(f"{options.classes} classes x {options.methods} inline methods, median of {options.runs} runs")
+    print(f"  full parse:             {full:.3f} s")
+    print(f"  --skip-function-bodies: {skip:.3f} s  ({full / skip:.2f}x)")
+    print(f"  reports identical:      {same}")
+    return 0 if same else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,88 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+"""Measures the peak memory of armor on a header with many declarations.
+
+Generates a header pair of structs, functions, enums and typedefs (100k
+top-level declarations by default), compares it and prints the peak resident
+set size of the run. Given a second binary built from an earlier revision with
+--baseline, runs both and prints the saving; their reports must be identical.
+
+    python3 src/tests/armor/benchmarks/bench_tree_memory.py --binary build/src/armor/armor \\
+        --baseline /path/to/older/armor
+"""
+
+import argparse
+import filecmp
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+
+def write_header(path, declarations, changed):
+    lines = ["#pragma once", ""]
+    for i in range(declarations // 4):
+        # Every hundredth group changes in the newer header
+        extra = changed and i % 100 == 0
+        lines.append(f"struct Record{i} {{ int id; double value; const char* name;{' long extra;' if extra else ''} }};")
+        lines.append(f"int process{i}(struct Record{i}* record, unsigned flags, {'long' if extra else 'int'} limit);")
+        lines.append(f"enum State{i} {{ State{i}_Idle, State{i}_Busy, State{i}_Done }};")
+        lines.append(f"typedef {'unsigned long' if extra else 'unsigned int'} Handle{i};")
+    with open(path, "w") as f:
+        f.write("\n".join(lines) + "\n")
+
+
+# Peak resident set size of one run, in MiB
+def run(binary, root, output_dir):
+    args = [binary, os.path.join(root, "v1"), os.path.join(root, "v2"), "records.h", "-r", "json",
+            "--output-dir", output_dir]
+    process = subprocess.Popen(args, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+    _, status, usage = os.wait4(process.pid, 0)
+    if status != 0:
+        raise RuntimeError(f"{binary} exited with status {status}")
+    return usage.ru_maxrss / 1024
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--binary", default="build/src/armor/armor")
+    parser.add_argument("--baseline", help="armor built from an earlier revision, to compare against")
+    parser.add_argument("--declarations", type=int, default=100000)
+    parser.add_argument("--runs", type=int, default=3)
+    options = parser.parse_args()
+
+    binaries = {"binary": options.binary}
+    if options.baseline:
+        binaries["baseline"] = options.baseline
+
+    with tempfile.TemporaryDirectory() as root:
+        for version in ["v1", "v2"]:
+            os.makedirs(os.path.join(root, version))
+            write_header(os.path.join(root, version, "records.h"), options.declarations, changed=version == "v2")
+
+        peaks = {}
+        for name, binary in binaries.items():
+            output_dir = os.path.join(root, name)
+            peaks[name] = [run(binary, root, output_dir) for _ in range(options.runs)]
+
+        same = True
+        if options.baseline:
+            report = os.path.join("armor_reports", "json_reports", "api_diff_report_records.h.json")
+            same = filecmp.cmp(os.path.join(root, "binary", report), os.path.join(root, "baseline", report),
+                               shallow=False)
+
+    peak = statistics.median(peaks["binary"])
+    print(f"{options.declarations} declarations, median of {options.runs} runs")
+    print(f"  peak RSS:          {peak:.1f} MiB")
+    if options.baseline:
+        baseline = statistics.median(peaks["baseline"])
+        print(f"  baseline peak RSS: {baseline:.1f} MiB  ({baseline - peak:+.1f} MiB saved, "
+              f"{100 * (baseline - peak) / baseline:.1f}%)")
+        print(f"  reports identical: {same}")
+    return 0 if same else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
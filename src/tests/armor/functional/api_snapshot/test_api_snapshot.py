@@ -0,0 +1,71 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import shutil
+
+HEADER = "include/valve.h"
+
+
+# The snapshot holds the newer side, so a copy of the release is compared with it
+def emit_snapshot(run_armor, tmp_path, release, snapshot, *headers):
+    release_copy = tmp_path / "release"
+    if not release_copy.exists():
+        shutil.copytree(release, release_copy)
+    return run_armor(release, release_copy, *headers, "--emit-snapshot", snapshot, output_dir=tmp_path / "emit")
+
+
+def test_snapshot_stands_in_for_the_older_root(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    snapshot = tmp_path / "v1.armorapi"
+
+    # Unchanged headers are parsed too when a snapshot is written
+    emitted = emit_snapshot(run_armor, tmp_path, old_root, snapshot, "--header-dir", "include")
+    assert emitted.returncode == 0
+    assert "API snapshot of 2 headers written to" in emitted.stdout
+    with open(snapshot, 'rb') as f:
+        assert f.read(8) == b"ARMORAPI"
+
+    from_sources = run_armor(old_root, new_root, HEADER, output_dir=tmp_path / "sources")
+    from_snapshot = run_armor(snapshot, new_root, HEADER, output_dir=tmp_path / "snapshot")
+    assert from_sources.returncode == 0
+    assert from_snapshot.returncode == 0
+
+    # The older tree read from the snapshot is the one a parse gives
+    assert load_report(tmp_path / "snapshot", HEADER) == load_report(tmp_path / "sources", HEADER)
+    assert "Comparing against the tree of include/valve.h in" in read_log(tmp_path / "snapshot")
+
+
+def test_snapshot_header_dir_skips_unchanged_headers(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    snapshot = tmp_path / "v1.armorapi"
+
+    assert emit_snapshot(run_armor, tmp_path, old_root, snapshot, "--header-dir", "include").returncode == 0
+    result = run_armor(snapshot, new_root, "--header-dir", "include", output_dir=tmp_path / "snapshot")
+
+    assert result.returncode == 0
+    # pump.h kept the content it had when the snapshot was written
+    assert "No differences found between" in result.stdout
+    assert "pump.h" in result.stdout
+    assert load_report(tmp_path / "snapshot", HEADER)
+
+
+def test_corrupt_snapshot_is_rejected(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    snapshot = tmp_path / "v1.armorapi"
+
+    assert emit_snapshot(run_armor, tmp_path, old_root, snapshot, HEADER).returncode == 0
+    data = snapshot.read_bytes()
+    snapshot.write_bytes(data[:len(data) // 2])
+
+    result = run_armor(snapshot, new_root, HEADER, output_dir=tmp_path / "snapshot")
+    assert "is truncated or corrupt" in result.stderr + result.stdout
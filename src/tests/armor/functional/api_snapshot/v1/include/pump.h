@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef PUMP_H
+#define PUMP_H
+
+struct Pump {
+    unsigned rpm;
+};
+
+#endif
@@ -0,0 +1,25 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef VALVE_H
+#define VALVE_H
+
+namespace plant {
+
+enum class ValveState { Closed, Open };
+
+class Valve {
+public:
+    virtual ~Valve();
+    virtual void open(int percent);
+    ValveState state() const;
+
+private:
+    int m_percent;
+};
+
+int valve_count();
+
+}
+
+#endif
@@ -0,0 +1,24 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef VALVE_H
+#define VALVE_H
+
+namespace plant {
+
+enum class ValveState { Closed, Open, Stuck };
+
+class Valve {
+public:
+    virtual ~Valve();
+    virtual void open(double percent);
+    ValveState state() const;
+    void close();
+
+private:
+    double m_percent;
+};
+
+}
+
+#endif
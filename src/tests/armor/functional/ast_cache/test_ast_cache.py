@@ -0,0 +1,71 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import shutil
+
+HEADER = "include/gearbox.h"
+
+
+def test_ast_cache_stored_then_loaded(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+
+    plain = run_armor(old_root, new_root, HEADER, output_dir=tmp_path / "plain")
+    first = run_armor(old_root, new_root, HEADER, "--ast-cache", output_dir=tmp_path / "first")
+    second = run_armor(old_root, new_root, HEADER, "--ast-cache", output_dir=tmp_path / "second")
+
+    assert plain.returncode == 0
+    assert first.returncode == 0
+    assert second.returncode == 0
+
+    # The older header is parsed and stored once, then loaded
+    first_log = read_log(tmp_path / "first")
+    second_log = read_log(tmp_path / "second")
+    assert "Stored AST of" in first_log
+    assert "Loaded AST of" not in first_log
+    assert "Loaded AST of" in second_log
+    assert "AST cache: 1 loaded, 0 parsed, 0 stored" in second_log
+
+    # A loaded AST gives the same reports as a parse
+    assert load_report(tmp_path / "first", HEADER) == load_report(tmp_path / "plain", HEADER)
+    assert load_report(tmp_path / "second", HEADER) == load_report(tmp_path / "plain", HEADER)
+
+
+def test_ast_cache_missed_when_an_include_changes(run_armor, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    # A copy of the older tree whose included header is edited between the runs
+    old_root = tmp_path / "v1"
+    shutil.copytree(os.path.join(test_dir, "v1"), old_root)
+    new_root = os.path.join(test_dir, "v2")
+
+    assert run_armor(old_root, new_root, HEADER, "--ast-cache", output_dir=tmp_path / "first").returncode == 0
+    with open(old_root / "include" / "gearbox_types.h", 'a') as f:
+        f.write("\ntypedef uint16_t torque_t;\n")
+    result = run_armor(old_root, new_root, HEADER, "--ast-cache", output_dir=tmp_path / "second")
+
+    assert result.returncode == 0
+    log = read_log(tmp_path / "second")
+    assert "Loaded AST of" not in log
+    assert "AST cache: 0 loaded, 1 parsed, 1 stored" in log
+
+
+def test_ast_cache_size_cap(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = tmp_path / "v1"
+    shutil.copytree(os.path.join(test_dir, "v1"), old_root)
+    new_root = os.path.join(test_dir, "v2")
+    cache = ["--ast-cache", "--ast-cache-size", "1"]
+
+    # Every edit stores one more AST; only the latest ones that fit in a megabyte are kept
+    for run in range(3):
+        with open(old_root / "include" / "gearbox_types.h", 'a') as f:
+            f.write("\ntypedef uint16_t torque%d_t;\n" % run)
+        assert run_armor(old_root, new_root, HEADER, *cache, output_dir=tmp_path / "run%d" % run).returncode == 0
+
+    asts = (tmp_path / "cache" / "armor" / "ast").glob("*.ast")
+    assert sum(ast.stat().st_size for ast in asts) <= 1 << 20
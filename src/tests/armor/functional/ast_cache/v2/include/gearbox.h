@@ -0,0 +1,16 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef GEARBOX_H
+#define GEARBOX_H
+
+#include "gearbox_types.h"
+
+struct Gearbox {
+    gear_t gear;
+    uint64_t ratio;
+};
+
+int gearbox_shift(struct Gearbox* gearbox, gear_t gear, int force);
+
+#endif
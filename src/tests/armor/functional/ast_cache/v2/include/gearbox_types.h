@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef GEARBOX_TYPES_H
+#define GEARBOX_TYPES_H
+
+#include <stdint.h>
+
+typedef uint8_t gear_t;
+
+#endif
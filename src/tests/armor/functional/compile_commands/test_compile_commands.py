@@ -0,0 +1,73 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+
+HEADER = "include/actuator.h"
+
+
+# The database compiles the newer tree's source file, not the header itself
+def write_compile_commands(build_dir, new_root, *extra):
+    build_dir.mkdir()
+    entry = {
+        "directory": str(new_root),
+        "file": os.path.join(str(new_root), "src", "actuator.cpp"),
+        "arguments": ["c++", "-Iinclude", "-I", "config", "-DACTUATOR_HAS_TORQUE=1", "-std=c++17"] + list(extra) +
+                     ["-MD", "-MF", "actuator.d", "-c", "src/actuator.cpp", "-o", "actuator.o"]
+    }
+    with open(build_dir / "compile_commands.json", 'w') as f:
+        json.dump([entry], f)
+
+
+def test_header_takes_flags_of_its_translation_unit(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    build_dir = tmp_path / "build"
+    write_compile_commands(build_dir, new_root)
+
+    result = run_armor(old_root, new_root, HEADER, "-p", build_dir, output_dir=tmp_path / "build")
+
+    assert result.returncode == 0
+    log = read_log(tmp_path / "build")
+    assert "compile_commands.json: 1 of 1 headers matched, in 1 flag sets" in log
+    assert "'actuator_config.h' file not found" not in log
+
+    # The macro enables the declaration and each tree finds its own config directory
+    report = load_report(tmp_path / "build", HEADER)
+    names = [row.get("name", "") for row in report]
+    assert any("actuator_set_torque" in name for name in names)
+    assert any("actuator_stop" in name for name in names)
+    assert any("position" in name for name in names)
+
+
+def test_forced_include_is_taken_from_each_tree(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    build_dir = tmp_path / "build"
+    write_compile_commands(build_dir, new_root, "-include", "config/actuator_defaults.h")
+
+    result = run_armor(old_root, new_root, HEADER, "-p", build_dir, output_dir=tmp_path / "build")
+
+    assert result.returncode == 0
+    # Each tree is parsed with its own actuator_defaults.h, so the array size differs
+    report = load_report(tmp_path / "build", HEADER)
+    assert any("actuator_speed_table" in row.get("name", "") for row in report)
+
+
+def test_missing_compile_commands_is_an_error(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    build_dir = tmp_path / "empty_build"
+    build_dir.mkdir()
+
+    result = run_armor(old_root, new_root, HEADER, "-p", build_dir, output_dir=tmp_path / "build")
+
+    assert result.returncode != 0
+    assert "Cannot read compilation database" in result.stderr + result.stdout
@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef ACTUATOR_CONFIG_H
+#define ACTUATOR_CONFIG_H
+
+#include <stdint.h>
+
+typedef int32_t actuator_pos_t;
+
+#endif
@@ -0,0 +1,4 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#define ACTUATOR_MAX_SPEED 200
@@ -0,0 +1,25 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef ACTUATOR_H
+#define ACTUATOR_H
+
+#include <actuator_config.h>
+
+struct Actuator {
+    actuator_pos_t position;
+};
+
+int actuator_move(struct Actuator* actuator, actuator_pos_t target);
+
+int actuator_stop(struct Actuator* actuator);
+
+#ifdef ACTUATOR_MAX_SPEED
+extern int actuator_speed_table[ACTUATOR_MAX_SPEED];
+#endif
+
+#if ACTUATOR_HAS_TORQUE
+int actuator_set_torque(struct Actuator* actuator, int32_t torque, uint32_t ramp_ms);
+#endif
+
+#endif
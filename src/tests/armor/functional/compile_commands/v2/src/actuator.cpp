@@ -0,0 +1,9 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "actuator.h"
+
+int actuator_move(struct Actuator* actuator, actuator_pos_t target) {
+    actuator->position = target;
+    return 0;
+}
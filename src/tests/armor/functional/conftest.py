@@ -2,6 +2,8 @@
 # SPDX-License-Identifier: BSD-3-Clause
 
 import os
+import json
+import subprocess
 import pytest
 
 def find_path_from_project_root(marker):
@@ -39,3 +41,43 @@ def dependent_binary_args(request):
     prj_root2 = os.path.join(curr_dir, "v2")
     return [prj_root1, prj_root2, "mylib.h","-Iinclude", "--dump-ast-diff", "-r", "json"]
 
+
+@pytest.fixture
+def run_armor(binary_path, tmp_path):
+    """Returns a function running the binary on the given arguments from tmp_path, with its
+    cache directory kept under tmp_path and its output written to output_dir if given."""
+    def run(*args, output_dir=None, cwd=None, report_format="json", log_level="INFO", check=False, timeout=None):
+        command = [binary_path] + [str(arg) for arg in args]
+        if report_format:
+            command += ["-r", report_format]
+        if log_level:
+            command += ["--log-level", log_level]
+        if output_dir is not None:
+            command += ["--output-dir", str(output_dir)]
+        return subprocess.run(
+            command,
+            check=check,
+            timeout=timeout,
+            cwd=cwd or tmp_path,
+            env=dict(os.environ, XDG_CACHE_HOME=str(tmp_path / "cache")),
+            capture_output=True,
+            text=True
+        )
+    return run
+
+@pytest.fixture
+def load_report():
+    """Returns a function loading the JSON report of a header from an output directory."""
+    def load(output_dir, header):
+        name = "api_diff_report_" + header.replace("/", "%2F") + ".json"
+        with open(os.path.join(output_dir, "armor_reports", "json_reports", name), 'r') as f:
+            return json.load(f)
+    return load
+
+@pytest.fixture
+def read_log():
+    """Returns a function reading the diagnostics log from an output directory."""
+    def read(output_dir):
+        with open(os.path.join(output_dir, "debug_output", "logs", "diagnostics.log"), 'r') as f:
+            return f.read()
+    return read
@@ -0,0 +1,68 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import shutil
+import subprocess
+
+
+def git(repo, *args):
+    subprocess.run(["git", "-C", str(repo), "-c", "user.name=armor", "-c", "user.email=armor@localhost"]
+                   + list(args), check=True, capture_output=True)
+
+
+# Commits the v1 tree, then the v2 tree, to a fresh repository
+def make_repo(test_dir, tmp_path):
+    repo = tmp_path / "repo"
+    repo.mkdir()
+    git(repo, "init", "-q")
+    for version in ["v1", "v2"]:
+        shutil.rmtree(repo / "include", ignore_errors=True)
+        shutil.copytree(os.path.join(test_dir, version, "include"), repo / "include")
+        git(repo, "add", "-A")
+        git(repo, "commit", "-q", "-m", version)
+    return repo
+
+
+def test_git_revisions_match_checkouts(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    repo = make_repo(test_dir, tmp_path)
+
+    checkout = run_armor(os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2"), "include/sensor.h",
+                         output_dir=tmp_path / "checkout")
+    revisions = run_armor("--git-repo", repo, "--old-rev", "HEAD~1", "--new-rev", "HEAD", "include/sensor.h",
+                          output_dir=tmp_path / "git")
+
+    assert checkout.returncode == 0
+    assert revisions.returncode == 0
+    # Includes of the header are read from the same revision
+    assert load_report(tmp_path / "git", "include/sensor.h") == load_report(tmp_path / "checkout", "include/sensor.h")
+    # Nothing is checked out into the repository
+    assert sorted(os.listdir(repo)) == [".git", "include"]
+
+
+def test_header_added_in_new_revision(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    repo = make_repo(test_dir, tmp_path)
+
+    result = run_armor("--git-repo", repo, "--old-rev", "HEAD~1", "--new-rev", "HEAD", "include/calib.h",
+                       output_dir=tmp_path)
+
+    assert result.returncode == 0
+    assert "Missing header in older version" not in result.stderr
+    # Compared against an empty file, so its whole API is new
+    report = load_report(tmp_path, "include/calib.h")
+    assert any("calib_apply" in row.get("name", "") for row in report)
+
+
+def test_unknown_revision(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    repo = make_repo(test_dir, tmp_path)
+
+    result = run_armor("--git-repo", repo, "--old-rev", "no-such-tag", "--new-rev", "HEAD", "include/sensor.h")
+
+    assert result.returncode != 0
+    assert "Unknown revision 'no-such-tag'" in result.stderr
@@ -0,0 +1,6 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "sensor.h"
+
+int calib_apply(struct Sensor* sensor, int offset);
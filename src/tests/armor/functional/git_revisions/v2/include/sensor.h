@@ -0,0 +1,12 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "types.h"
+
+struct Sensor {
+    sensor_id_t id;
+    int rate;
+    int range;
+};
+
+int sensor_read(struct Sensor* sensor, int channel);
@@ -0,0 +1,37 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+
+
+def listed_headers(stdout):
+    lines = stdout.splitlines()
+    start = lines.index("List of headers to process:") + 1
+    return [line.strip() for line in lines[start:] if line.startswith("  ")]
+
+
+def test_header_dir_is_walked_recursively(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    result = run_armor(os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2"), "--header-dir", "include",
+                       output_dir=tmp_path, report_format=None, log_level=None)
+
+    assert listed_headers(result.stdout) == [
+        "media/frame.hxx",
+        "media/frame_impl.inl",
+        "net/internal/ring.h",
+        "net/socket.hh",
+    ]
+    assert "No differences found between: " in result.stdout
+    reports = tmp_path / "armor_reports" / "html_reports"
+    assert (reports / "api_diff_report_include%2Fnet%2Fsocket.hh.html").is_file()
+
+
+def test_header_dir_globs(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    result = run_armor(os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2"), "--header-dir", "include",
+                       "--header-glob", "net/*", "--exclude-glob", "*/internal/*",
+                       output_dir=tmp_path, report_format=None, log_level=None)
+
+    assert listed_headers(result.stdout) == ["net/socket.hh"]
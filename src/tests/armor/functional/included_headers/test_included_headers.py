@@ -0,0 +1,42 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+
+HEADER = "mylib.h"
+
+
+def assert_only_main_file_declarations(report):
+    rows = [row.get("name", "") + " " + row.get("description", "") for row in report]
+    # mylib_types.h changed as well, but only what mylib.h itself declares is its API
+    assert any("sensor_close" in row for row in rows)
+    assert any("flags" in row for row in rows)
+    assert not any(other in row for row in rows
+                   for other in ("sensor_config", "sensor_probe", "sensor_reset"))
+
+
+def test_only_main_file_declarations(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    result = run_armor(old_root, new_root, HEADER, output_dir=tmp_path / "plain")
+
+    assert result.returncode == 0
+    assert_only_main_file_declarations(load_report(tmp_path / "plain", HEADER))
+
+
+def test_only_main_file_declarations_of_a_loaded_ast(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    first = run_armor(old_root, new_root, HEADER, "--ast-cache", output_dir=tmp_path / "first")
+    second = run_armor(old_root, new_root, HEADER, "--ast-cache", output_dir=tmp_path / "second")
+
+    assert first.returncode == 0
+    assert second.returncode == 0
+    # A loaded AST carries the included header's declarations too; they stay out of the report
+    assert "Loaded AST of" in read_log(tmp_path / "second")
+    assert_only_main_file_declarations(load_report(tmp_path / "second", HEADER))
+    assert load_report(tmp_path / "second", HEADER) == load_report(tmp_path / "first", HEADER)
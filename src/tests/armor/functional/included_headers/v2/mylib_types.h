@@ -0,0 +1,15 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef MYLIB_TYPES_H
+#define MYLIB_TYPES_H
+
+struct sensor_config {
+    int rate;
+    int gain;
+};
+
+int sensor_probe(int bus, int address);
+void sensor_reset(void);
+
+#endif
@@ -0,0 +1,61 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+import shutil
+import subprocess
+
+HEADERS = ["timer.h", "uart.h"]
+
+
+def test_isolated_workers_match_in_process_run(binary_path, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+
+    reports = {}
+    outputs = {}
+    for mode in ["threads", "isolate"]:
+        output_dir = tmp_path / mode
+        extra = ["--isolate"] if mode == "isolate" else []
+        result = subprocess.run(
+            [binary_path, os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2")]
+            + HEADERS + ["-r", "json", "--jobs", "2", "--output-dir", str(output_dir)] + extra,
+            cwd=tmp_path,
+            capture_output=True,
+            text=True
+        )
+        assert result.returncode == 0
+        outputs[mode] = result.stdout
+        reports[mode] = {}
+        for header in HEADERS:
+            with open(output_dir / "armor_reports" / "json_reports" / f"api_diff_report_{header}.json", 'r') as f:
+                reports[mode][header] = json.load(f)
+
+    # Same reports, and the console reads as a serial run in both modes
+    assert reports["isolate"] == reports["threads"]
+    assert outputs["isolate"].replace(str(tmp_path / "isolate"), "") == \
+        outputs["threads"].replace(str(tmp_path / "threads"), "")
+    assert outputs["isolate"].index("timer.h") < outputs["isolate"].index("uart.h")
+
+
+def test_hung_worker_is_killed_at_the_deadline(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    roots = []
+    for version in ["v1", "v2"]:
+        root = tmp_path / version
+        shutil.copytree(os.path.join(test_dir, version), root)
+        # Opening a FIFO that nobody writes to blocks the worker that includes it
+        os.mkfifo(root / "stall.fifo")
+        (root / "stall.h").write_text('#include "stall.fifo"\nint stall_%s(void);\n' % version)
+        roots.append(root)
+
+    result = run_armor(*roots, "timer.h", "stall.h", "uart.h", "--isolate", "--isolate-timeout", "2",
+                       "--jobs", "2", output_dir=tmp_path / "out", timeout=120)
+
+    assert "Worker timed out after 2 seconds while comparing" in result.stderr
+    assert "stall.h" in result.stderr
+    # The other headers are compared as usual
+    for header in ["timer.h", "uart.h"]:
+        assert load_report(tmp_path / "out", header)
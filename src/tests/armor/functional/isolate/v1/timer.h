@@ -0,0 +1,8 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+struct Timer {
+    int period;
+};
+
+void timer_start(struct Timer* timer);
@@ -0,0 +1,9 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+struct Timer {
+    int period;
+    int repeat;
+};
+
+void timer_start(struct Timer* timer);
@@ -0,0 +1,49 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+import subprocess
+
+
+def test_manifest_batch(binary_path, request):
+
+    test_dir = os.path.dirname(request.fspath)
+
+    subprocess.run(
+        [binary_path, os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2"),
+         "--manifest", os.path.join(test_dir, "manifest.ndjson"), "-r", "json"],
+        cwd=test_dir,
+        capture_output=True,
+        text=True
+    )
+
+    with open(f'{test_dir}/armor_reports/manifest_status.json', 'r') as f:
+        status = json.load(f)
+
+    assert status["status"] == "success"
+    assert [(h["header"], h["result"]) for h in status["headers"]] == [
+        ("feature.h", "compared"),
+        ("same.h", "unchanged"),
+    ]
+
+    # extra_feature only exists when the entry's macro flag reaches the parser
+    with open(os.path.join(test_dir, status["headers"][0]["json_report"]), 'r') as f:
+        report = json.load(f)
+
+    assert any("extra_feature" in row.get("name", "") for row in report)
+
+
+def test_unwritable_manifest_status_fails_the_run(run_armor, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    # A regular file stands where the status file's directory should be
+    blocker = tmp_path / "blocker"
+    blocker.write_text("")
+
+    result = run_armor(os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2"),
+                       "--manifest", os.path.join(test_dir, "manifest.ndjson"),
+                       "--manifest-status", blocker / "manifest_status.json", output_dir=tmp_path / "out")
+
+    assert result.returncode != 0
+    assert "Failed to write manifest status" in result.stderr + result.stdout
@@ -0,0 +1,8 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+int base_feature(int value);
+
+#ifdef ENABLE_EXTRA
+int extra_feature(int value);
+#endif
@@ -0,0 +1,37 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+import subprocess
+
+HEADERS = ["net/types.h", "gfx/types.h"]
+
+
+def test_same_basename_reports_do_not_collide(binary_path, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    output_dir = tmp_path / "out"
+
+    subprocess.run(
+        [binary_path, os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2")]
+        + HEADERS + ["-r", "json", "--jobs", "2", "--output-dir", str(output_dir)],
+        check=True,
+        cwd=tmp_path,
+        capture_output=True,
+        text=True
+    )
+
+    reports = {}
+    for header in HEADERS:
+        name = header.replace("/", "%2F")
+        assert (output_dir / "armor_reports" / "html_reports" / f"api_diff_report_{name}.html").is_file()
+        with open(output_dir / "armor_reports" / "json_reports" / f"api_diff_report_{name}.json", 'r') as f:
+            reports[header] = json.dumps(json.load(f))
+
+    assert "Packet" in reports["net/types.h"]
+    assert "draw" in reports["gfx/types.h"]
+
+    # Nothing is written next to the output directory
+    assert sorted(os.listdir(tmp_path)) == ["out"]
+    assert not list((output_dir / "armor_reports").rglob("*.tmp"))
@@ -0,0 +1,32 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+from deepdiff import DeepDiff
+
+HEADERS = ["colors.h", "diag.h"]
+
+
+def test_parallel_matches_serial(run_armor, request):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    serial = run_armor(old_root, new_root, *HEADERS, "--dump-ast-diff", "--jobs", "1",
+                       cwd=test_dir, log_level=None, check=True)
+    parallel = run_armor(old_root, new_root, *HEADERS, "--dump-ast-diff", "--jobs", "2",
+                         cwd=test_dir, log_level=None, check=True)
+
+    assert parallel.stdout == serial.stdout
+
+    for header in HEADERS:
+        with open(f'{test_dir}/expected_output_{header}.json', 'r') as f:
+            expected_json = json.load(f)
+
+        with open(f'{test_dir}/debug_output/ast_diffs/ast_diff_output_{header}.json', 'r') as f:
+            actual_json = json.load(f)
+
+        diff = DeepDiff(expected_json, actual_json, ignore_order=True)
+
+        assert diff == {}
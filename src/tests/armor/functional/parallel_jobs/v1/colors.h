@@ -0,0 +1,19 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+enum Color {
+    A,
+    B
+};
+
+enum Color1 {
+    E,
+    F,
+    G
+};
+
+enum Color2 {
+    H,
+    I,
+    J
+};
@@ -0,0 +1,22 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+// Add
+enum Color {
+    A,
+    B,
+    C
+};
+
+// Remove
+enum Color1 {
+    E,
+    F
+};
+
+// Change Order
+enum Color2 {
+    H,
+    I,
+    J
+};
\ No newline at end of file
@@ -0,0 +1,61 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import shutil
+
+HEADER = "include/motor.h"
+
+
+def test_prelude_pch_built_then_reused(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    prelude = ["--prelude-auto", "--prelude", "include/common.h"]
+
+    plain = run_armor(old_root, new_root, HEADER, output_dir=tmp_path / "plain")
+    first = run_armor(old_root, new_root, HEADER, *prelude, output_dir=tmp_path / "first")
+    second = run_armor(old_root, new_root, HEADER, *prelude, output_dir=tmp_path / "second")
+
+    assert plain.returncode == 0
+    assert first.returncode == 0
+    assert second.returncode == 0
+
+    # One PCH per project root, built by the first run and reused by the second
+    first_log = read_log(tmp_path / "first")
+    second_log = read_log(tmp_path / "second")
+    assert "Prelude header detected: <stdint.h>" in first_log
+    # Only an include guard does not make an include conditional
+    assert "Prelude header detected: <windows.h>" not in first_log
+    assert first_log.count("Built precompiled prelude") == 2
+    assert second_log.count("Reusing precompiled prelude") == 2
+    assert "Built precompiled prelude" not in second_log
+
+    # Loading the prelude from a PCH changes nothing in the reports
+    assert load_report(tmp_path / "first", HEADER) == load_report(tmp_path / "plain", HEADER)
+    assert load_report(tmp_path / "second", HEADER) == load_report(tmp_path / "plain", HEADER)
+
+
+def test_prelude_rebuilt_when_an_input_changes(run_armor, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    # A copy of the older tree whose prelude header is edited between the runs
+    old_root = tmp_path / "v1"
+    shutil.copytree(os.path.join(test_dir, "v1"), old_root)
+
+    new_root = os.path.join(test_dir, "v2")
+    prelude = ["--prelude", "include/common.h"]
+
+    assert run_armor(old_root, new_root, HEADER, *prelude, output_dir=tmp_path / "first").returncode == 0
+    with open(old_root / "include" / "common.h", 'a') as f:
+        f.write("\ntypedef int32_t motor_speed_t;\n")
+    result = run_armor(old_root, new_root, HEADER, *prelude, output_dir=tmp_path / "second")
+
+    assert result.returncode == 0
+    log = read_log(tmp_path / "second")
+    # Only the side whose prelude changed is compiled again
+    assert log.count("Built precompiled prelude") == 1
+    assert log.count("Reusing precompiled prelude") == 1
+    # The PCH built before the edit is kept for processes that may still load it
+    assert len(list((tmp_path / "cache" / "armor" / "pch").glob("*.pch"))) == 3
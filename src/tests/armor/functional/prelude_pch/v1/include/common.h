@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef COMMON_H
+#define COMMON_H
+
+#include <stdint.h>
+
+typedef uint32_t motor_id_t;
+
+#endif
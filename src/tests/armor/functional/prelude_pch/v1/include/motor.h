@@ -0,0 +1,22 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef MOTOR_H
+#define MOTOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "common.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#endif
+
+struct Motor {
+    motor_id_t id;
+    int32_t speed;
+};
+
+int motor_start(struct Motor* motor);
+
+#endif
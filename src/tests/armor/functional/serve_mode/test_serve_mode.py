@@ -0,0 +1,155 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+import re
+import subprocess
+import time
+
+
+def wait_for_socket(path, server):
+    for _ in range(100):
+        if os.path.exists(path) or server.poll() is not None:
+            return
+        time.sleep(0.1)
+
+
+def test_serve_reuses_base_trees(binary_path, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    socket_path = str(tmp_path / "armor.sock")
+
+    server = subprocess.Popen(
+        [binary_path, "--serve", socket_path, "--output-dir", str(tmp_path / "daemon")],
+        cwd=tmp_path,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True
+    )
+    try:
+        wait_for_socket(socket_path, server)
+
+        # Two newer versions against the same older one, as for two pull requests
+        for head in ["v2", "v3"]:
+            result = subprocess.run(
+                [binary_path, os.path.join(test_dir, "v1"), os.path.join(test_dir, head), "shapes.h",
+                 "-r", "json", "--log-level", "INFO", "--connect", socket_path,
+                 "--output-dir", str(tmp_path / head)],
+                cwd=tmp_path,
+                capture_output=True,
+                text=True
+            )
+            assert result.returncode == 0
+            assert "Processing files:" in result.stdout
+
+        with open(tmp_path / "v2" / "armor_reports" / "json_reports" / "api_diff_report_shapes.h.json", 'r') as f:
+            assert "depth" in json.dumps(json.load(f))
+        with open(tmp_path / "v3" / "armor_reports" / "json_reports" / "api_diff_report_shapes.h.json", 'r') as f:
+            assert "long" in json.dumps(json.load(f))
+
+        # The second request took the older header's trees from the daemon's cache
+        with open(tmp_path / "v3" / "debug_output" / "logs" / "diagnostics.log", 'r') as f:
+            assert "Reusing cached trees of" in f.read()
+
+        subprocess.run([binary_path, "--connect", socket_path, "--stop-server"],
+                       check=True, cwd=tmp_path, capture_output=True, text=True)
+        assert server.wait(timeout=30) == 0
+        assert not os.path.exists(socket_path)
+    finally:
+        if server.poll() is None:
+            server.kill()
+            server.wait()
+
+
+def test_cached_base_pool_does_not_grow(binary_path, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    socket_path = str(tmp_path / "armor.sock")
+
+    server = subprocess.Popen(
+        [binary_path, "--serve", socket_path, "--output-dir", str(tmp_path / "daemon")],
+        cwd=tmp_path,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True
+    )
+    try:
+        wait_for_socket(socket_path, server)
+
+        # The same older header against newer ones that each bring strings of their own
+        pool_sizes = []
+        for head in ["v2", "v3", "v4"]:
+            result = subprocess.run(
+                [binary_path, os.path.join(test_dir, "v1"), os.path.join(test_dir, head), "shapes.h",
+                 "-r", "json", "--log-level", "INFO", "--connect", socket_path,
+                 "--output-dir", str(tmp_path / head)],
+                cwd=tmp_path,
+                capture_output=True,
+                text=True
+            )
+            assert result.returncode == 0
+
+            with open(tmp_path / head / "debug_output" / "logs" / "diagnostics.log", 'r') as f:
+                sizes = re.findall(r"Cached string pool size: (\d+)", f.read())
+            pool_sizes += [int(size) for size in sizes]
+
+        # v2 filled the cache, v3 and v4 reused it without adding to its pool
+        assert len(pool_sizes) == 2
+        assert pool_sizes[0] == pool_sizes[1]
+
+        subprocess.run([binary_path, "--connect", socket_path, "--stop-server"],
+                       check=True, cwd=tmp_path, capture_output=True, text=True)
+        assert server.wait(timeout=30) == 0
+    finally:
+        if server.poll() is None:
+            server.kill()
+            server.wait()
+
+
+def test_base_include_edit_invalidates_cached_trees(binary_path, request, tmp_path):
+
+    socket_path = str(tmp_path / "armor.sock")
+    # An older tree whose header includes another, edited between requests
+    for tree, extra in [("base", ""), ("head", "    length_t depth;\n")]:
+        (tmp_path / tree).mkdir()
+        (tmp_path / tree / "units.h").write_text("typedef int length_t;\n")
+        (tmp_path / tree / "box.h").write_text(
+            '#include "units.h"\n\nstruct Box {\n    length_t width;\n' + extra + '};\n')
+
+    server = subprocess.Popen(
+        [binary_path, "--serve", socket_path, "--output-dir", str(tmp_path / "daemon")],
+        cwd=tmp_path,
+        stdout=subprocess.PIPE,
+        stderr=subprocess.PIPE,
+        text=True
+    )
+    try:
+        wait_for_socket(socket_path, server)
+
+        def compare(name):
+            result = subprocess.run(
+                [binary_path, str(tmp_path / "base"), str(tmp_path / "head"), "box.h",
+                 "-r", "json", "--log-level", "INFO", "--connect", socket_path,
+                 "--output-dir", str(tmp_path / name)],
+                cwd=tmp_path,
+                capture_output=True,
+                text=True
+            )
+            assert result.returncode == 0
+            with open(tmp_path / name / "debug_output" / "logs" / "diagnostics.log", 'r') as f:
+                return f.read()
+
+        compare("first")
+        assert "Reusing cached trees of" in compare("unchanged")
+        (tmp_path / "base" / "units.h").write_text("typedef long length_t;\n")
+        assert "Reusing cached trees of" not in compare("edited")
+        assert "Reusing cached trees of" in compare("edited_again")
+
+        subprocess.run([binary_path, "--connect", socket_path, "--stop-server"],
+                       check=True, cwd=tmp_path, capture_output=True, text=True)
+        assert server.wait(timeout=30) == 0
+    finally:
+        if server.poll() is None:
+            server.kill()
+            server.wait()
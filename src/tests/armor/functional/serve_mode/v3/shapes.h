@@ -0,0 +1,9 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+struct Shape {
+    int width;
+    int height;
+};
+
+long area(const struct Shape* shape);
@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+struct Shape {
+    int width;
+    int height;
+    unsigned char outlineColor;
+};
+
+int area(const struct Shape* shape);
+double perimeter(const struct Shape* shape, double scale);
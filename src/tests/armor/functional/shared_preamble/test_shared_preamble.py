@@ -0,0 +1,58 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+
+
+def find(rows, name):
+    return [row for row in rows if name in row.get("name", "")]
+
+
+def test_identical_includes_share_the_preamble(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    result = run_armor(old_root, new_root, "include/motor.h", output_dir=tmp_path)
+
+    assert result.returncode == 0
+    assert "Sharing the preamble of" in read_log(tmp_path)
+    # Only the new field shows up; everything from the shared includes is unchanged
+    report = load_report(tmp_path, "include/motor.h")
+    assert find(report, "torque")
+    assert not find(report, "rpm")
+
+
+def test_changed_includes_are_parsed_again(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    result = run_armor(old_root, new_root, "include/sensor.h", output_dir=tmp_path)
+
+    assert result.returncode == 0
+    log = read_log(tmp_path)
+    assert "Sharing the preamble of" not in log
+    assert "parsing it in full" in log
+    # The newer header sees its own sensor_limits.h
+    report = load_report(tmp_path, "include/sensor.h")
+    assert find(report, "channels")
+    assert find(report, "sensor_reset")
+
+
+def test_shadowed_includes_are_parsed_again(run_armor, load_report, read_log, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    # Only the newer tree has override/gauge_limits.h, searched before include/
+    result = run_armor(old_root, new_root, "include/gauge.h", "-I", "override", output_dir=tmp_path)
+
+    assert result.returncode == 0
+    log = read_log(tmp_path)
+    assert "Sharing the preamble of" not in log
+    assert "shadows" in log
+    # The newer header sees the overriding channel count
+    report = load_report(tmp_path, "include/gauge.h")
+    assert find(report, "levels")
+    assert find(report, "gauge_reset")
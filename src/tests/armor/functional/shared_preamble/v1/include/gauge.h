@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include <gauge_limits.h>
+
+struct Gauge {
+    int id;
+    int levels[GAUGE_CHANNELS];
+};
+
+int gauge_read(struct Gauge* gauge);
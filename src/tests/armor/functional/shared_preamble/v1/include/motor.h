@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "motor_limits.h"
+
+struct Motor {
+    int id;
+    int rpm[MOTOR_COUNT];
+};
+
+int motor_start(struct Motor* motor);
@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#include "sensor_limits.h"
+
+struct Sensor {
+    int id;
+    int channels[SENSOR_CHANNELS];
+};
+
+int sensor_read(struct Sensor* sensor);
@@ -0,0 +1,22 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+
+HEADER = "counter.h"
+
+
+def test_skipped_bodies_give_the_same_report(run_armor, load_report, request, tmp_path):
+
+    test_dir = os.path.dirname(request.fspath)
+    old_root = os.path.join(test_dir, "v1")
+    new_root = os.path.join(test_dir, "v2")
+    full = run_armor(old_root, new_root, HEADER, output_dir=tmp_path / "full")
+    skipped = run_armor(old_root, new_root, HEADER, "--skip-function-bodies", output_dir=tmp_path / "skipped")
+
+    assert full.returncode == 0
+    assert skipped.returncode == 0
+    report = load_report(tmp_path / "skipped", HEADER)
+    assert report == load_report(tmp_path / "full", HEADER)
+    # Signature changes are still seen without the bodies
+    assert any("reset" in row.get("name", "") for row in report)
@@ -0,0 +1,27 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+// Kept when bodies are skipped: used in a constant expression below
+constexpr int bufferSize(int slots) { return slots * 4; }
+
+class Counter {
+public:
+    long count() const { return m_count; }
+    void add(int value) {
+        for (int i = 0; i < value; ++i) {
+            ++m_count;
+        }
+    }
+    auto twice() const { return m_count * 2; }
+    void reset() { m_count = 0; }
+private:
+    int m_count = 0;
+    char m_buffer[bufferSize(2)];
+};
+
+template <typename T>
+T clampTo(T value, T low, T high) {
+    return value < low ? low : value > high ? high : value;
+}
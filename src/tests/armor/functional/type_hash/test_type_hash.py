@@ -0,0 +1,32 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+import subprocess
+
+
+def modified_names(entries):
+    names = set()
+    for entry in entries:
+        if entry.get("tag") in ("added", "removed"):
+            names.add(entry["qualifiedName"])
+        names |= modified_names(entry.get("children", []))
+    return names
+
+
+def test_only_changed_types_are_reported(binary_path, binary_args, request):
+
+    test_dir = os.path.dirname(request.fspath)
+
+    subprocess.run(
+        [binary_path] + binary_args,
+        check=True,
+        cwd=test_dir
+    )
+
+    with open(f'{test_dir}/debug_output/ast_diffs/ast_diff_output_mylib.h.json', 'r') as f:
+        actual_json = json.load(f)
+
+    # Respelling a type through a typedef is not a change; new template arguments are
+    assert modified_names(actual_json) == {"history::(ReturnType)"}
@@ -0,0 +1,33 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef MYLIB_H
+#define MYLIB_H
+
+typedef unsigned int count_t;
+using handler_t = void (*)(int, const char*);
+
+template <typename T, int N>
+struct Ring {
+    T items[N];
+    int head;
+};
+
+namespace net {
+struct Packet {
+    unsigned int length;
+};
+}
+
+struct Queue {
+    unsigned int size;
+    Ring<int, 8> slots;
+    net::Packet last;
+    void (*onDrain)(int, const char*);
+};
+
+unsigned int queueSize(const Queue* queue);
+Ring<long, 4>* history(int depth);
+void setHandler(handler_t handler);
+
+#endif
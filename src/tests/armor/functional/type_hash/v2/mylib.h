@@ -0,0 +1,35 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef MYLIB_H
+#define MYLIB_H
+
+typedef unsigned int count_t;
+using handler_t = void (*)(int, const char*);
+
+template <typename T, int N>
+struct Ring {
+    T items[N];
+    int head;
+};
+
+namespace net {
+struct Packet {
+    unsigned int length;
+};
+}
+
+// Spelled through typedefs, but the same types as before
+struct Queue {
+    count_t size;
+    Ring<int, 8> slots;
+    net::Packet last;
+    void (*onDrain)(int, const char*);
+};
+
+count_t queueSize(const Queue* queue);
+// The template arguments change
+Ring<long, 16>* history(int depth);
+void setHandler(handler_t handler);
+
+#endif
@@ -0,0 +1,24 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import subprocess
+
+HEADER = "point types.h"
+
+
+def test_identical_header_is_skipped(binary_path, request):
+
+    test_dir = os.path.dirname(request.fspath)
+    file1 = os.path.join(test_dir, "v1", HEADER)
+    file2 = os.path.join(test_dir, "v2", HEADER)
+
+    result = subprocess.run(
+        [binary_path, os.path.join(test_dir, "v1"), os.path.join(test_dir, "v2"), HEADER, "-r", "json"],
+        cwd=test_dir,
+        capture_output=True,
+        text=True
+    )
+
+    assert f"No differences found between: {file1} and {file2}" in result.stdout
+    assert not os.path.exists(f"{test_dir}/armor_reports/html_reports/api_diff_report_{HEADER}.html")
@@ -0,0 +1,11 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#pragma once
+
+struct Point {
+    int x;
+    int y;
+};
+
+int distance(struct Point a, struct Point b);
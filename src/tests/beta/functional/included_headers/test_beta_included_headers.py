@@ -0,0 +1,33 @@
+# Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+# SPDX-License-Identifier: BSD-3-Clause
+
+import os
+import json
+import subprocess
+
+
+def qualified_names(entries):
+    names = set()
+    for entry in entries:
+        names.add(entry["qualifiedName"])
+        names |= qualified_names(entry.get("children", []))
+    return names
+
+
+def test_only_main_file_declarations(binary_path, binary_args, request):
+
+    test_dir = os.path.dirname(request.fspath)
+
+    subprocess.run(
+        [binary_path] + binary_args,
+        check=True,
+        cwd=test_dir
+    )
+
+    with open(f'{test_dir}/debug_output/ast_diffs/ast_diff_output_mylib.h.json', 'r') as f:
+        actual_json = json.load(f)
+
+    # mylib_types.h changed as well, but only what mylib.h itself declares is its API
+    names = qualified_names(actual_json)
+    assert {"sensor::flags", "sensor_close"} <= names
+    assert not any(name.startswith(("sensor_config", "sensor_probe", "sensor_reset")) for name in names)
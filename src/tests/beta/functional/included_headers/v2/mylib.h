@@ -0,0 +1,18 @@
+// Copyright (c) Qualcomm Technologies, Inc. and/or its subsidiaries.
+// SPDX-License-Identifier: BSD-3-Clause
+
+#ifndef MYLIB_H
+#define MYLIB_H
+
+#include "mylib_types.h"
+
+struct sensor {
+    const struct sensor_config* config;
+    int id;
+    int flags;
+};
+
+int sensor_open(struct sensor* sensor);
+int sensor_close(struct sensor* sensor);
+
+#endif
@@ -8,6 +8,8 @@
 #include "CLI/CLI.hpp"
 #include "llvm/Support/raw_ostream.h"
 #include "options_handler.hpp"
+#include "armor_context.hpp"
+#include "file_digest.hpp"
 #include "beta/include/header_processor.hpp"
 #include "user_print.hpp"
 
@@ -15,11 +17,6 @@
 #define TOOL_VERSION ""
 #endif
 
-bool filesAreDifferentUsingDiff(const std::string &file1, const std::string &file2) {
-    std::string command = "diff -q " + file1 + " " + file2 + " > /dev/null";
-    return std::system(command.c_str()) != 0;
-}
-
 bool runArmorTool(int argc, const char **argv) {
     CLI::App app{"ARMOR"};
     std::string projectRoot1;
@@ -69,6 +66,9 @@ bool runArmorTool(int argc, const char **argv) {
     app.add_option("-m,--macro-flags", macroFlags,
         "Macro flags to be passed for headers.\n");
     CLI11_PARSE(app, argc, argv);
+    ArmorContext context;
+    ScopedDebugConfig debugScope(context.debug());
+    context.openDiagnosticsLog();
     std::istringstream iss(macroFlags);
     std::string flag;
     while (iss >> flag) {
@@ -76,20 +76,21 @@ bool runArmorTool(int argc, const char **argv) {
     }
     // Set level and announce (now goes to the file)
     if (debugLevel == "DEBUG") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::DEBUG);
-        DebugConfig::instance().log("Debug level set to DEBUG", DebugConfig::Level::INFO);
+        context.debug().setLevel(DebugConfig::Level::DEBUG);
+        context.debug().log("Debug level set to DEBUG", DebugConfig::Level::INFO);
     } else if (debugLevel == "INFO") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::INFO);
-        DebugConfig::instance().log("Debug level set to INFO", DebugConfig::Level::INFO);
+        context.debug().setLevel(DebugConfig::Level::INFO);
+        context.debug().log("Debug level set to INFO", DebugConfig::Level::INFO);
     } else if (debugLevel == "LOG") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::LOG);
-        DebugConfig::instance().log("Debug level set to LOG", DebugConfig::Level::INFO);
+        context.debug().setLevel(DebugConfig::Level::LOG);
+        context.debug().log("Debug level set to LOG", DebugConfig::Level::INFO);
     } else if (debugLevel == "ERROR") {
-        DebugConfig::instance().setLevel(DebugConfig::Level::ERROR);
-        DebugConfig::instance().log("Debug level set to ERROR", DebugConfig::Level::INFO);
+        context.debug().setLevel(DebugConfig::Level::ERROR);
+        context.debug().log("Debug level set to ERROR", DebugConfig::Level::INFO);
     }
 
     bool processed = false;
+    FileDigestCache fileDigests;
     std::vector<std::string> headersToCompare;
     if (!headers.empty()) {
         for (const auto &header : headers) {
@@ -106,8 +107,8 @@ bool runArmorTool(int argc, const char **argv) {
                 USER_ERROR(std::string("Missing header in older version: ") + file1);
             } else if (!std::filesystem::exists(file2)) {
                 USER_ERROR(std::string("Missing header in newer version: ") + file2);
-            } else if (filesAreDifferentUsingDiff(file1, file2)) {
-                processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
+            } else if (fileDigests.filesDiffer(file1, file2)) {
+                processHeaderPairBeta(context, projectRoot1, file1, projectRoot2, file2, reportFormat,
                                 IncludePaths, macros);
                 processed = true;
             } else {
@@ -135,8 +136,8 @@ bool runArmorTool(int argc, const char **argv) {
                 USER_ERROR(std::string("Missing header in older version: ") + file1);
             } else if (!std::filesystem::exists(file2)) {
                 USER_ERROR(std::string("Missing header in newer version: ") + file2);
-            } else if (filesAreDifferentUsingDiff(file1, file2)) {
-                processHeaderPairBeta(projectRoot1, file1, projectRoot2, file2, reportFormat,
+            } else if (fileDigests.filesDiffer(file1, file2)) {
+                processHeaderPairBeta(context, projectRoot1, file1, projectRoot2, file2, reportFormat,
                                 IncludePaths, macros);
                 processed = true;
             } else {